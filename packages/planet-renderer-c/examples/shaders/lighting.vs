@@ -1,18 +1,115 @@
 #version 330
 
-in vec3 vertexPosition;
-in vec3 vertexNormal;
+// Packed chunk vertex (see ChunkVertex in chunk.h): position is unorm16
+// relative to the chunk bounds with the morph offset in w, normal is
+// octahedral snorm16
+in vec4 vertexPosition;
+in vec2 vertexNormal;
+// Instanced chunks (see chunk_batch.h) have no vertex data: the grid comes
+// from gl_VertexID, the instance and the height atlas
+in vec4 instanceCorner;
+in vec4 instanceAxisU;
+in vec4 instanceAxisV;
+in vec4 instanceLod;
 uniform mat4 mvp;
 uniform mat4 matModel;
 uniform mat4 matNormal;
 uniform mat4 lightSpaceMatrix;
+uniform vec3 chunkOrigin;
+uniform vec3 chunkExtent;
+uniform int chunkResolution;
+uniform int chunkFirstVertex;
+uniform int chunkInstanced;
+uniform sampler2D heightAtlas;
+uniform float planetRadius;
+uniform vec3 planetOrigin;
+uniform vec3 lodCamera;
+uniform float lodMorphStart;
+uniform float chunkMorphEnd;
 out vec3 fragNormal;
 out vec3 fragPosition;
 out vec4 fragPosLightSpace;
+out vec2 fragTexCoord;
+
+vec3 DecodeOctNormal(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+// Geomorph weight of a vertex of a chunk whose morph ends at the given
+// camera distance: 0 keeps the chunk's own detail, 1 matches the parent mesh
+float MorphWeight(vec3 position, float morphEnd) {
+    if (lodMorphStart >= 1.0) return 0.0;
+    vec3 sphere = planetOrigin + normalize(position - planetOrigin) * planetRadius;
+    float d = distance(sphere, lodCamera) / morphEnd;
+    return clamp((d - lodMorphStart) / (1.0 - lodMorphStart), 0.0, 1.0);
+}
+
+// Padded grid sample (x, y), x and y from -1 to resolution + 1, relative
+// to the planet center
+vec3 GridPoint(int x, int y) {
+    vec3 plane = instanceCorner.xyz + (instanceAxisU.xyz * float(x) + instanceAxisV.xyz * float(y)) / float(chunkResolution);
+    float h = texelFetch(heightAtlas, ivec2(instanceCorner.w, instanceAxisU.w) + ivec2(x + 1, y + 1), 0).r;
+    return normalize(plane) * (planetRadius + h);
+}
+
+// Same vertex as the CPU mesh: grid row-major, then the skirt ring (one run
+// per edge: x = 0, x = res, y = 0, y = res), normals by central differences
+void InstancedVertex(out vec3 position, out vec3 normal) {
+    int stride = chunkResolution + 1;
+    int x = gl_VertexID % stride;
+    int y = gl_VertexID / stride;
+    bool skirt = y > chunkResolution;
+    if (skirt) {
+        int edge = (gl_VertexID - stride * stride) / stride;
+        int t = (gl_VertexID - stride * stride) % stride;
+        x = edge == 0 ? 0 : (edge == 1 ? chunkResolution : t);
+        y = edge == 2 ? 0 : (edge == 3 ? chunkResolution : t);
+    }
+
+    vec3 center = GridPoint(x, y);
+    vec3 left = GridPoint(x - 1, y);
+    vec3 right = GridPoint(x + 1, y);
+    vec3 down = GridPoint(x, y - 1);
+    vec3 up = GridPoint(x, y + 1);
+    normal = normalize(cross(right - left, up - down));
+
+    // Odd vertices move toward the parent's triangle edge they lie on
+    bool oddX = (x & 1) != 0;
+    bool oddY = (y & 1) != 0;
+    if ((chunkResolution & 1) == 0 && (oddX || oddY)) {
+        float weight = MorphWeight(center + planetOrigin, instanceLod.x);
+        if (weight > 0.0) {
+            vec3 parent = !oddY ? left + right : (!oddX ? down + up : GridPoint(x + 1, y - 1) + GridPoint(x - 1, y + 1));
+            center = normalize(center) * mix(length(center), 0.5 * length(parent), weight);
+        }
+    }
+    if (skirt) center -= normalize(center) * instanceAxisV.w;
+    position = center + planetOrigin;
+}
 
 void main() {
-    fragNormal = normalize(vec3(matNormal * vec4(vertexNormal, 0.0)));
-    fragPosition = vec3(matModel * vec4(vertexPosition, 1.0));
-    fragPosLightSpace = lightSpaceMatrix * matModel * vec4(vertexPosition, 1.0);
-    gl_Position = mvp * vec4(vertexPosition, 1.0);
+    vec3 position;
+    vec3 normal;
+    if (chunkInstanced != 0) {
+        InstancedVertex(position, normal);
+    } else {
+        position = chunkOrigin + vertexPosition.xyz * chunkExtent;
+        normal = DecodeOctNormal(vertexNormal);
+        float offset = (vertexPosition.w * 2.0 - 1.0) * length(chunkExtent);
+        position -= normalize(position - planetOrigin) * offset * MorphWeight(position, chunkMorphEnd);
+    }
+
+    // Grid texcoords from the vertex index, row-major (resolution + 1)^2
+    // (skirt vertices after the grid get v > 1)
+    int vertexId = gl_VertexID + chunkFirstVertex;
+    fragTexCoord = vec2(vertexId % (chunkResolution + 1), vertexId / (chunkResolution + 1)) / float(chunkResolution);
+
+    fragNormal = normalize(vec3(matNormal * vec4(normal, 0.0)));
+    fragPosition = vec3(matModel * vec4(position, 1.0));
+    fragPosLightSpace = lightSpaceMatrix * matModel * vec4(position, 1.0);
+    gl_Position = mvp * vec4(position, 1.0);
 }
@@ -1,9 +1,81 @@
 #version 330
 
-in vec3 vertexPosition;
+// Packed chunk vertex position, unorm16 relative to the chunk bounds, and
+// morph offset (see lighting.vs)
+in vec4 vertexPosition;
+// Instanced chunks, see lighting.vs
+in vec4 instanceCorner;
+in vec4 instanceAxisU;
+in vec4 instanceAxisV;
+in vec4 instanceLod;
 uniform mat4 lightSpaceMatrix;
 uniform mat4 matModel;
+uniform vec3 chunkOrigin;
+uniform vec3 chunkExtent;
+uniform int chunkResolution;
+uniform int chunkInstanced;
+uniform sampler2D heightAtlas;
+uniform float planetRadius;
+uniform vec3 planetOrigin;
+uniform vec3 lodCamera;
+uniform float lodMorphStart;
+uniform float chunkMorphEnd;
+
+float MorphWeight(vec3 position, float morphEnd) {
+    if (lodMorphStart >= 1.0) return 0.0;
+    vec3 sphere = planetOrigin + normalize(position - planetOrigin) * planetRadius;
+    float d = distance(sphere, lodCamera) / morphEnd;
+    return clamp((d - lodMorphStart) / (1.0 - lodMorphStart), 0.0, 1.0);
+}
+
+float SampleRadius(int x, int y) {
+    return planetRadius + texelFetch(heightAtlas, ivec2(instanceCorner.w, instanceAxisU.w) + ivec2(x + 1, y + 1), 0).r;
+}
+
+vec3 GridDirection(int x, int y) {
+    return normalize(instanceCorner.xyz + (instanceAxisU.xyz * float(x) + instanceAxisV.xyz * float(y)) / float(chunkResolution));
+}
+
+// Position only: no normal, so one atlas fetch per vertex, three where it
+// morphs
+vec3 InstancedPosition() {
+    int stride = chunkResolution + 1;
+    int x = gl_VertexID % stride;
+    int y = gl_VertexID / stride;
+    bool skirt = y > chunkResolution;
+    if (skirt) {
+        int edge = (gl_VertexID - stride * stride) / stride;
+        int t = (gl_VertexID - stride * stride) % stride;
+        x = edge == 0 ? 0 : (edge == 1 ? chunkResolution : t);
+        y = edge == 2 ? 0 : (edge == 3 ? chunkResolution : t);
+    }
+
+    vec3 direction = GridDirection(x, y);
+    float radius = SampleRadius(x, y);
+
+    // Odd vertices move toward the parent's triangle edge, as in lighting.vs
+    bool oddX = (x & 1) != 0;
+    bool oddY = (y & 1) != 0;
+    if ((chunkResolution & 1) == 0 && (oddX || oddY)) {
+        float weight = MorphWeight(direction * radius + planetOrigin, instanceLod.x);
+        if (weight > 0.0) {
+            ivec2 a = !oddY ? ivec2(x - 1, y) : (!oddX ? ivec2(x, y - 1) : ivec2(x + 1, y - 1));
+            ivec2 b = !oddY ? ivec2(x + 1, y) : (!oddX ? ivec2(x, y + 1) : ivec2(x - 1, y + 1));
+            vec3 parent = GridDirection(a.x, a.y) * SampleRadius(a.x, a.y) + GridDirection(b.x, b.y) * SampleRadius(b.x, b.y);
+            radius = mix(radius, 0.5 * length(parent), weight);
+        }
+    }
+    return direction * (radius - (skirt ? instanceAxisV.w : 0.0)) + planetOrigin;
+}
 
 void main() {
-    gl_Position = lightSpaceMatrix * matModel * vec4(vertexPosition, 1.0);
+    vec3 position;
+    if (chunkInstanced != 0) {
+        position = InstancedPosition();
+    } else {
+        position = chunkOrigin + vertexPosition.xyz * chunkExtent;
+        float offset = (vertexPosition.w * 2.0 - 1.0) * length(chunkExtent);
+        position -= normalize(position - planetOrigin) * offset * MorphWeight(position, chunkMorphEnd);
+    }
+    gl_Position = lightSpaceMatrix * matModel * vec4(position, 1.0);
 }
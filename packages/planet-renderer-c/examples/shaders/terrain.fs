@@ -0,0 +1,157 @@
+#version 330
+
+// Terrain pass: one fragment per padded height sample of a chunk's atlas
+// slot, written as displacement in meters. A port of MoonTerrain in
+// src/noise.c, keep the two in step: CPU height queries and CPU-built chunks
+// still use the C version.
+
+uniform ivec2 terrainSlotOrigin;
+uniform vec2 terrainOffset;
+uniform vec2 terrainStep;
+uniform float terrainRadius;
+uniform float terrainNoiseScale;
+uniform float terrainAmplitude;
+
+out vec4 finalColor;
+
+uint Hash(uint x) {
+    x += (x << 10u);
+    x ^= (x >> 6u);
+    x += (x << 3u);
+    x ^= (x >> 11u);
+    x += (x << 15u);
+    return x;
+}
+
+uint Hash2D(int x, int y) {
+    return Hash(uint(x) ^ Hash(uint(y)));
+}
+
+float SmoothCurve(float t) {
+    return t * t * (3.0 - 2.0 * t);
+}
+
+// a + (b - a) * t like the C lerp, mix() rounds differently
+float Lerp(float a, float b, float t) {
+    return a + (b - a) * t;
+}
+
+float RandomValue(int x, int y) {
+    return float(Hash2D(x, y) & 0xFFFFu) / 65535.0 * 2.0 - 1.0;
+}
+
+float RandomValue01(int x, int y) {
+    return float(Hash2D(x, y) & 0xFFFFu) / 65535.0;
+}
+
+float Noise2D(vec2 p) {
+    ivec2 i0 = ivec2(floor(p));
+    vec2 f = p - vec2(i0);
+    float sx = SmoothCurve(f.x);
+    float sy = SmoothCurve(f.y);
+
+    float v00 = RandomValue(i0.x, i0.y);
+    float v10 = RandomValue(i0.x + 1, i0.y);
+    float v01 = RandomValue(i0.x, i0.y + 1);
+    float v11 = RandomValue(i0.x + 1, i0.y + 1);
+    return Lerp(Lerp(v00, v10, sx), Lerp(v01, v11, sx), sy);
+}
+
+float FBM(vec2 p, int octaves, float persistence, float lacunarity) {
+    float total = 0.0;
+    float amplitude = 1.0;
+    float frequency = 1.0;
+    float maxValue = 0.0;
+    for (int i = 0; i < octaves; i++) {
+        total += Noise2D(p * frequency) * amplitude;
+        maxValue += amplitude;
+        amplitude *= persistence;
+        frequency *= lacunarity;
+    }
+    return total / maxValue;
+}
+
+// Distance to the nearest cell point (MoonTerrain only uses F1)
+float WorleyF1(vec2 p) {
+    ivec2 cell = ivec2(floor(p));
+    float minDist = 10000.0;
+    for (int yOffset = -1; yOffset <= 1; yOffset++) {
+        for (int xOffset = -1; xOffset <= 1; xOffset++) {
+            int cellX = cell.x + xOffset;
+            int cellY = cell.y + yOffset;
+            vec2 point = vec2(float(cellX) + RandomValue01(cellX, cellY),
+                              float(cellY) + RandomValue01(cellX, cellY + 1000));
+            minDist = min(minDist, length(p - point));
+        }
+    }
+    return minDist;
+}
+
+// Bowl, raised rim and ejecta blanket over the normalized crater distance
+float CraterProfile(float distance) {
+    if (distance > 1.2) return 0.0;
+    if (distance < 0.95) {
+        float normalized = distance / 0.95;
+        return -pow(1.0 - normalized * normalized, 0.8);
+    }
+    if (distance < 1.05) {
+        float rimPos = (distance - 0.95) / 0.1;
+        return sin(rimPos * 3.14159) * 0.3;
+    }
+    float ejectaDist = (distance - 1.05) / 0.15;
+    return (1.0 - ejectaDist) * 0.1;
+}
+
+float CraterField(vec2 p, float scale, float intensity) {
+    float f1 = WorleyF1(p * scale);
+    ivec2 cell = ivec2(floor(p * scale));
+    float craterSize = 0.3 + RandomValue01(cell.x, cell.y) * 0.4;
+    float depthRatio = 0.5 - craterSize * 0.15;
+    return CraterProfile(f1 / craterSize) * depthRatio * intensity;
+}
+
+float WrinkleRidges(vec2 p) {
+    float n1 = abs(Noise2D(p * 0.3));
+    float n2 = abs(Noise2D(p * 0.5 + 100.0));
+    float ridges = (1.0 - n1) * 0.6 + (1.0 - n2) * 0.4;
+    return pow(ridges, 2.5) * 0.15;
+}
+
+float MariaPattern(vec2 p) {
+    float largeScale = FBM(p * 0.08, 3, 0.5, 2.0);
+    return SmoothCurve(clamp((largeScale + 0.3) / 0.6, 0.0, 1.0));
+}
+
+float MoonTerrain(vec2 p) {
+    float mariaAmount = MariaPattern(p);
+    float highlandAmount = 1.0 - mariaAmount;
+
+    float baseElevation = highlandAmount * 0.3 - mariaAmount * 0.3;
+    float largeCraters = CraterField(p, 0.15, 3.0);
+    float complexCraters = CraterField(p, 0.5, 2.0);
+    float simpleCraters = CraterField(p, 2.0, 0.8) * (0.5 + highlandAmount * 0.5);
+    float smallCraters = CraterField(p, 8.0, 0.4) * (0.3 + highlandAmount * 0.7);
+    float ridges = WrinkleRidges(p) * mariaAmount;
+    float highlandRoughness = FBM(p * 5.0, 3, 0.6, 2.0) * 0.2 * highlandAmount;
+    float mariaRoughness = FBM(p * 15.0, 2, 0.3, 2.0) * 0.02 * mariaAmount;
+    float regolith = FBM(p * 30.0, 3, 0.5, 2.0) * 0.005;
+
+    return baseElevation
+         + largeCraters * 1.0
+         + complexCraters * 0.8
+         + simpleCraters * 0.6
+         + smallCraters * 0.3
+         + ridges
+         + highlandRoughness
+         + mariaRoughness
+         + regolith;
+}
+
+void main() {
+    // Padded sample (-1..res+1), face-plane position and noise domain as in
+    // StageGridPositions
+    ivec2 grid = ivec2(gl_FragCoord.xy) - terrainSlotOrigin - 1;
+    vec2 facePosition = terrainOffset + vec2(grid) * terrainStep;
+    vec2 noisePosition = (facePosition + terrainRadius) * terrainNoiseScale;
+    finalColor = vec4(terrainAmplitude * MoonTerrain(noisePosition), 0.0, 0.0, 1.0);
+}
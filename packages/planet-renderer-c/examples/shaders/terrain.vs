@@ -0,0 +1,8 @@
+#version 330
+
+// Terrain pass (see chunk_batch.h): one triangle over the whole viewport,
+// which the renderer sets to the chunk's atlas slot
+void main() {
+    vec2 corner = vec2(float((gl_VertexID & 1) << 2), float((gl_VertexID & 2) << 1)) - 1.0;
+    gl_Position = vec4(corner, 0.0, 1.0);
+}
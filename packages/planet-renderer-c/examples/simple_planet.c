@@ -4,7 +4,6 @@
 #include <raymath.h>
 #include "rlgl.h"
 #include <stdio.h>
-#include "noise.h"
 
 
 float UpdateCameraFlight(Camera3D* camera) {
@@ -82,126 +81,12 @@ void DrawCascadeDebugOverlay(CascadedShadowMap* csm, Camera camera) {
     DrawText("CSM Debug Info:", 10, 130, 20, WHITE);
     Color colors[] = {RED, GREEN, BLUE, YELLOW};
     for (int i = 0; i < CASCADE_COUNT; i++) {
-        DrawText(TextFormat("Cascade %d: Split %.1fm", i, csm->cascades[i].splitDistance), 
+        DrawText(TextFormat("Cascade %d: Split %.1fm%s", i, csm->cascades[i].splitDistance,
+                            CSM_IsCascadeDirty(csm, i) ? " (rendered)" : ""), 
                  10, 155 + i * 25, 20, colors[i]);
     }
 }
 
-// Calculate exact terrain height at a given position
-// This duplicates the logic from Chunk_Generate to ensure the HUD matches the visual terrain
-float GetTerrainHeightAtPosition(Vector3 position, float planetRadius, float terrainFrequency, float terrainAmplitude) {
-    // 1. Normalize to get direction vector
-    Vector3 normalized = Vector3Normalize(position);
-    
-    // 2. Determine which face we are on (Cube mapping)
-    float absX = fabsf(normalized.x);
-    float absY = fabsf(normalized.y);
-    float absZ = fabsf(normalized.z);
-    
-    float maxAxis = absX;
-    if (absY > maxAxis) maxAxis = absY;
-    if (absZ > maxAxis) maxAxis = absZ;
-    
-    // 3. Project to that face to get 2D coordinates
-    // We need to match the UV mapping used in Chunk_Generate
-    float u = 0.0f;
-    float v = 0.0f;
-    
-    // Avoid division by zero
-    if (maxAxis < 0.0001f) return planetRadius;
-    
-    // Unproject to cube surface (distance from center to cube face is radius)
-    // But we need the UVs on the face.
-    // Face size is 2.0 * radius.
-    // Range on face is [-radius, radius]
-    
-    // We can just use the normalized coordinates divided by the max axis to get range [-1, 1]
-    // Then map to [0, 1]
-    
-    if (absX >= absY && absX >= absZ) {
-        // X Face
-        // X is dominant. Y and Z are the UVs.
-        // We need to be careful about orientation to match the quadtree faces
-        // But for noise sampling, as long as it's continuous, it might be "good enough" for altitude
-        // However, to be EXACT, we should match the transforms in CubicQuadTree_Create
-        
-        // Let's use a simpler approach: 3D Noise?
-        // No, MoonTerrain is 2D.
-        
-        // Let's stick to the projection logic that matches the visual terrain.
-        // In Chunk_Generate:
-        // float px = chunk->offset.x + u * chunk->width;
-        // float py = chunk->offset.y + v * chunk->height;
-        // Vector3 localPos = { px, py, 0 };
-        // Vector3 worldPos = Vector3Transform(localPos, chunk->localToWorld);
-        
-        // We need to inverse this.
-        // It's complicated because we don't know WHICH chunk we are over easily without traversing the tree.
-        
-        // ALTERNATIVE:
-        // The noise function `MoonTerrain(x, y)` takes inputs that are derived from the face coordinates.
-        // normalizedX = (px + radius) / (2*radius)
-        // noiseX = normalizedX * freq
-        
-        // So we just need px and py on the face.
-        // px/py are in range [-radius, radius]
-        
-        if (normalized.x > 0) { // +X (Right)
-            // transforms[2] = MatrixMultiply(MatrixRotateY(PI / 2), MatrixTranslate(radius, 0, 0));
-            // Local Z+ becomes World X+. Local X+ becomes World Z-. Local Y+ becomes World Y+.
-            // So World Z is -Local X. World Y is Local Y.
-            u = -normalized.z / absX;
-            v = normalized.y / absX;
-        } else { // -X (Left)
-            // transforms[3] = MatrixMultiply(MatrixRotateY(-PI / 2), MatrixTranslate(-radius, 0, 0));
-            // Local Z+ becomes World X-. Local X+ becomes World Z+. Local Y+ becomes World Y+.
-            // So World Z is Local X. World Y is Local Y.
-            u = normalized.z / absX;
-            v = normalized.y / absX;
-        }
-    } else if (absY >= absX && absY >= absZ) {
-        // Y Face
-        if (normalized.y > 0) { // +Y (Top)
-            // transforms[0] = MatrixMultiply(MatrixRotateX(-PI / 2), MatrixTranslate(0, radius, 0));
-            // Local Z+ becomes World Y+. Local Y+ becomes World Z-. Local X+ becomes World X+.
-            // So World X is Local X. World Z is -Local Y.
-            u = normalized.x / absY;
-            v = -normalized.z / absY;
-        } else { // -Y (Bottom)
-            // transforms[1] = MatrixMultiply(MatrixRotateX(PI / 2), MatrixTranslate(0, -radius, 0));
-            // Local Z+ becomes World Y-. Local Y+ becomes World Z+. Local X+ becomes World X+.
-            // So World X is Local X. World Z is Local Y.
-            u = normalized.x / absY;
-            v = normalized.z / absY;
-        }
-    } else {
-        // Z Face
-        if (normalized.z > 0) { // +Z (Front)
-            // transforms[4] = MatrixTranslate(0, 0, radius);
-            // Local Z+ is World Z+. Local X is World X. Local Y is World Y.
-            u = normalized.x / absZ;
-            v = normalized.y / absZ;
-        } else { // -Z (Back)
-            // transforms[5] = MatrixMultiply(MatrixRotateY(PI), MatrixTranslate(0, 0, -radius));
-            // Local Z+ is World Z-. Local X is -World X. Local Y is World Y.
-            u = -normalized.x / absZ;
-            v = normalized.y / absZ;
-        }
-    }
-    
-    // Convert [-1, 1] to [0, 1]
-    float normalizedX = (u + 1.0f) * 0.5f;
-    float normalizedY = (v + 1.0f) * 0.5f;
-    
-    float noiseX = normalizedX * terrainFrequency;
-    float noiseY = normalizedY * terrainFrequency;
-    
-    float heightNoise = MoonTerrain(noiseX, noiseY);
-    float heightVariation = planetRadius * terrainAmplitude * heightNoise;
-    
-    return planetRadius + heightVariation;
-}
-
 int main(void) {
     const int screenWidth = 1280;
     const int screenHeight = 720;
@@ -265,15 +150,30 @@ int main(void) {
 
     // Create CSM with high resolution for sharp shadows
     CascadedShadowMap* csm = CSM_Create(lightDir, 4096);
+    unsigned int shadowedVersion = planet->drawnVersion; // Planet geometry the maps hold
 
     // Assign shader to planet (shadow map texture will be handled per cascade/frame)
     planet->lightingShader = lightingShader;
+    // Draw chunks from the height atlas, one instanced call per resolution and seam
+    planet->instancedRendering = true;
+
+    // Evaluate the terrain of instanced chunks on the GPU instead of the workers
+    Shader terrainShader = LoadShader("shaders/terrain.vs", "shaders/terrain.fs");
+    bool gpuTerrain = Planet_SetTerrainShader(planet, terrainShader);
+    if (!gpuTerrain) {
+        printf("WARNING: GPU terrain unavailable, generating chunks on the CPU\n");
+    }
     // planet->shadowMapTexture = ...; // Not used directly anymore, we bind manually
 
     SetTargetFPS(60);
 
+    // Camera path recording for tools/planet_replay (R starts and stops)
+    FILE* cameraPath = NULL;
+    double recordTime = 0.0;
+
     while (!WindowShouldClose()) {
         // Update
+        Vector3 previousPosition = camera.position;
         float currentSpeed = UpdateCameraFlight(&camera);
 
         // Toggle wireframe with F key
@@ -282,25 +182,87 @@ int main(void) {
             planet->wireframeColor = showWireframe ? originalWireframeColor : BLANK;
         }
 
-        Planet_Update(planet, camera.position);
+        // Toggle instanced rendering with I key (chunks switch as they are rebuilt)
+        if (IsKeyPressed(KEY_I)) {
+            planet->instancedRendering = !planet->instancedRendering;
+        }
+
+        // Toggle geomorphing with M key, to compare LOD transitions
+        if (IsKeyPressed(KEY_M)) {
+            planet->lodMorphRange = planet->lodMorphRange > 0.0f ? 0.0f : PLANET_DEFAULT_LOD_MORPH_RANGE;
+        }
+
+        // Write a Chrome trace of the recent frames with T key (PLANET_ENABLE_STATS builds)
+        if (IsKeyPressed(KEY_T)) {
+            const PlanetStats* stats = Planet_GetStats(planet);
+            if (PlanetStats_WriteChromeTrace("planet_trace.json", &stats, 1)) {
+                printf("Wrote planet_trace.json\n");
+            }
+        }
+
+        // Record the camera path with R key, one line per frame (see tools/planet_replay.c)
+        if (IsKeyPressed(KEY_R)) {
+            if (cameraPath) {
+                fclose(cameraPath);
+                cameraPath = NULL;
+                printf("Wrote camera_path.txt\n");
+            } else if ((cameraPath = fopen("camera_path.txt", "w"))) {
+                fprintf(cameraPath, "# time px py pz tx ty tz ux uy uz fovy\n");
+                recordTime = 0.0;
+            }
+        }
+        if (cameraPath) {
+            fprintf(cameraPath, "%.6f %.9g %.9g %.9g %.9g %.9g %.9g %.9g %.9g %.9g %.9g\n", recordTime,
+                    camera.position.x, camera.position.y, camera.position.z,
+                    camera.target.x, camera.target.y, camera.target.z,
+                    camera.up.x, camera.up.y, camera.up.z, camera.fovy);
+            recordTime += GetFrameTime();
+        }
+
+        // Toggle GPU terrain with G key
+        if (IsKeyPressed(KEY_G)) {
+            if (gpuTerrain) {
+                Planet_SetTerrainShader(planet, (Shader){ 0 });
+                gpuTerrain = false;
+            } else {
+                gpuTerrain = Planet_SetTerrainShader(planet, terrainShader);
+            }
+        }
+
+        // Velocity lets the planet start on the tiles ahead of the camera
+        float frameTime = GetFrameTime();
+        Vector3 cameraVelocity = frameTime > 0.0f
+            ? Vector3Scale(Vector3Subtract(camera.position, previousPosition), 1.0f / frameTime)
+            : (Vector3){ 0 };
+        // Screen-space error LOD for this view
+        planet->lodFovy = camera.fovy;
+        planet->lodScreenHeight = GetScreenHeight();
+        Planet_UpdateWithVelocity(planet, camera.position, cameraVelocity);
 
         // Calculate radar altitude (height above actual terrain)
         float distFromCenter = Vector3Length(camera.position);
-        float terrainHeight = GetTerrainHeightAtPosition(camera.position, moonRadius, 18.0f, 0.005f);
+        float terrainHeight = Planet_SampleHeight(planet, camera.position, NULL);
         float radarAltitude = distFromCenter - terrainHeight;
 
-        // Update CSM
+        // Update CSM. New leaves or uploads change the shadow casters, so
+        // every cached map is stale.
+        if (planet->drawnVersion != shadowedVersion) {
+            CSM_Invalidate(csm);
+            shadowedVersion = planet->drawnVersion;
+        }
         CSM_UpdateCascades(csm, camera, radius, 0.005f, radarAltitude);
 
-        // PASS 1: Render all cascade shadow maps
+        // PASS 1: Render the cascade shadow maps that changed (the others
+        // keep last frame's map and matrix)
         for (int i = 0; i < CASCADE_COUNT; i++) {
+            if (!CSM_IsCascadeDirty(csm, i)) continue;
             SetShaderValueMatrix(shadowShader, shadowLightSpaceMatrixLoc,
                                csm->cascades[i].lightSpaceMatrix);
 
             BeginTextureMode(csm->cascades[i].shadowMap);
                 rlClearScreenBuffers();
                 rlViewport(0, 0, csm->shadowMapResolution, csm->shadowMapResolution);
-                Planet_DrawWithShader(planet, shadowShader);
+                Planet_DrawWithShaderCulled(planet, shadowShader, csm->cascades[i].lightSpaceMatrix);
             EndTextureMode();
         }
 
@@ -369,12 +331,23 @@ int main(void) {
 
             DrawText(TextFormat("Triangles: %s", triStr), 10, 70, 20, YELLOW);
 
-            DrawText("WASD: Move | Q/E: Roll | Space/Ctrl: Up/Down | Shift: Fast | Wheel: Speed | F: Wireframe", 10, 100, 16, DARKGRAY);
+            DrawText("WASD: Move | Q/E: Roll | Space/Ctrl: Up/Down | Shift: Fast | Wheel: Speed | F: Wireframe | I: Instancing | G: GPU Terrain | M: Geomorph | T: Trace | R: Record path", 10, 100, 16, DARKGRAY);
             
             DrawCascadeDebugOverlay(csm, camera);
+
+            // Last complete frame of the pipeline stats, when built with them
+            const PlanetFrameStats* frameStats = PlanetStats_GetFrame(Planet_GetStats(planet), 1);
+            if (frameStats) {
+                DrawText(TextFormat("Update %.2f ms (tree %.2f, upload %.2f) | Queue %d | Wait %.0f ms | Uploads %d (%d KB)",
+                                    frameStats->updateMs, frameStats->quadtreeMs, frameStats->uploadMs,
+                                    frameStats->queueDepth, frameStats->waitMsAvg, frameStats->uploads,
+                                    frameStats->uploadBytes / 1024),
+                         10, 265, 16, LIGHTGRAY);
+            }
         EndDrawing();
     }
 
+    if (cameraPath) fclose(cameraPath);
     CSM_Destroy(csm);
     Planet_Free(planet);
     CloseWindow();
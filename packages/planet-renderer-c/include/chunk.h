@@ -3,6 +3,12 @@
 
 #include <raylib.h>
 #include <pthread.h>
+#include <stddef.h>
+#include "chunk_id.h"
+
+struct ChunkUploadQueue;
+struct TileCache;
+struct ChunkHeightAtlas;
 
 // Chunk generation states
 typedef enum {
@@ -13,9 +19,74 @@ typedef enum {
     CHUNK_STATE_UPLOADED         // Uploaded to GPU and ready to render
 } ChunkState;
 
+// Compact vertex uploaded to the GPU (12 bytes instead of 32 for float
+// position + normal + texcoord). The shader decodes it with the chunk
+// uniforms below; texcoords are derived from gl_VertexID. Grids up to
+// resolution 253 are followed by a skirt ring of 4 * (resolution + 1)
+// vertices (one run per edge, CHUNK_ID_EDGE_* order).
+//   uniform vec3 chunkOrigin;     // boundsMin
+//   uniform vec3 chunkExtent;     // boundsExtent
+//   uniform int chunkResolution;  // Grid cells per side
+//   uniform int chunkFirstVertex; // Add to gl_VertexID (banded draws)
+//
+// Geomorphing: a vertex the parent tile does not have (odd x or y) blends
+// toward the parent mesh, the midpoint of its even neighbors along the
+// parent's triangle edges, as the camera approaches the distance the leaf
+// merges at. The weight depends only on the vertex position and the chunk
+// morph end, so neighbors that share it agree on their shared edge (same
+// level and parent; others can differ slightly, the skirts cover that).
+// Planet sets the morph end to the parent's split distance, which no vertex
+// of a leaf is ever closer than (see Quadtree.comparatorValue): leaves
+// appear and merge away shaped like their parent. Normals keep the leaf's
+// detail. The packed vertex carries the radial offset to the parent mesh in
+// its fourth position component (0 for even vertices and odd resolutions):
+//   uniform vec3 lodCamera;      // Camera the LOD tree was updated for
+//   uniform float lodMorphStart; // Fraction of the morph end where the weight starts to rise (>= 1 disables)
+//   uniform float chunkMorphEnd; // Chunk.lodMorphEnd (instanced: instanceLod.x)
+//   uniform float planetRadius;
+//   uniform vec3 planetOrigin;
+// With d the distance from lodCamera to the sphere point under the vertex,
+// weight = clamp((d / chunkMorphEnd - lodMorphStart) / (1 - lodMorphStart), 0, 1),
+// morphed = position - normalize(position - planetOrigin) * offset * weight,
+// offset = (vertexPosition.w * 2 - 1) * length(chunkExtent).
+// See examples/shaders/lighting.vs.
+typedef struct ChunkVertex {
+    unsigned short position[3]; // unorm16 over [boundsMin, boundsMin + boundsExtent]
+    unsigned short morph;       // Radial offset to the parent mesh, unorm16 over +-length(boundsExtent)
+    short normal[2];            // Octahedral-encoded unit normal, snorm16
+} ChunkVertex;
+
+// Grids above 254 cells per side exceed one 16-bit index range and are
+// drawn in row bands; a band needs at least two vertex rows
+#define CHUNK_MAX_RESOLUTION 32767
+
 typedef struct Chunk {
-    Mesh mesh;
-    Model model;
+    // CPU mesh data (written by the generating worker)
+    ChunkVertex* vertices;  // Packed grid vertices, (resolution + 1)^2, row-major
+    int vertexCount;
+    int triangleCount;
+    Vector3 boundsMin;      // Quantization frame of the packed positions
+    Vector3 boundsExtent;
+    float parentError;      // Largest morph offset: how far the parent tile's mesh strays from this one, -1 = unknown (GPU terrain)
+
+    // GPU objects (main thread only). The index buffer is shared by all
+    // chunks of the same resolution and bound in the VAO.
+    unsigned int vaoId;
+    unsigned int vboId;
+    int gpuVertexCount;     // Vertices the VBO was allocated for
+    int gpuResolution;      // Resolution whose shared index buffer the VAO holds
+    unsigned char seamMask; // CHUNK_ID_EDGE_* edges to stitch to a one level coarser neighbor, set before drawing
+    float lodMorphEnd;      // Camera distance where the mesh matches its parent's (see ChunkVertex), set before drawing
+
+    // Instanced rendering (see chunk_batch.h): with a height atlas the chunk
+    // builds only its padded height grid and uploads it to an atlas slot,
+    // instead of vertices to a VBO. Set while no job is in flight.
+    struct ChunkHeightAtlas* heightAtlas; // NULL = per-chunk vertex buffer
+    float* heights;         // Displacement in meters, (resolution + 3)^2, row-major from (-1, -1)
+    int heightCount;
+    int atlasSlot;          // -1 = none
+    bool gpuTerrain;        // Heights rendered into the slot on upload (ChunkBatch terrain shader), none on the CPU
+
     Vector3 offset;
     float width;
     float height;
@@ -23,28 +94,75 @@ typedef struct Chunk {
     int resolution;
     Matrix localToWorld;
     Vector3 origin;
-    unsigned long long id; // Unique ID matching QuadtreeNode
+    Vector3 center; // World-space center on the sphere, used for scheduling priority
+    ChunkId id; // Tile ID matching QuadtreeNode
     bool isUploaded; // Track if VRAM is allocated
     float terrainFrequency;
     float terrainAmplitude;
 
     // Async generation state
     ChunkState state;
+    // Epochs (guarded by stateMutex): epoch is bumped whenever the chunk is
+    // retired, jobEpoch is the epoch its queued job was issued for. A job
+    // that finishes under a newer epoch is stale and its result is dropped.
+    unsigned int epoch;
+    unsigned int jobEpoch;
+    struct ChunkUploadQueue* uploadQueue; // Where the worker posts the finished mesh (may be NULL)
+    struct TileCache* tileCache;          // Terrain samples looked up before running the noise (may be NULL)
+
+    // Parent/child fallback (owned by Planet, main thread only)
+    struct Chunk* nextFallback; // Next retired chunk standing in for the same tile
+    bool hasFallback;           // Another mesh covers this tile meanwhile, so generation can wait
+    bool isPrefetch;            // Generated ahead for a predicted leaf, not in the live tree yet
+    void* owner;                // Planet that attached the chunk, rescores its job on a shared thread pool
+
+    // Pool links (owned by ChunkPool, main thread only)
+    struct Chunk* poolNewer;  // LRU order over the whole pool
+    struct Chunk* poolOlder;
+    struct Chunk* bucketNext; // Newest-first list of pooled chunks of the same resolution
+    struct Chunk* bucketPrev;
     pthread_mutex_t stateMutex;
+
+#ifdef PLANET_ENABLE_STATS
+    double queuedTime; // Chunk_QueueGeneration time (PlanetStats_Now)
+    double readyTime;  // When the job posted the result (written by the worker before the post)
+#endif
 } Chunk;
 
 Chunk* Chunk_Create(Vector3 offset, float width, float height, float radius, int resolution, Vector3 origin, Matrix localToWorld, float terrainFrequency, float terrainAmplitude);
 
-// Synchronous generation (old API, still supported)
+// Synchronous generation: the async pipeline followed by an immediate upload
+// (main thread only)
 void Chunk_Generate(Chunk* chunk);
 
 // Async generation API
-void Chunk_GenerateAsync(Chunk* chunk);      // Generate mesh data on worker thread
+void Chunk_GenerateAsync(Chunk* chunk);      // Generate mesh data on worker thread, then post it to uploadQueue
 void Chunk_UploadToGPU(Chunk* chunk);        // Upload to GPU (must be called from main thread)
+int Chunk_GetUploadSize(const Chunk* chunk); // Bytes the next Chunk_UploadToGPU will transfer (or render, for GPU terrain)
+int Chunk_GetTriangleCount(int resolution);  // Grid and skirt triangles of one chunk
+int Chunk_GetHeightSampleCount(int resolution); // Terrain samples per chunk, as stored in the tile cache
 ChunkState Chunk_GetState(Chunk* chunk);     // Thread-safe state getter
+void Chunk_MarkObsolete(Chunk* chunk);       // Bumps the epoch: any in-flight or queued result is discarded, not uploaded
+void Chunk_QueueGeneration(Chunk* chunk);    // PENDING, with the job issued for the current epoch (main thread)
+bool Chunk_IsJobInFlight(Chunk* chunk);      // PENDING or GENERATING: a worker may still touch the chunk
+
+// Memory residency (main thread)
+size_t Chunk_GetCPUBytes(Chunk* chunk);       // Struct and vertex buffer (the size being built while a job runs)
+size_t Chunk_GetGPUBytes(const Chunk* chunk); // Vertex buffer or atlas slot on the GPU, not counting the shared index buffer
+size_t Chunk_GetSharedIndexBytes(void);       // Index buffers shared by all chunks of all planets
+void Chunk_ReleaseGPU(Chunk* chunk);          // Unloads the GPU buffers (or frees the atlas slot) and keeps the CPU mesh, GPU terrain renders again (no job in flight)
+// Switches rendering mode, dropping the data of the previous one (no job in
+// flight). gpuTerrain needs an atlas whose batch has a terrain shader.
+void Chunk_SetHeightAtlas(Chunk* chunk, struct ChunkHeightAtlas* atlas, bool gpuTerrain);
+
+// Geomorph parameters of the draws that follow, both per-chunk and
+// instanced (see ChunkVertex). morphStart >= 1 disables morphing, the
+// default. Main thread.
+void Chunk_SetLodMorph(Vector3 lodCamera, float morphStart);
 
-void Chunk_Draw(Chunk* chunk, Color surfaceColor, Color wireframeColor, Shader lightingShader);
-void Chunk_DrawWithShadow(Chunk* chunk, Color surfaceColor, Color wireframeColor, Shader lightingShader, Texture2D shadowMap);
+// Per-chunk VBO only, see ChunkBatch_Add. Return the number of draw calls.
+int Chunk_Draw(Chunk* chunk, Color surfaceColor, Color wireframeColor, Shader lightingShader);
+int Chunk_DrawWithShadow(Chunk* chunk, Color surfaceColor, Color wireframeColor, Shader lightingShader, Texture2D shadowMap);
 void Chunk_Free(Chunk* chunk);
 
 #endif // CHUNK_H
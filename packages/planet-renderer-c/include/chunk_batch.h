@@ -0,0 +1,142 @@
+#ifndef CHUNK_BATCH_H
+#define CHUNK_BATCH_H
+
+#include "chunk.h"
+#include <raylib.h>
+#include <stdbool.h>
+
+// --- Instanced chunk rendering ---
+// Every chunk of a resolution has the same grid topology, so instead of a
+// VBO per chunk, a chunk can keep just its padded height grid (displacement
+// in meters, (resolution + 3)^2 samples) in a slot of a per-resolution
+// R32 float atlas texture. A draw pass collects the visible chunks and
+// issues one instanced draw per resolution and seam mask with the shared
+// index buffer. The vertex shader rebuilds each vertex from gl_VertexID,
+// the instance attributes and the atlas: position on the sphere, central
+// difference normal, skirt. The result matches the CPU mesh.
+//
+// Shader contract, in addition to the chunk uniforms in chunk.h:
+//   uniform int chunkInstanced;    // 1 for instanced draws, 0 for per-chunk VBOs
+//   uniform sampler2D heightAtlas; // On texture unit CHUNK_BATCH_ATLAS_TEXTURE_SLOT
+//   uniform float planetRadius;
+//   uniform vec3 planetOrigin;
+//   in vec4 instanceCorner;        // xyz: face-plane point of grid vertex (0, 0), w: slot texel x
+//   in vec4 instanceAxisU;         // xyz: grid vertex (res, 0) minus the corner, w: slot texel y
+//   in vec4 instanceAxisV;         // xyz: grid vertex (0, res) minus the corner, w: skirt depth
+//   in vec4 instanceLod;           // x: Chunk.lodMorphEnd (optional, for geomorphing)
+// Padded sample (x, y), x and y from -1 to res + 1, is at texel
+// (slot x + x + 1, slot y + y + 1) and on the sphere at
+// normalize(corner + (axisU * x + axisV * y) / res) * (planetRadius + h).
+// Geomorphing (see ChunkVertex) takes the parent mesh point from the atlas:
+// the midpoint of the neighbor samples listed there, along the radius.
+// See examples/shaders/lighting.vs.
+//
+// Only resolutions with skirts and one 16-bit index range are instanced
+// (CHUNK_BATCH_MAX_RESOLUTION). Main thread only.
+//
+// GPU terrain: with a terrain shader (ChunkBatch_SetTerrainShader), chunks
+// can skip the CPU noise altogether. Uploading such a chunk draws one
+// triangle over its atlas slot with the terrain shader, a GLSL port of
+// MoonTerrain, so a new chunk costs a slot and a small draw. GL 3.3 has
+// no compute shaders, hence a fragment pass. These chunks keep no CPU
+// heights; an atlas resize or a GPU eviction renders them again.
+//
+// Terrain shader contract:
+//   uniform ivec2 terrainSlotOrigin; // Texel of padded sample (-1, -1)
+//   uniform vec2 terrainOffset;      // Face-plane position of grid vertex (0, 0)
+//   uniform vec2 terrainStep;        // Face-plane size of one grid cell
+//   uniform float terrainRadius;
+//   uniform float terrainNoiseScale; // terrainFrequency / (2 * radius), as in chunk.c
+//   uniform float terrainAmplitude;  // Meters per MoonTerrain unit
+// The fragment at texel t writes the displacement in meters (red) of
+// padded sample t - terrainSlotOrigin - 1. See examples/shaders/terrain.vs
+// and terrain.fs.
+
+#define CHUNK_BATCH_MAX_RESOLUTION 253
+#define CHUNK_BATCH_ATLAS_TEXTURE_SLOT 7 // Above the units the example's shadow cascades use
+#define CHUNK_BATCH_ATLAS_WIDTH 2048     // Texels; the height grows with the slot count
+
+typedef struct ChunkInstance {
+    float corner[4];
+    float axisU[4];
+    float axisV[4];
+    float lod[4];
+} ChunkInstance;
+
+// Slots of slotSize^2 texels, slotsPerRow per texture row. The texture is
+// created on the first upload and doubles its height when full; a resize
+// uploads the resident chunks again from their CPU heights.
+typedef struct ChunkHeightAtlas {
+    struct ChunkBatch* batch; // Owner, for the terrain shader
+    int resolution;
+    int slotSize; // resolution + 3
+    int slotsPerRow;
+    int capacity;
+    unsigned int textureId; // 0 until the first upload
+    int textureHeight;
+    unsigned int fboId;     // Render target over the texture for GPU terrain, 0 until needed
+    Chunk** owners;         // By slot, NULL = free
+    int* freeSlots;         // Stack of free slot indices
+    int freeCount;
+} ChunkHeightAtlas;
+
+// Atlas, instance buffer and per-frame instance list of one resolution
+typedef struct ChunkBatchGroup {
+    ChunkHeightAtlas atlas;
+    unsigned int vaoId;          // Shared index buffer and instance buffer, no vertex data
+    unsigned int instanceVboId;
+    int instanceVboCapacity;     // Instances
+    ChunkInstance* instances;    // Queued for the next flush
+    unsigned char* seamMasks;
+    int count;
+    int capacity;
+    ChunkInstance* sorted;       // Grouped by seam mask for the draws
+    int sortedCapacity;
+} ChunkBatchGroup;
+
+typedef struct ChunkBatch {
+    ChunkBatchGroup** groups; // Stable pointers: chunks hold &group->atlas
+    int groupCount;
+    float radius;   // Uniforms of the next flush
+    Vector3 origin;
+    int drawCalls;  // Issued by the last flush
+
+    // GPU terrain, see ChunkBatch_SetTerrainShader
+    bool gpuTerrain;        // New instanced chunks take their heights from terrainShader
+    Shader terrainShader;   // Last valid terrain shader (id 0 = none), also re-renders resident chunks
+    int terrainSlotOriginLoc;
+    int terrainOffsetLoc;
+    int terrainStepLoc;
+    int terrainRadiusLoc;
+    int terrainNoiseScaleLoc;
+    int terrainAmplitudeLoc;
+    unsigned int terrainVaoId; // Empty: the terrain vertex shader works from gl_VertexID
+} ChunkBatch;
+
+ChunkBatch* ChunkBatch_Create(float radius, Vector3 origin);
+bool ChunkBatch_SupportsResolution(int resolution);
+// Atlas for chunks of a resolution (created on first use), for Chunk_SetHeightAtlas
+ChunkHeightAtlas* ChunkBatch_GetAtlas(ChunkBatch* batch, int resolution);
+// Queues an uploaded instanced chunk, drawn with its current seamMask
+void ChunkBatch_Add(ChunkBatch* batch, Chunk* chunk);
+// Draws and clears the queue: the surface in color, then the same
+// instances in wireframe unless wireframeColor is fully transparent.
+// Returns the number of draw calls.
+int ChunkBatch_Flush(ChunkBatch* batch, Shader shader, Color color, Color wireframeColor);
+void ChunkBatch_Destroy(ChunkBatch* batch); // Chunks must have released their slots. Does not unload the terrain shader.
+
+// Sets the shader that renders heights for chunks with gpuTerrain and turns
+// gpuTerrain on. Returns false, leaving it off, if the shader lacks the
+// contract's uniforms or the GPU cannot render to an R32F texture. A shader
+// with id 0 turns it off for new chunks; resident ones keep the previous
+// shader, which must stay loaded until they are gone.
+bool ChunkBatch_SetTerrainShader(ChunkBatch* batch, Shader shader);
+
+// Called by Chunk_UploadToGPU and when a chunk unloads its GPU data.
+// Upload takes a slot if needed and fills it from the chunk's CPU heights,
+// or renders them for a gpuTerrain chunk (outside BeginTextureMode: it binds
+// its own render target). False if the atlas cannot grow.
+bool ChunkHeightAtlas_Upload(ChunkHeightAtlas* atlas, Chunk* chunk);
+void ChunkHeightAtlas_Release(ChunkHeightAtlas* atlas, Chunk* chunk);
+
+#endif // CHUNK_BATCH_H
@@ -0,0 +1,51 @@
+#ifndef CHUNK_ID_H
+#define CHUNK_ID_H
+
+#include <stdbool.h>
+
+// Exact, hierarchical tile IDs for quadtree nodes (and the chunks attached
+// to them). Layout of the 64-bit value:
+//
+//   bits 61-63  cube face (0-5)
+//   bits 56-60  level (0 = face root)
+//   bits  0-55  Morton code of the tile coordinates, x in even bits, y in odd
+//
+// At level L a face is 2^L x 2^L tiles; tile (0, 0) is the corner at the
+// face's local (-size, -size). IDs are collision-free, and parent, children
+// and same-face neighbors are plain bit arithmetic. Cross-face neighbors
+// need the face transforms: see CubicQuadTree_GetNeighborId.
+
+typedef unsigned long long ChunkId;
+
+#define CHUNK_ID_MAX_LEVEL 28 // 2 * 28 Morton bits fill the low 56 bits
+#define CHUNK_ID_INVALID 0xFFFFFFFFFFFFFFFFULL // Face 7: never a real tile
+
+ChunkId ChunkId_Make(int face, int level, unsigned int x, unsigned int y);
+ChunkId ChunkId_MakeRoot(int face);
+
+int ChunkId_GetFace(ChunkId id);
+int ChunkId_GetLevel(ChunkId id);
+unsigned int ChunkId_GetX(ChunkId id);
+unsigned int ChunkId_GetY(ChunkId id);
+bool ChunkId_IsValid(ChunkId id);
+
+// Children are numbered (y << 1) | x: 0 = (-x, -y), 1 = (+x, -y),
+// 2 = (-x, +y), 3 = (+x, +y), matching Quadtree_GetChildren order
+ChunkId ChunkId_GetParent(ChunkId id);             // CHUNK_ID_INVALID for a root
+ChunkId ChunkId_GetChild(ChunkId id, int index);   // CHUNK_ID_INVALID past CHUNK_ID_MAX_LEVEL
+int ChunkId_GetChildIndex(ChunkId id);             // Position within its parent (root: 0)
+int ChunkId_GetChildIndexAt(ChunkId id, int level); // Position of the level ancestor within its parent
+ChunkId ChunkId_GetAncestor(ChunkId id, int level); // Same tile at a coarser level
+bool ChunkId_IsAncestorOf(ChunkId ancestor, ChunkId id); // Also true for id itself
+
+// Same-level neighbor offset by (dx, dy) tiles on the same face, or
+// CHUNK_ID_INVALID if that falls off the face edge
+ChunkId ChunkId_GetNeighbor(ChunkId id, int dx, int dy);
+
+// Tile edges as mask bits, in local face axes
+#define CHUNK_ID_EDGE_NEG_X 1 // x = 0 column
+#define CHUNK_ID_EDGE_POS_X 2
+#define CHUNK_ID_EDGE_NEG_Y 4 // y = 0 row
+#define CHUNK_ID_EDGE_POS_Y 8
+
+#endif // CHUNK_ID_H
@@ -3,41 +3,141 @@
 
 #include "chunk.h"
 #include <stdbool.h>
+#include <pthread.h>
 
 // --- Chunk Map (Hash Map) ---
-// Simple open addressing or chaining hash map to store active chunks by ID
+// Active chunks by node ID. Robin Hood open addressing over a power-of-two
+// slot array; each slot points into a dense entry array, so live chunks can
+// be walked without touching empty slots. Grows automatically and is kept
+// across frames (Planet_Update only inserts and removes the leaf diff).
 
 typedef struct ChunkMapEntry {
-    unsigned long long key;
+    ChunkId key;
     Chunk* value;
-    struct ChunkMapEntry* next; // Chaining for collisions
 } ChunkMapEntry;
 
+typedef struct ChunkMapSlot {
+    int entry;         // Index into entries, -1 if empty
+    unsigned int hash; // Low bits of the mixed key (home slot = hash & mask)
+} ChunkMapSlot;
+
 typedef struct ChunkMap {
-    ChunkMapEntry** buckets;
-    int capacity;
+    ChunkMapSlot* slots;
+    int capacity;           // Slot count, power of two
+    ChunkMapEntry* entries; // entries[0..count) are the live chunks, unordered
+    int entryCapacity;
     int count;
 } ChunkMap;
 
-ChunkMap* ChunkMap_Create(int capacity);
-void ChunkMap_Insert(ChunkMap* map, unsigned long long key, Chunk* chunk);
-Chunk* ChunkMap_Get(ChunkMap* map, unsigned long long key);
-Chunk* ChunkMap_Remove(ChunkMap* map, unsigned long long key);
+ChunkMap* ChunkMap_Create(int capacity); // Expected entry count, grows past it
+void ChunkMap_Insert(ChunkMap* map, ChunkId key, Chunk* chunk); // Replaces an existing key
+Chunk* ChunkMap_Get(ChunkMap* map, ChunkId key);
+Chunk* ChunkMap_Remove(ChunkMap* map, ChunkId key); // Moves the last entry into the gap
 void ChunkMap_Clear(ChunkMap* map); // Does not free chunks, just clears map
 void ChunkMap_Destroy(ChunkMap* map); // Frees map structure, not chunks
 
 // --- Chunk Pool ---
-// Pool to recycle chunks
+// Pool to recycle chunks. A chunk whose generation job is still in flight
+// is parked on a deferred list instead, and only becomes available once
+// the job has finished or been cancelled, so a worker never writes into a
+// chunk that was handed out again (main thread only).
+//
+// Available chunks are bucketed by resolution, so a reused chunk keeps its
+// vertex buffer size, and kept in one LRU order. Its GPU buffers go when it
+// is handed to a new tile (Chunk_ReleaseGPU), before a worker rebuilds the
+// mesh they were uploaded from. Past the GPU budget the least recently
+// released chunks unload their GPU buffers; past the CPU budget they are
+// freed altogether. Budgets cover what the pool holds, not the chunks in
+// use. A chunk the pool frees is first taken out of uploadQueue, which may
+// still hold a stale post of its last mesh.
+
+typedef struct ChunkPoolBucket {
+    int resolution;
+    Chunk* newest; // Linked by bucketNext
+    int count;
+} ChunkPoolBucket;
 
 typedef struct ChunkPool {
-    Chunk** chunks;
-    int capacity;
+    // Available chunks, linked by poolNewer/poolOlder
+    Chunk* newest;
+    Chunk* oldest;
+    Chunk* oldestWithGPU; // Every pooled chunk older than this has no GPU buffers
     int count;
+    ChunkPoolBucket* buckets;
+    int bucketCount;
+    int bucketCapacity;
+
+    Chunk** deferred; // Released while PENDING/GENERATING
+    int deferredCapacity;
+    int deferredCount;
+
+    size_t cpuBudget;     // Bytes the available chunks may keep, 0 = no limit
+    size_t gpuBudget;
+    size_t cpuBytes;      // Held by the available chunks
+    size_t gpuBytes;
+
+    unsigned long long hits;         // Acquire returned a chunk of the requested resolution
+    unsigned long long misses;       // Acquire returned NULL
+    unsigned long long releases;     // Chunks handed back by Release
+    unsigned long long gpuEvictions; // Chunks that unloaded their GPU buffers for the budget
+    unsigned long long cpuEvictions; // Chunks freed for the budget
+
+    struct ChunkUploadQueue* uploadQueue; // Purged of each chunk freed for the budget (NULL = none)
 } ChunkPool;
 
-ChunkPool* ChunkPool_Create(int initialCapacity);
-void ChunkPool_Release(ChunkPool* pool, Chunk* chunk);
-Chunk* ChunkPool_Acquire(ChunkPool* pool);
-void ChunkPool_Destroy(ChunkPool* pool); // Frees all pooled chunks
+ChunkPool* ChunkPool_Create(size_t cpuBudget, size_t gpuBudget);
+void ChunkPool_Release(ChunkPool* pool, Chunk* chunk); // Retires it (Chunk_MarkObsolete) first
+Chunk* ChunkPool_Acquire(ChunkPool* pool, int resolution); // Most recently released chunk of that resolution, or NULL
+int ChunkPool_Reclaim(ChunkPool* pool); // Moves deferred chunks whose job is done into the pool, returns how many
+void ChunkPool_Trim(ChunkPool* pool);   // Evicts down to the budgets, e.g. after changing them
+void ChunkPool_Destroy(ChunkPool* pool); // Frees all pooled and deferred chunks (no jobs may be running)
+
+// --- Chunk Upload Queue ---
+// Workers post finished chunks; the main thread uploads them closest to
+// the camera first, within a per-frame time and byte budget
+
+typedef struct ChunkUploadEntry {
+    Chunk* chunk;
+    unsigned int epoch; // Chunk epoch the mesh was built for, stale once it changes
+    float distanceSqr;  // To the camera, refreshed every frame
+} ChunkUploadEntry;
+
+typedef struct ChunkUploadQueue {
+    // Posted by worker threads, guarded by mutex
+    ChunkUploadEntry* incoming;
+    int incomingCount;
+    int incomingCapacity;
+    pthread_mutex_t mutex;
+
+    // Main thread only: chunks still waiting for an upload slot
+    ChunkUploadEntry* pending;
+    int pendingCount;
+    int pendingCapacity;
+
+    // Called on the main thread after each upload (NULL = none)
+    void (*onUpload)(Chunk* chunk, void* context);
+    void* onUploadContext;
+    int lastProcessBytes; // Transferred by the last ChunkUploadQueue_Process
+
+#ifdef PLANET_ENABLE_STATS
+    // Accumulated by ChunkUploadQueue_Process, reset by whoever reads them
+    int statsReady;             // Posts taken in
+    double statsWaitSeconds;    // Their enqueue-to-ready latency, summed
+    double statsWaitMaxSeconds;
+    int statsUploads;
+    int statsUploadBytes;
+#endif
+} ChunkUploadQueue;
+
+ChunkUploadQueue* ChunkUploadQueue_Create(int initialCapacity);
+void ChunkUploadQueue_Push(ChunkUploadQueue* queue, Chunk* chunk, unsigned int epoch); // Thread-safe
+// Uploads ready chunks until either budget is spent (<= 0 disables that budget).
+// At least one chunk is uploaded per call so the queue always drains.
+// Returns the number of chunks uploaded.
+int ChunkUploadQueue_Process(ChunkUploadQueue* queue, Vector3 cameraPosition, double budgetMs, int budgetBytes);
+int ChunkUploadQueue_GetPendingCount(ChunkUploadQueue* queue);
+// Drops every post of the chunk, e.g. before freeing it (main thread, no job may be running for it)
+void ChunkUploadQueue_Remove(ChunkUploadQueue* queue, Chunk* chunk);
+void ChunkUploadQueue_Destroy(ChunkUploadQueue* queue); // Does not free chunks
 
 #endif // CHUNK_UTILS_H
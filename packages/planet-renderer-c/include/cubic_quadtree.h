@@ -7,9 +7,32 @@ typedef struct CubicQuadTree {
     Quadtree* faces[6];
 } CubicQuadTree;
 
-CubicQuadTree* CubicQuadTree_Create(float radius, float minNodeSize, float comparatorValue, Vector3 origin);
-void CubicQuadTree_Insert(CubicQuadTree* tree, Vector3 cameraPosition, QuadtreeSplitCallback onSplit);
+CubicQuadTree* CubicQuadTree_Create(float radius, float minNodeSize, float comparatorValue, float maxDisplacement, Vector3 origin);
+// Split/merge every face for the camera, then keep edge-adjacent leaves
+// within one level of each other (across faces too) and refresh the
+// coarserEdges of the leaves around the diff
+void CubicQuadTree_Update(CubicQuadTree* tree, Vector3 cameraPosition, QuadtreeLeafChanges* changes);
 void CubicQuadTree_GetLeafNodes(CubicQuadTree* tree, QuadtreeNode*** outNodes, int* outCount);
+
+// Same-level neighbor one tile away along x (dx = +-1) or y (dy = +-1),
+// crossing onto the adjacent face at face edges
+ChunkId CubicQuadTree_GetNeighborId(const CubicQuadTree* tree, ChunkId id, int dx, int dy);
+
+// Node with this ID or its deepest existing ancestor, see Quadtree_FindNode
+QuadtreeNode* CubicQuadTree_FindNode(CubicQuadTree* tree, ChunkId id);
+
+// CHUNK_ID_EDGE_* bits of the tile's edges whose neighbor in the tree (the
+// deepest node there) is coarser than the tile, as QuadtreeNode.coarserEdges
+// for a leaf. Works for tiles no longer in the tree, e.g. retired meshes.
+unsigned char CubicQuadTree_GetCoarserEdges(CubicQuadTree* tree, ChunkId id);
+
+// Quadtree_ReportMeshError on the face of the tile
+void CubicQuadTree_ReportMeshError(CubicQuadTree* tree, ChunkId id, float parentError);
+
+// Face a direction from the planet center points through, and the
+// face-plane point (x, y) it crosses, the inverse of the face transforms
+int CubicQuadTree_ProjectDirection(const CubicQuadTree* tree, Vector3 direction, float* x, float* y);
+
 void CubicQuadTree_Free(CubicQuadTree* tree);
 
 #endif // CUBIC_QUADTREE_H
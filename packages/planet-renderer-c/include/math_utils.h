@@ -3,6 +3,7 @@
 
 #include <raylib.h>
 #include <raymath.h>
+#include <stdbool.h>
 
 // Basic Vector3 extensions if needed
 Vector3 Vector3AddScalar(Vector3 v, float scalar);
@@ -17,4 +18,25 @@ typedef struct {
 Vector3 BoundingBoxCenter(BoundingBox3 box);
 Vector3 BoundingBoxSize(BoundingBox3 box);
 
+// View frustum as 6 normalized planes (xyz = normal pointing inside, w = distance)
+typedef struct {
+    Vector4 planes[6];
+} Frustum;
+
+typedef enum {
+    FRUSTUM_OUTSIDE,
+    FRUSTUM_INTERSECTS,
+    FRUSTUM_INSIDE
+} FrustumTestResult;
+
+// Extract planes from a combined view-projection matrix as built by raylib's
+// MatrixMultiply(view, projection) (or any matrix a shader applies as M * v)
+Frustum FrustumFromMatrix(Matrix viewProjection);
+FrustumTestResult FrustumTestSphere(const Frustum* frustum, Vector3 center, float radius);
+
+// Horizon culling against a sphere of radius occluderRadius centered at
+// planetCenter. True if a bounding sphere cannot contain any point that is
+// both visible from the camera and within maxSurfaceRadius of the center.
+bool IsSphereBelowHorizon(Vector3 cameraPosition, Vector3 planetCenter, float occluderRadius, float maxSurfaceRadius, Vector3 center, float radius);
+
 #endif // MATH_UTILS_H
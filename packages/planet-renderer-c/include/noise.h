@@ -2,6 +2,7 @@
 #define NOISE_H
 
 #include <raymath.h>
+#include <stdbool.h>
 
 // Simple 2D value noise returning values in range [-1, 1]
 float Noise2D(float x, float y);
@@ -15,4 +16,41 @@ float CraterNoise(float x, float y, int octaves);
 // Moon-like terrain combining multiple noise types
 float MoonTerrain(float x, float y);
 
+// MoonTerrain over arrays: out[i] = MoonTerrain(x[i], y[i]).
+// Runs the widest SIMD kernel the CPU supports (picked on first call);
+// results match the scalar MoonTerrain to within ~1e-6. Neighboring samples
+// should be consecutive (a chunk grid row by row): each layer's hashes are
+// reused while the samples stay in one of its lattice cells.
+void MoonTerrainBatch(const float* x, const float* y, float* out, int count);
+
+// Batch kernels, narrowest first
+typedef enum {
+    MOON_TERRAIN_KERNEL_SCALAR = 0, // Reference: loops over MoonTerrain
+    MOON_TERRAIN_KERNEL_SSE2,       // 4 lanes
+    MOON_TERRAIN_KERNEL_NEON,       // 4 lanes (AArch64)
+    MOON_TERRAIN_KERNEL_AVX2,       // 8 lanes
+    MOON_TERRAIN_KERNEL_AVX512,     // 16 lanes
+    MOON_TERRAIN_KERNEL_COUNT
+} MoonTerrainKernel;
+
+// Kernel MoonTerrainBatch currently uses
+MoonTerrainKernel MoonTerrainBatch_GetKernel(void);
+
+// True if the kernel is built into this library and the CPU can run it
+bool MoonTerrainBatch_IsKernelSupported(MoonTerrainKernel kernel);
+
+// Force a kernel (e.g. SCALAR for reference output). Returns false and keeps
+// the current one if the kernel is unsupported. Not thread-safe against
+// concurrent MoonTerrainBatch calls.
+bool MoonTerrainBatch_SetKernel(MoonTerrainKernel kernel);
+
+const char* MoonTerrainBatch_KernelName(MoonTerrainKernel kernel);
+
+// Largest |kernel - scalar| over the given samples, or -1 if unsupported
+float MoonTerrainBatch_Validate(MoonTerrainKernel kernel, const float* x, const float* y, int count);
+
+// Conservative bound on |MoonTerrain(x, y)| (sampled range is about [-2.3, 0.95]),
+// used to size culling bounds around displaced chunks
+#define MOON_TERRAIN_MAX_ABS 2.5f
+
 #endif // NOISE_H
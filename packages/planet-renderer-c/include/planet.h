@@ -3,19 +3,34 @@
 
 #include "cubic_quadtree.h"
 #include "chunk.h"
+#include "chunk_batch.h"
 #include "chunk_utils.h"
+#include "planet_stats.h"
 #include "thread_pool.h"
+#include "tile_cache.h"
 #include <raylib.h>
 
 typedef struct Planet {
-    CubicQuadTree* quadtree;
+    CubicQuadTree* quadtree; // Persistent, split/merged in place by Planet_Update
+    QuadtreeLeafChanges leafChanges; // Per-frame leaf diff, storage reused across frames
+    // Bumped whenever the drawn chunks may have changed (leaves split or
+    // merged, a chunk uploaded, fallbacks swapped out). Compare it across
+    // frames to invalidate anything cached from a draw, e.g. shadow maps.
+    unsigned int drawnVersion;
     ChunkMap* chunkMap;
+    // Node ID -> retired chunks (linked by nextFallback) still drawn for that
+    // node until every leaf below it, or the leaf itself, has uploaded
+    ChunkMap* fallbackMap;
     ChunkPool* chunkPool;
     ThreadPool* threadPool;
+    bool sharedThreadPool; // Owned by the PlanetSystem the planet belongs to
+    ChunkUploadQueue* uploadQueue; // Finished chunks waiting for a GPU upload slot
+    TileCache* tileCache; // Terrain samples of recently generated tiles, optionally backed by a file
     float radius;
     float minCellSize;
     int minCellResolution;
     Vector3 origin;
+    Vector3 cameraPosition; // From the last Planet_Update, drives generation priority and geomorphing
     Color surfaceColor;
     Color wireframeColor;
     Shader lightingShader;
@@ -23,12 +38,153 @@ typedef struct Planet {
     // Terrain generation parameters
     float terrainFrequency;  // Noise frequency multiplier (affects feature size)
     float terrainAmplitude;  // Height variation multiplier (affects feature height)
+    float maxDisplacement;   // Bound on |terrain height|, sizes node culling bounds
+    // LOD selection, applied by the next Planet_Update. With lodPixelError
+    // > 0 (the default) it is screen-space error driven: a leaf splits once
+    // its geometric error (see QuadtreeNode.geometricError) would span more
+    // than lodPixelError pixels from the camera, on a screen lodScreenHeight
+    // pixels tall with vertical field of view lodFovy (degrees). Flat tiles
+    // stay coarse and rough ones refine early. Otherwise a leaf splits when
+    // the camera is closer than lodComparator chunk sizes to its patch (see
+    // Quadtree.comparatorValue).
+    float lodPixelError;
+    float lodFovy;
+    int lodScreenHeight;
+    float lodComparator;
+    // Triangle budget of the leaves (0 = none): while over it, each update
+    // scales the split distances down by up to 10% (lodBudgetScale divides
+    // them), and back up once the leaves are well under it again.
+    int lodTriangleBudget;
+    float lodBudgetScale; // Current coarsening, 1 = none (read only)
+    // Multiplies every split distance (1 = as configured, 0 = only the six
+    // face roots). PlanetSystem drops far planets to 0.
+    float lodDistanceScale;
+    // Geomorphing blends each leaf toward its parent as the camera nears the
+    // parent's split distance, over the last lodMorphRange (0 to 1) of the
+    // leaf's nominal band (half to all of that distance), so splits and
+    // merges do not pop. 0 disables it. The shaders must implement the morph
+    // part of the chunk shader contract (see ChunkVertex).
+    float lodMorphRange;
+    // Culling toggles (both on by default)
+    bool frustumCulling;
+    bool horizonCulling;
+    // Per-frame GPU upload budget (<= 0 disables a limit). A PlanetSystem
+    // uses its own instead.
+    float uploadBudgetMs;
+    int uploadBudgetBytes;
+    // Generation priority multiplier for chunks a fallback mesh already
+    // covers (> 1 = later, so tiles that would show a hole go first)
+    float fallbackPriorityScale;
+    // Prefetch for Planet_UpdateWithVelocity: leaves of the LOD tree at the
+    // position prefetchSeconds ahead are generated before the camera gets
+    // there, at most prefetchMaxChunks at a time (each holds its CPU mesh
+    // until claimed), with priority scaled by prefetchPriorityScale (> 1 =
+    // after everything the camera needs now). prefetchSeconds <= 0 disables.
+    float prefetchSeconds;
+    int prefetchMaxChunks;
+    float prefetchPriorityScale;
+    CubicQuadTree* prefetchTree; // LOD at the predicted position, NULL until first needed
+    QuadtreeLeafChanges prefetchChanges;
+    ChunkMap* prefetchMap;       // Predicted leaf ID -> speculative chunk
+    // Memory the chunk pool may keep for reuse (0 = no limit), applied by
+    // Planet_Update. Past the GPU budget pooled chunks unload their GPU
+    // buffers, least recently used first; past the CPU budget they are freed.
+    // A PlanetSystem sets them from its own budgets.
+    size_t poolCpuBudgetBytes;
+    size_t poolGpuBudgetBytes;
+    // Draw chunks with one instanced call per resolution and seam mask from
+    // a height atlas, instead of a VBO and draw call each (see
+    // chunk_batch.h). The shaders passed in must implement the instanced
+    // path. Applies to chunks created from then on; off by default.
+    bool instancedRendering;
+    ChunkBatch* batch;
+    PlanetStats* stats; // Recent frames, NULL unless built with PLANET_ENABLE_STATS
 } Planet;
 
+// LOD settings of a new planet
+#define PLANET_DEFAULT_LOD_PIXEL_ERROR 8.0f
+#define PLANET_DEFAULT_LOD_FOVY 45.0f
+#define PLANET_DEFAULT_LOD_SCREEN_HEIGHT 1080
+#define PLANET_DEFAULT_LOD_COMPARATOR 0.8f
+#define PLANET_DEFAULT_LOD_MORPH_RANGE 0.3f
+
+// In-memory tile cache budget of a new planet
+#define PLANET_DEFAULT_TILE_CACHE_BYTES (64 * 1024 * 1024)
+// Chunk pool budgets of a new planet
+#define PLANET_DEFAULT_POOL_CPU_BYTES (64 * 1024 * 1024)
+#define PLANET_DEFAULT_POOL_GPU_BYTES (32 * 1024 * 1024)
+
+// Resident chunk memory and pool counters, see Planet_GetMemoryStats
+typedef struct PlanetMemoryStats {
+    size_t cpuBytes;         // Chunk structs and vertex buffers, in use and pooled
+    size_t gpuBytes;         // Chunk vertex buffers on the GPU, in use and pooled
+    size_t pooledCpuBytes;   // Part of the above held by available pooled chunks
+    size_t pooledGpuBytes;
+    size_t sharedIndexBytes; // GPU index buffers shared by the chunks of all planets
+    size_t heightAtlasBytes; // Height atlas textures of instanced rendering, used and free slots
+    int liveChunks;          // In the tree, drawn as fallbacks, or prefetched
+    int pooledChunks;        // Available for reuse
+    int deferredChunks;      // Released while their job is still running
+    unsigned long long poolHits;   // Reused a pooled chunk of the right resolution
+    unsigned long long poolMisses; // Had to allocate a chunk
+    float poolHitRate;             // hits / (hits + misses), 0 before the first chunk
+    unsigned long long poolGpuEvictions; // Pooled chunks that unloaded their GPU buffers
+    unsigned long long poolCpuEvictions; // Pooled chunks freed
+} PlanetMemoryStats;
+
 Planet* Planet_Create(float radius, float minCellSize, int minCellResolution, Vector3 origin, float terrainFrequency, float terrainAmplitude);
+// Backs the tile cache with a file, so the next session with the same
+// terrain parameters starts from the stored tiles (or from a planet_bake
+// output). maxTiles sizes a new file, see TileCache_OpenStore.
+// Only generation that starts after the call uses it (the face roots queued
+// by Planet_Create may already be running). Returns false if the file cannot
+// be mapped.
+bool Planet_OpenTileStore(Planet* planet, const char* path, int maxTiles);
+// GPU terrain for instanced rendering: new instanced chunks get their heights
+// from the terrain shader (see chunk_batch.h) instead of the CPU noise and
+// the thread pool. CPU height queries (MoonTerrain) are unaffected, and the
+// tile cache is bypassed. Returns false if the shader or the GPU cannot do
+// it; a shader with id 0 switches back. Keep the shader loaded until
+// Planet_Free.
+bool Planet_SetTerrainShader(Planet* planet, Shader shader);
+// Sets lodComparator from a screen-space target: a leaf splits before one
+// of its grid cells spans more than about pixels on a screen screenHeight
+// pixels tall with vertical field of view fovy (degrees), as from a Camera3D.
+// Also takes the view for the screen-space error (lodFovy, lodScreenHeight).
+void Planet_SetLodCellPixels(Planet* planet, float pixels, float fovy, int screenHeight);
 void Planet_Update(Planet* planet, Vector3 cameraPosition);
+// Planet_Update for a moving camera: cameraVelocity (units per second) also
+// starts generating the tiles along the way, see prefetchSeconds
+void Planet_UpdateWithVelocity(Planet* planet, Vector3 cameraPosition, Vector3 cameraVelocity);
+// Walks all chunks, so call it for a HUD or a log line, not per chunk
+PlanetMemoryStats Planet_GetMemoryStats(Planet* planet);
+// Timers and counters of the recent frames (see planet_stats.h), NULL when
+// built without PLANET_ENABLE_STATS
+const PlanetStats* Planet_GetStats(const Planet* planet);
+// Terrain queries (main thread, between updates; see planet_query.c).
+// Answered from the resident chunk meshes, bilinear within a grid cell,
+// where the tile under the point has CPU data, otherwise from MoonTerrain.
+// The height is the distance from the planet origin to the surface along
+// the direction of position; normal (may be NULL) is the surface normal.
+float Planet_SampleHeight(Planet* planet, Vector3 position, Vector3* normal);
+// Planet_SampleHeight over arrays (normals may be NULL). Consecutive probes in
+// the same chunk skip the tree lookup, and the noise fallbacks run batched.
+void Planet_SampleHeightBatch(Planet* planet, const Vector3* positions, float* heights, Vector3* normals, int count);
+// First terrain hit within maxDistance along the ray (direction need not be
+// unit length). Marches in steps of half the altitude above the terrain, at
+// least one finest grid cell, and refines the crossing by bisection. A ray
+// that starts below the surface hits at distance 0. hit may be NULL.
+bool Planet_Raycast(Planet* planet, Ray ray, float maxDistance, RayCollision* hit);
+// Draws chunks visible from the current rlgl camera (call inside BeginMode3D).
+// Subtrees outside the view frustum or below the planet horizon are skipped.
 int Planet_Draw(Planet* planet);
+// Draws every chunk with a custom shader, no culling
 int Planet_DrawWithShader(Planet* planet, Shader shader);
+// Draws chunks inside the volume of viewProjection with a custom shader,
+// e.g. a shadow cascade's lightSpaceMatrix. No horizon test: chunks beyond
+// the camera horizon can still cast shadows.
+int Planet_DrawWithShaderCulled(Planet* planet, Shader shader, Matrix viewProjection);
+// Planets of a PlanetSystem are freed by PlanetSystem_RemovePlanet
 void Planet_Free(Planet* planet);
 
 #endif // PLANET_H
@@ -0,0 +1,102 @@
+#ifndef PLANET_STATS_H
+#define PLANET_STATS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// --- Instrumentation ---
+// With PLANET_ENABLE_STATS defined (CMake option of the same name) every
+// planet keeps timers and counters of its recent frames, and the pipeline
+// records timed spans (updates, draw passes, chunk builds on the workers)
+// for a Chrome trace, viewable in chrome://tracing or Perfetto, or in Tracy
+// after its import-chrome tool. Without it the hooks compile to nothing:
+// Planet_GetStats returns NULL and the trace writer reports failure.
+
+#define PLANET_STATS_HISTORY 120     // Frames kept per planet
+#define PLANET_STATS_MAX_PASSES 8    // Draw passes recorded per frame
+#define PLANET_STATS_MAX_WORKERS 32  // Worker busy times recorded per frame
+#define PLANET_TRACE_CAPACITY 32768  // Spans kept for the trace (all planets and threads), oldest dropped
+
+typedef enum PlanetPassKind {
+    PLANET_PASS_LIT,   // Planet_Draw
+    PLANET_PASS_DEPTH  // Planet_DrawWithShader(Culled), e.g. a shadow cascade
+} PlanetPassKind;
+
+typedef struct PlanetPassStats {
+    PlanetPassKind kind;
+    int drawCalls;
+    int triangles;
+    int chunks;
+    float cpuMs;       // Traversal and draw submission, not GPU time
+} PlanetPassStats;
+
+// One Planet_Update and the draws that follow it. Times are milliseconds.
+typedef struct PlanetFrameStats {
+    unsigned long long frame; // Planet_Update count
+    double time;              // Update start, PlanetStats_Now seconds
+
+    // Update
+    float updateMs;
+    float quadtreeMs;   // Split/merge of the LOD tree
+    float attachMs;     // Retiring and creating chunks for the leaf diff
+    float scheduleMs;   // Prefetch and reprioritizing the pending jobs
+    float uploadMs;     // GPU uploads (and GPU terrain renders)
+    int leafCount;
+    int leavesAdded;
+    int leavesRemoved;
+
+    // Chunks
+    int chunksCreated;  // Allocated: the pool had none of the resolution
+    int chunksReused;   // Taken from the pool
+    int chunksPooled;   // Returned to the pool
+
+    // Generation
+    int queueDepth;       // Jobs waiting for a worker after the update (of all planets on a shared pool, as are the workers below)
+    int chunksReady;      // Jobs finished since the previous update
+    float waitMsAvg;      // Their enqueue-to-ready latency
+    float waitMsMax;
+    int workerCount;
+    float workerBusyMs[PLANET_STATS_MAX_WORKERS]; // Time in jobs since the previous update, per worker
+
+    // Uploads
+    int uploads;
+    int uploadBytes;
+    int uploadsPending;   // Ready chunks left for later frames by the budget
+
+    // Draws, in call order (passes past PLANET_STATS_MAX_PASSES are dropped)
+    int passCount;
+    PlanetPassStats passes[PLANET_STATS_MAX_PASSES];
+
+    // Resident memory after the update, see PlanetMemoryStats
+    size_t cpuBytes;
+    size_t gpuBytes;
+} PlanetFrameStats;
+
+// Ring of a planet's recent frames
+typedef struct PlanetStats {
+    PlanetFrameStats frames[PLANET_STATS_HISTORY];
+    int newest;   // Index of the current frame
+    int count;    // Valid frames, up to PLANET_STATS_HISTORY
+
+    // Recording state: the current update phase, and the running totals the
+    // next frame's deltas are taken from
+    unsigned long long frameCount;
+    double phaseStart;
+    double idleSeconds; // Between the phases of a PlanetSystem update, left out of updateMs
+    unsigned long long poolHits;
+    unsigned long long poolMisses;
+    unsigned long long poolReleases;
+    double workerBusySeconds[PLANET_STATS_MAX_WORKERS];
+} PlanetStats;
+
+// Monotonic clock of the stats and the trace, in seconds
+double PlanetStats_Now(void);
+// Frame framesAgo back (0 = current, complete once its draws are done), NULL past the history
+const PlanetFrameStats* PlanetStats_GetFrame(const PlanetStats* stats, int framesAgo);
+
+// Writes the recorded spans, plus counter tracks from each of the planets'
+// stats (Planet_GetStats, may be NULL), as Chrome trace JSON. Returns false
+// if the file cannot be written or stats are compiled out.
+bool PlanetStats_WriteChromeTrace(const char* path, const PlanetStats* const* planets, int planetCount);
+
+#endif // PLANET_STATS_H
@@ -0,0 +1,70 @@
+#ifndef PLANET_SYSTEM_H
+#define PLANET_SYSTEM_H
+
+#include "planet.h"
+#include <raylib.h>
+#include <stddef.h>
+
+// --- Planet System ---
+// The planets of one scene on one set of workers and budgets. Planets added
+// to a system queue their chunk jobs on its thread pool instead of starting
+// their own, and the pool runs them in one order: distance over chunk size,
+// the inverse of a chunk's size on screen, whichever planet it belongs to.
+// Each update ranks the planets by their projected radius in pixels and
+// hands out the budgets by screen area (up to the full screen):
+//   triangles   the leaves' triangle budget (Planet.lodTriangleBudget)
+//   memory      the chunk pool and tile cache budgets; each planet's pool
+//               keeps at least PLANET_SYSTEM_MIN_POOLED_CHUNKS chunks
+//   uploads     one time and byte budget, spent on the largest planets
+//               first; every planet still uploads one ready chunk a frame
+// A planet whose projected radius falls below lowLodPixels keeps only its
+// six face roots (Planet.lodDistanceScale 0) until it grows past
+// PLANET_SYSTEM_LOW_LOD_HYSTERESIS times that again.
+
+#define PLANET_SYSTEM_DEFAULT_LOW_LOD_PIXELS 48.0f
+#define PLANET_SYSTEM_LOW_LOD_HYSTERESIS 1.25f
+#define PLANET_SYSTEM_MIN_POOLED_CHUNKS 32
+
+typedef struct PlanetSystemEntry {
+    Planet* planet;
+    float screenRadius; // Projected radius in pixels, as of the last update
+    float share;        // Of the memory budgets, as of the last update
+    bool lowLod;        // Reduced to its face roots
+} PlanetSystemEntry;
+
+typedef struct PlanetSystem {
+    ThreadPool* threadPool;     // Shared by all planets
+    PlanetSystemEntry* entries; // Largest on screen first after each update
+    int count;
+    int capacity;
+    // View the screen sizes are measured for, also set as every planet's
+    // lodFovy and lodScreenHeight
+    float fovy;
+    int screenHeight;
+    float lowLodPixels;         // 0 = never reduce
+    int triangleBudget;         // Leaves of all planets, 0 = none
+    // Per-frame GPU upload budget of all planets (<= 0 disables a limit)
+    float uploadBudgetMs;
+    int uploadBudgetBytes;
+    // Memory budgets of all planets (0 = no limit), see Planet.poolCpuBudgetBytes
+    size_t poolCpuBudgetBytes;
+    size_t poolGpuBudgetBytes;
+    size_t tileCacheBudgetBytes;
+} PlanetSystem;
+
+// threadCount <= 0 uses one worker per hardware thread, minus one for the caller
+PlanetSystem* PlanetSystem_Create(int threadCount);
+// Planet_Create on the system's workers and budgets. The planet is updated
+// and freed with the system; configure it like any other.
+Planet* PlanetSystem_AddPlanet(PlanetSystem* system, float radius, float minCellSize, int minCellResolution,
+                               Vector3 origin, float terrainFrequency, float terrainAmplitude);
+// Frees the planet (waits for the jobs already queued on the shared pool)
+void PlanetSystem_RemovePlanet(PlanetSystem* system, Planet* planet);
+void PlanetSystem_Update(PlanetSystem* system, Vector3 cameraPosition);
+// Planet_UpdateWithVelocity for every planet, then the shared uploads
+void PlanetSystem_UpdateWithVelocity(PlanetSystem* system, Vector3 cameraPosition, Vector3 cameraVelocity);
+// Planet_Draw for every planet (call inside BeginMode3D), returns the triangles drawn
+int PlanetSystem_Draw(PlanetSystem* system);
+void PlanetSystem_Free(PlanetSystem* system); // Frees its planets too
+
+#endif // PLANET_SYSTEM_H
@@ -2,36 +2,150 @@
 #define QUADTREE_H
 
 #include "math_utils.h"
+#include "chunk_id.h"
 #include <stdbool.h>
 
+// Merge distance = split distance * hysteresis, so a node sitting right at the
+// split threshold does not flip between split and merged every frame
+#define QUADTREE_DEFAULT_MERGE_HYSTERESIS 1.25f
+
+// Geometric error of a node not measured yet, relative to its parent's:
+// the deviation one more level removes shrinks about this much per level on
+// the moon terrain (conservative, so rough tiles are not held back)
+#define QUADTREE_ERROR_REFINEMENT 0.6f
+// Error driven split distances are capped at this fraction of the parent's,
+// so a leaf never starts inside the band its geomorph needs (see chunk.h)
+#define QUADTREE_MAX_SPLIT_RATIO 0.75f
+
+// Nodes live in fixed-size pages so pointers stay valid while the arena grows.
+// A page holds a whole number of sibling groups (4 nodes each).
+#define QUADTREE_ARENA_PAGE_SHIFT 10
+#define QUADTREE_ARENA_PAGE_NODES (1 << QUADTREE_ARENA_PAGE_SHIFT)
+
 typedef struct QuadtreeNode {
     BoundingBox3 bounds;
-    struct QuadtreeNode* children[4];
     Vector3 center;
     Vector3 sphereCenter;
+    float boundingRadius; // Sphere around sphereCenter enclosing the displaced patch
+    float patchRadius;    // Same for the undisplaced patch, LOD distances are measured to it
+    // How far the node's mesh strays from the finer surface below it, in
+    // world units: measured from the meshes of its children once they are
+    // built (Quadtree_ReportMeshError), estimated before that
+    float geometricError;
+    bool errorMeasured;
+    float parentSplitDistance; // The parent's split distance as of the last update (FLT_MAX for the root), where the node's geomorph ends
     Vector3 size;
+    int firstChild; // Arena index of the first of 4 contiguous children, -1 for leaves
     bool isLeaf;
     void* userData; // For attaching Chunk*
-    Matrix localToWorld; // Store transformation for chunk generation
-    unsigned long long id; // Unique ID for diffing
-    int faceId; // Face index (0-5)
+    ChunkId id; // Face, level and tile coordinates (see chunk_id.h)
+    int faceId; // Face index (0-5), transform is Quadtree.localToWorld
+    unsigned char coarserEdges; // CHUNK_ID_EDGE_* bits of leaf edges whose neighbor leaf is one level coarser
 } QuadtreeNode;
 
+// Per-tree slab of sibling groups with a free list of released groups
+typedef struct QuadtreeNodeArena {
+    QuadtreeNode** pages;
+    int pageCount;
+    int pageCapacity;
+    int groupCount;  // Groups handed out from the pages so far (bump pointer)
+    int freeGroup;   // Head of the free list (-1 if empty), linked through firstChild
+    int liveGroups;
+} QuadtreeNodeArena;
+
+struct Quadtree;
+
+// Returns false to keep node split this update even though the camera is
+// past its merge distance
+typedef bool (*QuadtreeMergeFilter)(const struct Quadtree* tree, const QuadtreeNode* node, void* context);
+
 typedef struct Quadtree {
-    QuadtreeNode* root;
+    QuadtreeNode root;
+    QuadtreeNodeArena arena;
     Matrix localToWorld;
     float size;
     float minNodeSize;
+    float maxDisplacement; // Largest terrain height offset from the sphere, for node bounds
     Vector3 origin;
+    // A leaf splits when the camera is closer than its split distance to
+    // the nearest point of its patch on the sphere (its patchRadius sphere),
+    // so no vertex of a node is ever closer than the distance it was split or
+    // merged at. Geomorphing relies on that (see chunk.h).
+    // The split distance is geometricError * errorDistanceScale when that is
+    // positive: the node's error then projects to a fixed screen-space size
+    // (pixels per radian / tolerance in pixels), up to
+    // QUADTREE_MAX_SPLIT_RATIO of the parent's. Otherwise it is
+    // size * comparatorValue.
     float comparatorValue;
+    float errorDistanceScale;
+    float mergeHysteresis; // Merge when dist >= split distance * mergeHysteresis
     int faceId; // Face index (0-5)
+    QuadtreeMergeFilter mergeFilter; // Optional, NULL merges on distance alone
+    void* mergeFilterContext;
 } Quadtree;
 
-typedef void (*QuadtreeSplitCallback)(QuadtreeNode* node);
+// A leaf that left the tree. Merged nodes go back to the arena, so only the
+// ID and the attached userData are reported, never the node pointer.
+typedef struct QuadtreeRemovedLeaf {
+    ChunkId id;
+    void* userData;
+} QuadtreeRemovedLeaf;
+
+// Leaf diff produced by Quadtree_Update. Reused across frames: clear it
+// before each update instead of reallocating.
+typedef struct QuadtreeLeafChanges {
+    QuadtreeNode** added;
+    int addedCount;
+    int addedCapacity;
+    QuadtreeRemovedLeaf* removed;
+    int removedCount;
+    int removedCapacity;
+} QuadtreeLeafChanges;
+
+Quadtree* Quadtree_Create(float size, float minNodeSize, float comparatorValue, float maxDisplacement, Vector3 origin, Matrix localToWorld, int faceId);
 
-Quadtree* Quadtree_Create(float size, float minNodeSize, float comparatorValue, Vector3 origin, Matrix localToWorld, int faceId);
-void Quadtree_Insert(Quadtree* tree, Vector3 cameraPosition, QuadtreeSplitCallback onSplit);
+// Split and merge nodes in place for the new camera position.
+// Newly created leaves are appended to changes->added, leaves that were split
+// or merged away are appended to changes->removed. changes may be NULL.
+void Quadtree_Update(Quadtree* tree, Vector3 cameraPosition, QuadtreeLeafChanges* changes);
 void Quadtree_GetLeafNodes(Quadtree* tree, QuadtreeNode*** outNodes, int* outCount);
+
+// Split a leaf regardless of distance (e.g. to keep the tree balanced) and
+// record it in changes. A leaf that was added in this same diff is taken
+// back out of changes->added by setting its entry to NULL, which the caller
+// compacts before handing the diff on.
+void Quadtree_SplitLeaf(Quadtree* tree, QuadtreeNode* node, QuadtreeLeafChanges* changes);
+
+// Distance from the camera to the node's patch below which it splits
+float Quadtree_GetSplitDistance(const Quadtree* tree, const QuadtreeNode* node);
+
+// The mesh of tile id was built, and its parent tile's mesh strays from it by
+// up to parentError (see Chunk.parentError): the parent's geometric error
+// becomes the largest such report of its children, and the tile's own
+// estimate is refined from it. Ignored where the tree has no such node.
+void Quadtree_ReportMeshError(Quadtree* tree, ChunkId id, float parentError);
+
+// Returns the first of the node's 4 contiguous children, or NULL for a leaf
+QuadtreeNode* Quadtree_GetChildren(const Quadtree* tree, const QuadtreeNode* node);
+
+// Node with this ID, or its deepest existing ancestor (a leaf) where the tree
+// is not subdivided that far. NULL if the ID belongs to another face.
+QuadtreeNode* Quadtree_FindNode(const Quadtree* tree, ChunkId id);
+
+// Leaf whose face-plane bounds contain (x, y); points off the face land in
+// the nearest edge leaf
+QuadtreeNode* Quadtree_FindLeafAt(const Quadtree* tree, float x, float y);
+
+// Face-plane bounds of the tile with this ID, whether or not the tree is
+// subdivided that far. Identical to the node's bounds when it exists.
+BoundingBox3 Quadtree_GetTileBounds(const Quadtree* tree, ChunkId id);
+
+// Drops every node below the root in one step (pages are kept for reuse)
+void Quadtree_Reset(Quadtree* tree);
 void Quadtree_Free(Quadtree* tree);
 
+void QuadtreeLeafChanges_Init(QuadtreeLeafChanges* changes);
+void QuadtreeLeafChanges_Clear(QuadtreeLeafChanges* changes); // Resets counts, keeps storage
+void QuadtreeLeafChanges_Free(QuadtreeLeafChanges* changes);
+
 #endif // QUADTREE_H
@@ -6,11 +6,26 @@
 
 #define CASCADE_COUNT 4
 
+// Cascades are cached: a map is re-rendered only when it is dirty, and its
+// lightSpaceMatrix stays the one it was rendered with until then. Centers
+// snap to whole texels in light space (a fixed basis for the light
+// direction) and sizes to CSM_SIZE_STEP, so a moving camera does not make the
+// shadow edges shimmer and a clean map stays valid. The cache does not see
+// the casters: call CSM_Invalidate whenever the drawn geometry changes
+// (Planet.drawnVersion), or far cascades keep stale shadows until their
+// interval comes up.
+#define CSM_SIZE_STEP 1.05f            // Half extents round up to powers of this
+#define CSM_DEFAULT_MOVE_THRESHOLD 0.1f
+
 typedef struct {
     RenderTexture2D shadowMap;
     Matrix lightSpaceMatrix;
-    float splitDistance;
+    float splitDistance; // Radius around the camera the map covers (shrinks as the camera drifts from center)
     BoundingBox bounds;
+    Vector3 center;      // Texel-snapped center the map was rendered for
+    float orthoSize;     // Half extent the map was rendered for (0 = never rendered)
+    int updateInterval;  // Re-render every this many frames, staggered across cascades (<= 1 = every frame)
+    bool dirty;          // Must be re-rendered this frame, see CSM_UpdateCascades
 } ShadowCascade;
 
 typedef struct {
@@ -20,15 +35,27 @@ typedef struct {
     float cascadeSplitLambda;
     float nearPlane;
     float farPlane;
+    // Camera drift from a cascade's center, as a fraction of its half
+    // extent, that makes it dirty ahead of its interval
+    float moveThreshold;
+    unsigned int frameIndex;
+    Vector3 renderedLightDirection; // Direction the maps were rendered for
 } CascadedShadowMap;
 
 // Initialization
 CascadedShadowMap* CSM_Create(Vector3 lightDir, int resolution);
 void CSM_Destroy(CascadedShadowMap* csm);
 
-// Per-frame update
+// Per-frame update: lays out the cascades around the camera and marks the
+// ones to re-render (new size, camera past moveThreshold, their interval
+// came up, light direction changed, or invalidated). The caller must render
+// every dirty cascade before drawing with the maps; clean ones keep their
+// map and matrix.
 void CSM_UpdateCascades(CascadedShadowMap* csm, Camera camera, float planetRadius, float terrainAmplitude, float viewAltitude);
 
 // Utility
+bool CSM_IsCascadeDirty(const CascadedShadowMap* csm, int cascade);
+unsigned int CSM_GetDirtyMask(const CascadedShadowMap* csm); // Bit i = cascade i dirty
+void CSM_Invalidate(CascadedShadowMap* csm); // Re-render all cascades at the next update (e.g. after the planet's chunks changed)
 
 #endif // SHADOW_H
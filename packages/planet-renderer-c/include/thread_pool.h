@@ -11,11 +11,15 @@ typedef struct WorkItem WorkItem;
 // Function pointer for work to be executed by threads
 typedef void (*WorkFunction)(void* data);
 
+// Recomputes the priority of a pending job (lower runs sooner)
+typedef float (*WorkPriorityFunction)(void* data, void* context);
+
 // Work item structure
 struct WorkItem {
     WorkFunction function;
     void* data;
-    struct WorkItem* next;
+    float priority;                // Lower value = more urgent
+    unsigned long long sequence;   // Enqueue order, breaks priority ties FIFO
 };
 
 // Thread pool structure
@@ -23,9 +27,13 @@ struct ThreadPool {
     pthread_t* threads;
     int threadCount;
 
-    WorkItem* workQueueHead;
-    WorkItem* workQueueTail;
+    // Pending work as a binary min-heap on (priority, sequence).
+    // Items are stored by value in a preallocated array, so submitting
+    // a job never allocates unless the array has to grow.
+    WorkItem* workHeap;
+    int heapCapacity;
     int queueSize;
+    unsigned long long nextSequence;
 
     pthread_mutex_t queueMutex;
     pthread_cond_t workAvailable;
@@ -33,14 +41,37 @@ struct ThreadPool {
 
     bool shutdown;
     int activeThreads;
+    int idleThreads;   // Workers blocked on workAvailable
+    int waitingCount;  // Callers blocked in ThreadPool_WaitAll
+
+#ifdef PLANET_ENABLE_STATS
+    double* workerBusySeconds; // Time each worker has spent in jobs
+    int nextWorkerIndex;       // Handed to workers as they start
+#endif
 };
 
+// Number of online hardware threads (at least 1)
+int ThreadPool_GetHardwareConcurrency(void);
+
 // Thread pool API
+// threadCount <= 0 uses one worker per hardware thread, minus one for the caller
 ThreadPool* ThreadPool_Create(int threadCount);
-void ThreadPool_Enqueue(ThreadPool* pool, WorkFunction function, void* data);
+void ThreadPool_Enqueue(ThreadPool* pool, WorkFunction function, void* data); // Priority 0
+void ThreadPool_EnqueueWithPriority(ThreadPool* pool, WorkFunction function, void* data, float priority);
+
+// Removes pending (not yet started) jobs whose data matches.
+// Returns true if at least one job was removed.
+bool ThreadPool_Cancel(ThreadPool* pool, void* data);
+
+// Recomputes the priority of every pending job and restores heap order
+void ThreadPool_Reprioritize(ThreadPool* pool, WorkPriorityFunction priorityFn, void* context);
+
 void ThreadPool_WaitAll(ThreadPool* pool);
 int ThreadPool_GetQueueSize(ThreadPool* pool);
 int ThreadPool_GetActiveThreads(ThreadPool* pool);
+// Total time each worker has spent running jobs, for up to maxWorkers
+// workers. Returns how many were written (0 without PLANET_ENABLE_STATS).
+int ThreadPool_GetBusySeconds(ThreadPool* pool, double* seconds, int maxWorkers);
 void ThreadPool_Destroy(ThreadPool* pool);
 
 #endif // THREAD_POOL_H
@@ -0,0 +1,83 @@
+#ifndef TILE_CACHE_H
+#define TILE_CACHE_H
+
+#include "chunk_id.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+
+// --- Tile Cache ---
+// Terrain samples of generated tiles, keyed by (terrain parameters, tile ID,
+// resolution), so a revisited tile skips the noise. Two levels:
+//   memory  LRU of exact float grids, within a byte budget
+//   store   optional memory-mapped file of 16-bit quantized grids that
+//           persists across sessions (one resolution per file), indexed by
+//           tile and filled up to a fixed number of tiles
+// Lookups try memory, then the store; a store hit is promoted to memory.
+// Thread-safe: workers call it from Chunk_GenerateAsync.
+
+#define TILE_CACHE_FORMAT_VERSION 2 // Bump when MoonTerrain's output changes
+
+typedef struct TileCacheEntry {
+    ChunkId id;
+    int resolution;
+    int count;      // Samples in heights
+    float* heights;
+    int prev;       // LRU links (entry indices, -1 = none)
+    int next;       // Also chains free entries
+} TileCacheEntry;
+
+typedef struct TileCacheStore TileCacheStore; // Mapped file, see tile_cache.c
+
+typedef struct TileCache {
+    unsigned long long paramsHash;
+    pthread_mutex_t mutex;
+
+    // In-memory LRU
+    TileCacheEntry* entries;
+    int entryCapacity;
+    int freeEntry;        // Head of the free chain, -1 = none
+    int* slots;           // Linear probing over entry indices, -1 = empty
+    int slotCapacity;     // Power of two, at least twice entryCapacity
+    int count;
+    int newest;           // LRU ends, -1 when empty
+    int oldest;
+    size_t memoryBytes;   // Held in heights
+    size_t memoryBudget;
+
+    TileCacheStore* store; // NULL unless TileCache_OpenStore succeeded
+
+    // Lookup counters (guarded by mutex)
+    unsigned long long memoryHits;
+    unsigned long long storeHits;
+    unsigned long long misses;
+} TileCache;
+
+// Hash of everything the cached samples depend on
+unsigned long long TileCache_HashParams(float radius, float terrainFrequency, float terrainAmplitude);
+
+TileCache* TileCache_Create(unsigned long long paramsHash, size_t memoryBudgetBytes);
+
+// Opens (or creates) the file store for tiles of one resolution, each
+// sampleCount samples. An existing file for the same parameters and layout
+// is used as is, with its own capacity. Any other file is cleared and
+// sized for maxTiles tiles; once that many are stored, new tiles stay in
+// memory only. maxTiles = 0 only opens an existing, matching file. A read-only file (e.g. a shipped bake) must match and is
+// only read. Returns false if the file cannot be mapped; the cache then
+// stays memory-only.
+bool TileCache_OpenStore(TileCache* cache, const char* path, int resolution, int sampleCount, int maxTiles);
+
+// Tiles in the store, 0 without one
+int TileCache_GetStoredCount(TileCache* cache);
+
+// Copies the cached samples of a tile into heights (count samples).
+// Returns false on a miss.
+bool TileCache_Get(TileCache* cache, ChunkId id, int resolution, float* heights, int count);
+
+// Adds or refreshes a tile in memory (evicting the least recently used
+// tiles past the budget) and writes it through to the store
+void TileCache_Put(TileCache* cache, ChunkId id, int resolution, const float* heights, int count);
+
+void TileCache_Destroy(TileCache* cache); // Unmaps the store, its pages are flushed by the OS
+
+#endif // TILE_CACHE_H
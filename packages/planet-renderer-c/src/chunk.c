@@ -1,10 +1,26 @@
 #include "chunk.h"
+#include "chunk_batch.h"
+#include "chunk_gpu.h"
+#include "chunk_utils.h"
 #include "noise.h"
+#include "planet_trace.h"
+#include "tile_cache.h"
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
 #include <raymath.h>
 #include <stdio.h>
 #include "rlgl.h"
 
+// GL component types rlgl does not name
+#ifndef RL_SHORT
+#define RL_SHORT 0x1402          // GL_SHORT
+#endif
+#ifndef RL_UNSIGNED_SHORT
+#define RL_UNSIGNED_SHORT 0x1403 // GL_UNSIGNED_SHORT
+#endif
+
 Chunk* Chunk_Create(Vector3 offset, float width, float height, float radius, int resolution, Vector3 origin, Matrix localToWorld, float terrainFrequency, float terrainAmplitude) {
     Chunk* chunk = (Chunk*)malloc(sizeof(Chunk));
     chunk->offset = offset;
@@ -18,342 +34,956 @@ Chunk* Chunk_Create(Vector3 offset, float width, float height, float radius, int
     chunk->terrainAmplitude = terrainAmplitude;
     chunk->isUploaded = false;
     chunk->id = 0;
+    chunk->center = origin;
 
     // Initialize mesh to zero
-    chunk->mesh = (Mesh){ 0 };
-    chunk->model = (Model){ 0 };
+    chunk->vertices = NULL;
+    chunk->vertexCount = 0;
+    chunk->triangleCount = 0;
+    chunk->boundsMin = (Vector3){ 0 };
+    chunk->boundsExtent = (Vector3){ 0 };
+    chunk->parentError = -1.0f;
+    chunk->vaoId = 0;
+    chunk->vboId = 0;
+    chunk->gpuVertexCount = 0;
+    chunk->gpuResolution = 0;
+    chunk->heightAtlas = NULL;
+    chunk->heights = NULL;
+    chunk->heightCount = 0;
+    chunk->atlasSlot = -1;
+    chunk->gpuTerrain = false;
 
     // Initialize async generation state
     chunk->state = CHUNK_STATE_UNINITIALIZED;
+    chunk->epoch = 0;
+    chunk->jobEpoch = 0;
+    chunk->uploadQueue = NULL;
+    chunk->tileCache = NULL;
     pthread_mutex_init(&chunk->stateMutex, NULL);
+    chunk->nextFallback = NULL;
+    chunk->hasFallback = false;
+    chunk->isPrefetch = false;
+    chunk->owner = NULL;
+    chunk->poolNewer = NULL;
+    chunk->poolOlder = NULL;
+    chunk->bucketNext = NULL;
+    chunk->bucketPrev = NULL;
+    chunk->seamMask = 0;
+    chunk->lodMorphEnd = FLT_MAX;
 
     return chunk;
 }
 
-// Calculate normals from geometry using face normal averaging
-// This is CRITICAL for proper shadow mapping - normals must reflect actual terrain geometry!
-static void CalculateTerrainNormals(Mesh* mesh) {
-    // Initialize all normals to zero
-    for (int i = 0; i < mesh->vertexCount * 3; i++) {
-        mesh->normals[i] = 0.0f;
-    }
-
-    // For each triangle, calculate face normal and add to vertex normals
-    for (int i = 0; i < mesh->triangleCount; i++) {
-        unsigned short i0 = mesh->indices[i * 3];
-        unsigned short i1 = mesh->indices[i * 3 + 1];
-        unsigned short i2 = mesh->indices[i * 3 + 2];
-
-        // Get triangle vertices
-        Vector3 v0 = {
-            mesh->vertices[i0 * 3],
-            mesh->vertices[i0 * 3 + 1],
-            mesh->vertices[i0 * 3 + 2]
-        };
-        Vector3 v1 = {
-            mesh->vertices[i1 * 3],
-            mesh->vertices[i1 * 3 + 1],
-            mesh->vertices[i1 * 3 + 2]
-        };
-        Vector3 v2 = {
-            mesh->vertices[i2 * 3],
-            mesh->vertices[i2 * 3 + 1],
-            mesh->vertices[i2 * 3 + 2]
-        };
-
-        // Calculate edge vectors
-        Vector3 edge1 = Vector3Subtract(v1, v0);
-        Vector3 edge2 = Vector3Subtract(v2, v0);
-
-        // Calculate face normal (cross product)
-        Vector3 faceNormal = Vector3CrossProduct(edge1, edge2);
-
-        // Add face normal to each vertex of the triangle
-        mesh->normals[i0 * 3] += faceNormal.x;
-        mesh->normals[i0 * 3 + 1] += faceNormal.y;
-        mesh->normals[i0 * 3 + 2] += faceNormal.z;
-
-        mesh->normals[i1 * 3] += faceNormal.x;
-        mesh->normals[i1 * 3 + 1] += faceNormal.y;
-        mesh->normals[i1 * 3 + 2] += faceNormal.z;
-
-        mesh->normals[i2 * 3] += faceNormal.x;
-        mesh->normals[i2 * 3 + 1] += faceNormal.y;
-        mesh->normals[i2 * 3 + 2] += faceNormal.z;
-    }
-
-    // Normalize all vertex normals
-    for (int i = 0; i < mesh->vertexCount; i++) {
-        Vector3 normal = {
-            mesh->normals[i * 3],
-            mesh->normals[i * 3 + 1],
-            mesh->normals[i * 3 + 2]
-        };
-        normal = Vector3Normalize(normal);
-        mesh->normals[i * 3] = normal.x;
-        mesh->normals[i * 3 + 1] = normal.y;
-        mesh->normals[i * 3 + 2] = normal.z;
+// --- Shared index buffers ---
+// Every chunk of a given resolution uses the same triangulation, so one
+// element buffer per resolution is shared by all their VAOs. rlgl draws
+// 16-bit elements only: grids with more than 65536 vertices are split into
+// horizontal bands of quad rows, each indexed relative to its first vertex.
+//
+// Grids that fit one 16-bit range also get a skirt and one triangulation
+// per combination of edges stitched to a coarser neighbor, stored back to
+// back in the same buffer. A stitched edge skips its odd vertices, so its
+// triangles end exactly on the neighbor's edge (no T-junctions); the skirt
+// hangs below the edges and hides what quantization leaves open.
+
+typedef struct SharedIndexBuffer {
+    int resolution;
+    unsigned int eboId;
+    int refCount;
+    int indexCount;        // All variants
+    int variantOffset[16]; // First index of the triangulation for each seam mask
+    int variantCount[16];
+} SharedIndexBuffer;
+
+static SharedIndexBuffer* sharedIndexBuffers = NULL;
+static int sharedIndexBufferCount = 0;
+
+// Quad rows per 16-bit band
+static int GetBandRows(int resolution) {
+    int rows = 65536 / (resolution + 1) - 1;
+    return rows < resolution ? rows : resolution;
+}
+
+// Skirt ring (one row of vertices per edge) if grid and skirt fit 16 bits
+static int GetSkirtVertexCount(int resolution) {
+    int vertices = (resolution + 1) * (resolution + 5);
+    return vertices <= 65536 ? 4 * (resolution + 1) : 0;
+}
+
+// Grid vertex, with odd vertices of stitched edges moved onto the even one
+// before them (the resolution must be even)
+static int StitchedGridIndex(int res, int x, int y, int mask) {
+    if ((mask & CHUNK_ID_EDGE_NEG_Y) && y == 0) x &= ~1;
+    if ((mask & CHUNK_ID_EDGE_POS_Y) && y == res) x &= ~1;
+    if ((mask & CHUNK_ID_EDGE_NEG_X) && x == 0) y &= ~1;
+    if ((mask & CHUNK_ID_EDGE_POS_X) && x == res) y &= ~1;
+    return y * (res + 1) + x;
+}
+
+// Skirt vertices follow the grid, one run of res + 1 per edge in
+// CHUNK_ID_EDGE_* bit order
+static int StitchedSkirtIndex(int res, int edge, int t, int mask) {
+    if (mask & (1 << edge)) t &= ~1;
+    return (res + 1) * (res + 1) + edge * (res + 1) + t;
+}
+
+// Appends a triangle unless stitching collapsed it
+static int EmitTriangle(unsigned short* indices, int t, int a, int b, int c) {
+    if (a == b || b == c || a == c) return t;
+    indices[t++] = (unsigned short)a;
+    indices[t++] = (unsigned short)b;
+    indices[t++] = (unsigned short)c;
+    return t;
+}
+
+// Grid triangle unless stitching flattened it: where two stitched edges
+// meet, the corner quad can fold into a line, which would render as a
+// sliver of random orientation once displaced
+static int EmitGridTriangle(unsigned short* indices, int t, int res, int a, int b, int c) {
+    int stride = res + 1;
+    int ax = a % stride, ay = a / stride;
+    int cross = (b % stride - ax) * (c / stride - ay) - (c % stride - ax) * (b / stride - ay);
+    return cross != 0 ? EmitTriangle(indices, t, a, b, c) : t;
+}
+
+// Triangulation of the grid plus skirt for one seam mask, returns the index count
+static int BuildSeamVariant(unsigned short* indices, int res, int mask) {
+    int t = 0;
+    for (int y = 0; y < res; y++) {
+        for (int x = 0; x < res; x++) {
+            int topLeft = StitchedGridIndex(res, x, y, mask);
+            int topRight = StitchedGridIndex(res, x + 1, y, mask);
+            int bottomLeft = StitchedGridIndex(res, x, y + 1, mask);
+            int bottomRight = StitchedGridIndex(res, x + 1, y + 1, mask);
+            t = EmitGridTriangle(indices, t, res, topLeft, topRight, bottomLeft);
+            t = EmitGridTriangle(indices, t, res, topRight, bottomRight, bottomLeft);
+        }
+    }
+
+    // Skirt quads face away from the chunk, wound like the surface
+    for (int i = 0; i < res; i++) {
+        int p0, p1, s0, s1;
+        p0 = StitchedGridIndex(res, 0, i, mask); p1 = StitchedGridIndex(res, 0, i + 1, mask);
+        s0 = StitchedSkirtIndex(res, 0, i, mask); s1 = StitchedSkirtIndex(res, 0, i + 1, mask);
+        t = EmitTriangle(indices, t, p0, p1, s0);
+        t = EmitTriangle(indices, t, p1, s1, s0);
+
+        p0 = StitchedGridIndex(res, res, i, mask); p1 = StitchedGridIndex(res, res, i + 1, mask);
+        s0 = StitchedSkirtIndex(res, 1, i, mask); s1 = StitchedSkirtIndex(res, 1, i + 1, mask);
+        t = EmitTriangle(indices, t, p0, s0, p1);
+        t = EmitTriangle(indices, t, p1, s0, s1);
+
+        p0 = StitchedGridIndex(res, i, 0, mask); p1 = StitchedGridIndex(res, i + 1, 0, mask);
+        s0 = StitchedSkirtIndex(res, 2, i, mask); s1 = StitchedSkirtIndex(res, 2, i + 1, mask);
+        t = EmitTriangle(indices, t, p0, s0, p1);
+        t = EmitTriangle(indices, t, p1, s0, s1);
+
+        p0 = StitchedGridIndex(res, i, res, mask); p1 = StitchedGridIndex(res, i + 1, res, mask);
+        s0 = StitchedSkirtIndex(res, 3, i, mask); s1 = StitchedSkirtIndex(res, 3, i + 1, mask);
+        t = EmitTriangle(indices, t, p0, p1, s0);
+        t = EmitTriangle(indices, t, p1, s1, s0);
     }
+    return t;
 }
 
-void Chunk_Generate(Chunk* chunk) {
-    int res = chunk->resolution;
-    int numVertices = (res + 1) * (res + 1);
-    int numTriangles = res * res * 2;
-    
-    // Check if we need to reallocate
-    if (chunk->mesh.vertexCount != numVertices) {
-        // Free old if exists (Raylib UnloadMesh frees VRAM, but we also have CPU pointers)
-        // If we are reusing a chunk, we might have old data.
-        // For simplicity in this phase, let's assume if vertexCount matches, we reuse.
-        
-        if (chunk->mesh.vertices) free(chunk->mesh.vertices);
-        if (chunk->mesh.normals) free(chunk->mesh.normals);
-        if (chunk->mesh.texcoords) free(chunk->mesh.texcoords);
-        if (chunk->mesh.indices) free(chunk->mesh.indices);
-        
-        chunk->mesh.vertexCount = numVertices;
-        chunk->mesh.triangleCount = numTriangles;
-        
-        chunk->mesh.vertices = (float*)malloc(chunk->mesh.vertexCount * 3 * sizeof(float));
-        chunk->mesh.normals = (float*)malloc(chunk->mesh.vertexCount * 3 * sizeof(float));
-        chunk->mesh.texcoords = (float*)malloc(chunk->mesh.vertexCount * 2 * sizeof(float));
-        chunk->mesh.indices = (unsigned short*)malloc(chunk->mesh.triangleCount * 3 * sizeof(unsigned short));
-    }
-    
-    int vIndex = 0;
-    int tIndex = 0;
-    
-    for (int y = 0; y <= res; y++) {
-        for (int x = 0; x <= res; x++) {
-            float u = (float)x / res;
-            float v = (float)y / res;
-            
-            // Calculate position on the cube face
-            float px = chunk->offset.x + u * chunk->width;
-            float py = chunk->offset.y + v * chunk->height;
-            
-            // Local position on the face plane (z=0)
-            Vector3 localPos = { px, py, 0 };
-            
-            // Transform to world space (cube face in 3D)
-            Vector3 worldPos = Vector3Transform(localPos, chunk->localToWorld);
-            
-            // Normalize to project onto sphere
-            Vector3 normalized = Vector3Normalize(worldPos);
-
-            // Apply noise-based height variation for moon-like terrain
-            // Normalize to [0,1] range across entire face (-radius to +radius)
-            float faceSizeTotal = 2.0f * chunk->radius;
-            float normalizedX = (px + chunk->radius) / faceSizeTotal;
-            float normalizedY = (py + chunk->radius) / faceSizeTotal;
-
-            // Scale for appropriate noise frequency
-            // Lower scale = larger features visible
-            // For moon (1737km radius): scale of 15-20 gives realistic crater sizes
-            float noiseX = normalizedX * chunk->terrainFrequency;
-            float noiseY = normalizedY * chunk->terrainFrequency;
-            float heightNoise = MoonTerrain(noiseX, noiseY);
-
-            // Height scaling for realistic lunar features:
-            // - Maria vs Highlands: 1-3 km elevation difference
-            // - Large craters: several km deep
-            // - Total relief: ~5-8 km range
-            //
-            // MoonTerrain returns values roughly in range [-1.5, +1.5]
-            // terrainAmplitude controls the height variation
-            // Default 0.003 (~0.3% of radius) gives realistic scale for moon
-            float heightVariation = chunk->radius * chunk->terrainAmplitude * heightNoise;
-            
-            float adjustedRadius = chunk->radius + heightVariation;
-
-            // Scale by radius and add origin
-            Vector3 finalPos = Vector3Add(Vector3Scale(normalized, adjustedRadius), chunk->origin);
-            
-            chunk->mesh.vertices[vIndex * 3] = finalPos.x;
-            chunk->mesh.vertices[vIndex * 3 + 1] = finalPos.y;
-            chunk->mesh.vertices[vIndex * 3 + 2] = finalPos.z;
-
-            // Normals will be calculated from actual geometry after all vertices are generated
-            chunk->mesh.normals[vIndex * 3] = 0.0f;
-            chunk->mesh.normals[vIndex * 3 + 1] = 0.0f;
-            chunk->mesh.normals[vIndex * 3 + 2] = 0.0f;
-            
-            chunk->mesh.texcoords[vIndex * 2] = u;
-            chunk->mesh.texcoords[vIndex * 2 + 1] = v;
-            
-            // Indices
-            if (x < res && y < res) {
-                int topLeft = y * (res + 1) + x;
+void ChunkGpu_AcquireIndexBuffer(int resolution) {
+    for (int i = 0; i < sharedIndexBufferCount; i++) {
+        if (sharedIndexBuffers[i].resolution == resolution) {
+            sharedIndexBuffers[i].refCount++;
+            return;
+        }
+    }
+
+    sharedIndexBuffers = (SharedIndexBuffer*)realloc(sharedIndexBuffers, sizeof(SharedIndexBuffer) * (sharedIndexBufferCount + 1));
+    SharedIndexBuffer* buffer = &sharedIndexBuffers[sharedIndexBufferCount++];
+    buffer->resolution = resolution;
+    buffer->refCount = 1;
+
+    unsigned short* indices;
+    int indexCount = 0;
+    if (GetSkirtVertexCount(resolution) > 0) {
+        // Odd grids have no even vertices to stitch to: one variant only
+        int variants = (resolution % 2 == 0) ? 16 : 1;
+        int perVariant = (resolution * resolution + 4 * resolution) * 6;
+        indices = (unsigned short*)malloc((size_t)variants * perVariant * sizeof(unsigned short));
+        for (int mask = 0; mask < 16; mask++) {
+            if (mask >= variants) {
+                buffer->variantOffset[mask] = buffer->variantOffset[0];
+                buffer->variantCount[mask] = buffer->variantCount[0];
+                continue;
+            }
+            buffer->variantOffset[mask] = indexCount;
+            buffer->variantCount[mask] = BuildSeamVariant(indices + indexCount, resolution, mask);
+            indexCount += buffer->variantCount[mask];
+        }
+    } else {
+        // Build the triangulation of one band (the last band uses a prefix)
+        int bandRows = GetBandRows(resolution);
+        indices = (unsigned short*)malloc(bandRows * resolution * 6 * sizeof(unsigned short));
+        for (int y = 0; y < bandRows; y++) {
+            for (int x = 0; x < resolution; x++) {
+                int topLeft = y * (resolution + 1) + x;
                 int topRight = topLeft + 1;
-                int bottomLeft = (y + 1) * (res + 1) + x;
+                int bottomLeft = (y + 1) * (resolution + 1) + x;
                 int bottomRight = bottomLeft + 1;
-                
-                chunk->mesh.indices[tIndex * 3] = topLeft;
-                chunk->mesh.indices[tIndex * 3 + 1] = topRight;
-                chunk->mesh.indices[tIndex * 3 + 2] = bottomLeft;
-                
-                chunk->mesh.indices[tIndex * 3 + 3] = topRight;
-                chunk->mesh.indices[tIndex * 3 + 4] = bottomRight;
-                chunk->mesh.indices[tIndex * 3 + 5] = bottomLeft;
-                
-                tIndex += 2;
+                indexCount = EmitTriangle(indices, indexCount, topLeft, topRight, bottomLeft);
+                indexCount = EmitTriangle(indices, indexCount, topRight, bottomRight, bottomLeft);
             }
-            
-            vIndex++;
+        }
+        for (int mask = 0; mask < 16; mask++) {
+            buffer->variantOffset[mask] = 0;
+            buffer->variantCount[mask] = indexCount;
         }
     }
 
-    // Calculate terrain-aware normals from the actual geometry
-    // This is essential for correct shadow mapping and lighting
-    CalculateTerrainNormals(&chunk->mesh);
+    buffer->eboId = rlLoadVertexBufferElement(indices, indexCount * sizeof(unsigned short), false);
+    buffer->indexCount = indexCount;
+    free(indices);
+}
 
-    // Upload to GPU
-    if (chunk->isUploaded) {
-        // Prevent Raylib from freeing our CPU buffers which we want to reuse
-        // LoadModelFromMesh creates a copy of the mesh struct in model.meshes[0]
-        if (chunk->model.meshes) {
-            chunk->model.meshes[0].vertices = NULL;
-            chunk->model.meshes[0].normals = NULL;
-            chunk->model.meshes[0].texcoords = NULL;
-            chunk->model.meshes[0].indices = NULL;
+static const SharedIndexBuffer* GetSharedIndexBuffer(int resolution) {
+    for (int i = 0; i < sharedIndexBufferCount; i++) {
+        if (sharedIndexBuffers[i].resolution == resolution) return &sharedIndexBuffers[i];
+    }
+    return NULL;
+}
+
+unsigned int ChunkGpu_GetIndexBuffer(int resolution, int seamMask, int* firstIndex, int* indexCount) {
+    const SharedIndexBuffer* buffer = GetSharedIndexBuffer(resolution);
+    *firstIndex = buffer->variantOffset[seamMask & 15];
+    *indexCount = buffer->variantCount[seamMask & 15];
+    return buffer->eboId;
+}
+
+void ChunkGpu_ReleaseIndexBuffer(int resolution) {
+    for (int i = 0; i < sharedIndexBufferCount; i++) {
+        if (sharedIndexBuffers[i].resolution != resolution) continue;
+        if (--sharedIndexBuffers[i].refCount == 0) {
+            rlUnloadVertexBuffer(sharedIndexBuffers[i].eboId);
+            sharedIndexBuffers[i] = sharedIndexBuffers[--sharedIndexBufferCount];
+            if (sharedIndexBufferCount == 0) {
+                free(sharedIndexBuffers);
+                sharedIndexBuffers = NULL;
+            }
         }
-        
-        UnloadModel(chunk->model); 
-        
-        // Reset IDs so UploadMesh creates new VAO/VBOs
-        chunk->mesh.vaoId = 0;
-        chunk->mesh.vboId = 0;
-    }
-    
-    UploadMesh(&chunk->mesh, false);
-    chunk->model = LoadModelFromMesh(chunk->mesh);
-    chunk->isUploaded = true;
+        return;
+    }
 }
 
-void Chunk_Draw(Chunk* chunk, Color surfaceColor, Color wireframeColor, Shader lightingShader) {
-    if (chunk->isUploaded) {
-        // Apply lighting shader to the model's material
-        chunk->model.materials[0].shader = lightingShader;
+// --- Generation pipeline ---
+// Geometry is built in stages over structure-of-arrays batches, one
+// contiguous float array per component, so each stage is a plain loop the
+// compiler can vectorize:
+//   grid positions -> cube-to-sphere projection -> height sampling ->
+//   displacement -> normals -> morph offsets -> packing
+// The first four stages run on the vertex grid padded by one sample on each
+// side, (resolution + 3)^2 samples, so every border vertex has real
+// neighbors for its normal. The normal stage then compacts the interior to
+// the (resolution + 1)^2 vertex layout.
+// The arrays live in a per-thread workspace; only the packed vertices are
+// kept on the chunk.
 
-        // Draw with lighting
-        DrawModel(chunk->model, (Vector3){0,0,0}, 1.0f, surfaceColor);
+typedef struct ChunkBuildWorkspace {
+    int vertexCapacity; // Padded grid or vertices, whichever is larger
+    float* gridX;     // Face-plane coordinates
+    float* gridY;
+    float* noiseX;    // Noise domain coordinates
+    float* noiseY;
+    float* dirX;      // Unit sphere directions
+    float* dirY;
+    float* dirZ;
+    float* height;    // Noise value, then displaced radius
+    float* posX;      // World-space positions
+    float* posY;
+    float* posZ;
+    float* normalX;
+    float* normalY;
+    float* normalZ;
+    float* morph;     // Radial offset to the parent mesh
+} ChunkBuildWorkspace;
+
+static pthread_key_t workspaceKey;
+static pthread_once_t workspaceKeyOnce = PTHREAD_ONCE_INIT;
+
+static void FreeWorkspaceArrays(ChunkBuildWorkspace* ws) {
+    free(ws->gridX); free(ws->gridY);
+    free(ws->noiseX); free(ws->noiseY);
+    free(ws->dirX); free(ws->dirY); free(ws->dirZ);
+    free(ws->height);
+    free(ws->posX); free(ws->posY); free(ws->posZ);
+    free(ws->normalX); free(ws->normalY); free(ws->normalZ);
+    free(ws->morph);
+}
+
+static void DestroyWorkspace(void* data) {
+    ChunkBuildWorkspace* ws = (ChunkBuildWorkspace*)data;
+    FreeWorkspaceArrays(ws);
+    free(ws);
+}
 
-        // Draw wireframe (without shader for better visibility)
-        DrawModelWires(chunk->model, (Vector3){0,0,0}, 1.0f, wireframeColor);
+static void CreateWorkspaceKey(void) {
+    pthread_key_create(&workspaceKey, DestroyWorkspace);
+}
+
+static ChunkBuildWorkspace* GetBuildWorkspace(int resolution) {
+    pthread_once(&workspaceKeyOnce, CreateWorkspaceKey);
+
+    ChunkBuildWorkspace* ws = (ChunkBuildWorkspace*)pthread_getspecific(workspaceKey);
+    if (!ws) {
+        ws = (ChunkBuildWorkspace*)calloc(1, sizeof(ChunkBuildWorkspace));
+        pthread_setspecific(workspaceKey, ws);
+    }
+
+    // (res + 3)^2 >= (res + 1)^2 + 4 (res + 1), so the padded grid also
+    // covers the skirt, but keep both in case the skirt layout changes
+    int vertexCount = (resolution + 1) * (resolution + 1) + GetSkirtVertexCount(resolution);
+    int paddedCount = (resolution + 3) * (resolution + 3);
+    if (paddedCount > vertexCount) vertexCount = paddedCount;
+    if (vertexCount > ws->vertexCapacity) {
+        FreeWorkspaceArrays(ws);
+        size_t v = vertexCount * sizeof(float);
+        ws->gridX = (float*)malloc(v); ws->gridY = (float*)malloc(v);
+        ws->noiseX = (float*)malloc(v); ws->noiseY = (float*)malloc(v);
+        ws->dirX = (float*)malloc(v); ws->dirY = (float*)malloc(v); ws->dirZ = (float*)malloc(v);
+        ws->height = (float*)malloc(v);
+        ws->posX = (float*)malloc(v); ws->posY = (float*)malloc(v); ws->posZ = (float*)malloc(v);
+        ws->normalX = (float*)malloc(v); ws->normalY = (float*)malloc(v); ws->normalZ = (float*)malloc(v);
+        ws->morph = (float*)malloc(v);
+        ws->vertexCapacity = vertexCount;
     }
+    return ws;
 }
 
-void Chunk_DrawWithShadow(Chunk* chunk, Color surfaceColor, Color wireframeColor, Shader lightingShader, Texture2D shadowMap) {
-    if (chunk->isUploaded) {
-        // Apply lighting shader to the model's material
-        chunk->model.materials[0].shader = lightingShader;
+// Stage 1: padded grid positions on the cube face (x and y from -1 to
+// res + 1), plus the noise domain coordinates.
+// Noise is sampled in face space normalized to [0,1] over the entire face
+// (-radius to +radius) and scaled by the frequency: lower = larger features.
+// For moon (1737km radius): 15-20 gives realistic crater sizes.
+static void StageGridPositions(const Chunk* chunk, ChunkBuildWorkspace* ws) {
+    int res = chunk->resolution;
+    float stepX = chunk->width / res;
+    float stepY = chunk->height / res;
+    float noiseScale = chunk->terrainFrequency / (2.0f * chunk->radius);
+    int stride = res + 3;
+
+    for (int y = 0; y < stride; y++) {
+        float py = chunk->offset.y + (y - 1) * stepY;
+        float* gx = ws->gridX + y * stride;
+        float* gy = ws->gridY + y * stride;
+        float* nx = ws->noiseX + y * stride;
+        float* ny = ws->noiseY + y * stride;
+        for (int x = 0; x < stride; x++) {
+            float px = chunk->offset.x + (x - 1) * stepX;
+            gx[x] = px;
+            gy[x] = py;
+            nx[x] = (px + chunk->radius) * noiseScale;
+            ny[x] = (py + chunk->radius) * noiseScale;
+        }
+    }
+}
 
-        // NOTE: Shadow map textures are now bound globally for CSM
-        // We no longer bind them per-chunk to avoid conflicts with cascade textures
+// Stage 2: transform the face plane (z = 0) to world space and normalize
+// onto the unit sphere
+static void StageProjectToSphere(const Chunk* chunk, ChunkBuildWorkspace* ws, int count) {
+    const Matrix m = chunk->localToWorld;
+    const float* restrict gx = ws->gridX;
+    const float* restrict gy = ws->gridY;
+    float* restrict dx = ws->dirX;
+    float* restrict dy = ws->dirY;
+    float* restrict dz = ws->dirZ;
 
-        // Draw with lighting and shadows
-        DrawModel(chunk->model, (Vector3){0,0,0}, 1.0f, surfaceColor);
+    for (int i = 0; i < count; i++) {
+        float wx = m.m0 * gx[i] + m.m4 * gy[i] + m.m12;
+        float wy = m.m1 * gx[i] + m.m5 * gy[i] + m.m13;
+        float wz = m.m2 * gx[i] + m.m6 * gy[i] + m.m14;
+        float lengthSqr = wx * wx + wy * wy + wz * wz;
+        float inv = lengthSqr > 0.0f ? 1.0f / sqrtf(lengthSqr) : 0.0f;
+        dx[i] = wx * inv;
+        dy[i] = wy * inv;
+        dz[i] = wz * inv;
+    }
+}
 
-        // Draw wireframe (without shader for better visibility)
-        DrawModelWires(chunk->model, (Vector3){0,0,0}, 1.0f, wireframeColor);
+// Stage 3: sample the terrain height.
+// Height scaling for realistic lunar features:
+// - Maria vs Highlands: 1-3 km elevation difference
+// - Large craters: several km deep
+// - Total relief: ~5-8 km range
+// terrainAmplitude scales MoonTerrain relative to the radius
+// (0.003, ~0.3% of radius, gives realistic scale for moon)
+// Raw MoonTerrain samples go through the tile cache, so a tile seen before
+// skips the noise.
+static void StageSampleNoise(const Chunk* chunk, ChunkBuildWorkspace* ws, int count) {
+    TileCache* cache = chunk->tileCache;
+    if (!cache || !TileCache_Get(cache, chunk->id, chunk->resolution, ws->height, count)) {
+        MoonTerrainBatch(ws->noiseX, ws->noiseY, ws->height, count);
+        if (cache) TileCache_Put(cache, chunk->id, chunk->resolution, ws->height, count);
     }
 }
 
-// Async generation - only generates mesh data on CPU (no GPU upload)
-// This can be safely called from worker threads
-void Chunk_GenerateAsync(Chunk* chunk) {
-    pthread_mutex_lock(&chunk->stateMutex);
-    chunk->state = CHUNK_STATE_GENERATING;
-    pthread_mutex_unlock(&chunk->stateMutex);
+static void StageSampleHeight(const Chunk* chunk, ChunkBuildWorkspace* ws, int count) {
+    StageSampleNoise(chunk, ws, count);
+
+    float* restrict h = ws->height;
+    float amplitude = chunk->radius * chunk->terrainAmplitude;
+    for (int i = 0; i < count; i++) {
+        h[i] = chunk->radius + amplitude * h[i];
+    }
+}
+
+// Stage 4: displace along the sphere direction and add the planet origin
+static void StageDisplace(const Chunk* chunk, ChunkBuildWorkspace* ws, int count) {
+    const float* restrict dx = ws->dirX;
+    const float* restrict dy = ws->dirY;
+    const float* restrict dz = ws->dirZ;
+    const float* restrict h = ws->height;
+    float* restrict px = ws->posX;
+    float* restrict py = ws->posY;
+    float* restrict pz = ws->posZ;
+    Vector3 origin = chunk->origin;
 
+    for (int i = 0; i < count; i++) {
+        px[i] = dx[i] * h[i] + origin.x;
+        py[i] = dy[i] * h[i] + origin.y;
+        pz[i] = dz[i] * h[i] + origin.z;
+    }
+}
+
+// Stage 5: normals from the actual geometry by central differences over
+// the padded grid. This is CRITICAL for proper shadow mapping - normals must
+// reflect actual terrain geometry!
+// The normal at (x, y) is (P(x+1) - P(x-1)) x (P(y+1) - P(y-1)), which has
+// the winding of the index buffer. The padding ring samples the terrain past
+// the chunk border, so a border vertex sees what its neighbor chunk sees and
+// the two get the same normal, with no seam in the lighting.
+// Then the padded rows are compacted in place to the vertex layout. Each
+// row moves to a lower index, so going forward never clobbers unread data.
+static void StageNormals(const Chunk* chunk, ChunkBuildWorkspace* ws) {
     int res = chunk->resolution;
-    int numVertices = (res + 1) * (res + 1);
-    int numTriangles = res * res * 2;
+    int stride = res + 1; // Vertex row stride
+    int pstride = res + 3; // Padded row stride
+    const float* restrict px = ws->posX;
+    const float* restrict py = ws->posY;
+    const float* restrict pz = ws->posZ;
 
-    // Check if we need to reallocate
-    if (chunk->mesh.vertexCount != numVertices) {
-        // Free old if exists
-        if (chunk->mesh.vertices) free(chunk->mesh.vertices);
-        if (chunk->mesh.normals) free(chunk->mesh.normals);
-        if (chunk->mesh.texcoords) free(chunk->mesh.texcoords);
-        if (chunk->mesh.indices) free(chunk->mesh.indices);
+    for (int y = 0; y <= res; y++) {
+        int c = (y + 1) * pstride + 1; // Padded index of vertex (0, y)
+        float* restrict nx = ws->normalX + y * stride;
+        float* restrict ny = ws->normalY + y * stride;
+        float* restrict nz = ws->normalZ + y * stride;
 
-        chunk->mesh.vertexCount = numVertices;
-        chunk->mesh.triangleCount = numTriangles;
+        for (int x = 0; x <= res; x++) {
+            int i = c + x;
+            float ux = px[i + 1] - px[i - 1], uy = py[i + 1] - py[i - 1], uz = pz[i + 1] - pz[i - 1];
+            float vx = px[i + pstride] - px[i - pstride];
+            float vy = py[i + pstride] - py[i - pstride];
+            float vz = pz[i + pstride] - pz[i - pstride];
+            float sx = uy * vz - uz * vy;
+            float sy = uz * vx - ux * vz;
+            float sz = ux * vy - uy * vx;
+            float lengthSqr = sx * sx + sy * sy + sz * sz;
+            float inv = lengthSqr > 0.0f ? 1.0f / sqrtf(lengthSqr) : 0.0f;
+            nx[x] = sx * inv;
+            ny[x] = sy * inv;
+            nz[x] = sz * inv;
+        }
+    }
 
-        chunk->mesh.vertices = (float*)malloc(chunk->mesh.vertexCount * 3 * sizeof(float));
-        chunk->mesh.normals = (float*)malloc(chunk->mesh.vertexCount * 3 * sizeof(float));
-        chunk->mesh.texcoords = (float*)malloc(chunk->mesh.vertexCount * 2 * sizeof(float));
-        chunk->mesh.indices = (unsigned short*)malloc(chunk->mesh.triangleCount * 3 * sizeof(unsigned short));
+    // Positions, and directions for the skirts
+    float* compact[6] = { ws->posX, ws->posY, ws->posZ, ws->dirX, ws->dirY, ws->dirZ };
+    for (int k = 0; k < 6; k++) {
+        for (int y = 0; y <= res; y++) {
+            memmove(compact[k] + y * stride, compact[k] + (y + 1) * pstride + 1, stride * sizeof(float));
+        }
     }
+}
 
-    int vIndex = 0;
-    int tIndex = 0;
+// Stage 5b: geomorph offsets (see ChunkVertex). The parent tile's grid is
+// every other vertex of this one, so an odd vertex lies on an edge of a
+// parent triangle: between its even neighbors along x or y, or, for odd x
+// and y, on the diagonal from (x + 1, y - 1) to (x - 1, y + 1) that the
+// index buffer splits each quad along. The offset is how far the vertex
+// sits above that edge's midpoint, measured along the planet radius. The
+// largest one is the chunk's parentError.
+static void StageMorph(Chunk* chunk, ChunkBuildWorkspace* ws) {
+    int res = chunk->resolution;
+    int stride = res + 1;
+    float* restrict morph = ws->morph;
+    if (res % 2 != 0) {
+        // Odd grids do not contain the parent's vertices: no morphing
+        memset(morph, 0, stride * stride * sizeof(float));
+        chunk->parentError = -1.0f;
+        return;
+    }
 
-    // Generate vertices (same as before)
+    float maxOffset = 0.0f;
+    const float* restrict px = ws->posX;
+    const float* restrict py = ws->posY;
+    const float* restrict pz = ws->posZ;
+    Vector3 origin = chunk->origin;
     for (int y = 0; y <= res; y++) {
         for (int x = 0; x <= res; x++) {
-            float u = (float)x / res;
-            float v = (float)y / res;
+            int i = y * stride + x;
+            int a, b;
+            if (y % 2 == 0) {
+                if (x % 2 == 0) {
+                    morph[i] = 0.0f;
+                    continue;
+                }
+                a = i - 1; b = i + 1;
+            } else if (x % 2 == 0) {
+                a = i - stride; b = i + stride;
+            } else {
+                a = i - stride + 1; b = i + stride - 1;
+            }
+            float mx = 0.5f * (px[a] + px[b]) - origin.x;
+            float my = 0.5f * (py[a] + py[b]) - origin.y;
+            float mz = 0.5f * (pz[a] + pz[b]) - origin.z;
+            float vx = px[i] - origin.x, vy = py[i] - origin.y, vz = pz[i] - origin.z;
+            morph[i] = sqrtf(vx * vx + vy * vy + vz * vz) - sqrtf(mx * mx + my * my + mz * mz);
+            maxOffset = fmaxf(maxOffset, fabsf(morph[i]));
+        }
+    }
+    chunk->parentError = maxOffset;
+}
 
-            float px = chunk->offset.x + u * chunk->width;
-            float py = chunk->offset.y + v * chunk->height;
+// Stage 5c: skirt vertices, each edge vertex pushed toward the planet
+// center by CHUNK_SKIRT_DEPTH_CELLS cells, keeping the edge normal and
+// morph offset
 
-            Vector3 localPos = { px, py, 0 };
-            Vector3 worldPos = Vector3Transform(localPos, chunk->localToWorld);
-            Vector3 normalized = Vector3Normalize(worldPos);
+static void StageSkirts(const Chunk* chunk, ChunkBuildWorkspace* ws) {
+    int res = chunk->resolution;
+    int stride = res + 1;
+    float depth = CHUNK_SKIRT_DEPTH_CELLS * fmaxf(chunk->width, chunk->height) / res;
 
-            float faceSizeTotal = 2.0f * chunk->radius;
-            float normalizedX = (px + chunk->radius) / faceSizeTotal;
-            float normalizedY = (py + chunk->radius) / faceSizeTotal;
-            float noiseX = normalizedX * chunk->terrainFrequency;
-            float noiseY = normalizedY * chunk->terrainFrequency;
-            float heightNoise = MoonTerrain(noiseX, noiseY);
-            float heightVariation = chunk->radius * chunk->terrainAmplitude * heightNoise;
-            float adjustedRadius = chunk->radius + heightVariation;
+    for (int edge = 0; edge < 4; edge++) {
+        int dst = stride * stride + edge * stride;
+        for (int t = 0; t <= res; t++) {
+            int x = edge == 0 ? 0 : (edge == 1 ? res : t);
+            int y = edge == 2 ? 0 : (edge == 3 ? res : t);
+            int src = y * stride + x;
+            ws->posX[dst + t] = ws->posX[src] - ws->dirX[src] * depth;
+            ws->posY[dst + t] = ws->posY[src] - ws->dirY[src] * depth;
+            ws->posZ[dst + t] = ws->posZ[src] - ws->dirZ[src] * depth;
+            ws->normalX[dst + t] = ws->normalX[src];
+            ws->normalY[dst + t] = ws->normalY[src];
+            ws->normalZ[dst + t] = ws->normalZ[src];
+            ws->morph[dst + t] = ws->morph[src];
+        }
+    }
+}
 
-            Vector3 finalPos = Vector3Add(Vector3Scale(normalized, adjustedRadius), chunk->origin);
+static short PackSnorm16(float value) {
+    value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+    return (short)(value * 32767.0f + (value >= 0.0f ? 0.5f : -0.5f));
+}
 
-            chunk->mesh.vertices[vIndex * 3] = finalPos.x;
-            chunk->mesh.vertices[vIndex * 3 + 1] = finalPos.y;
-            chunk->mesh.vertices[vIndex * 3 + 2] = finalPos.z;
+// Stage 6: quantize positions to the chunk bounds and morph offsets to
+// +-length(boundsExtent) (unorm16), and encode normals octahedrally
+// (snorm16), matching DecodeOctNormal in the shaders. The offset of a
+// vertex inside the bounds to a point inside them is within that range.
+static void StagePack(Chunk* chunk, ChunkBuildWorkspace* ws, int count) {
+    const float* restrict px = ws->posX;
+    const float* restrict py = ws->posY;
+    const float* restrict pz = ws->posZ;
 
-            chunk->mesh.normals[vIndex * 3] = 0.0f;
-            chunk->mesh.normals[vIndex * 3 + 1] = 0.0f;
-            chunk->mesh.normals[vIndex * 3 + 2] = 0.0f;
+    float minX = px[0], minY = py[0], minZ = pz[0];
+    float maxX = px[0], maxY = py[0], maxZ = pz[0];
+    for (int i = 1; i < count; i++) {
+        minX = px[i] < minX ? px[i] : minX;
+        minY = py[i] < minY ? py[i] : minY;
+        minZ = pz[i] < minZ ? pz[i] : minZ;
+        maxX = px[i] > maxX ? px[i] : maxX;
+        maxY = py[i] > maxY ? py[i] : maxY;
+        maxZ = pz[i] > maxZ ? pz[i] : maxZ;
+    }
+    chunk->boundsMin = (Vector3){ minX, minY, minZ };
+    chunk->boundsExtent = (Vector3){ maxX - minX, maxY - minY, maxZ - minZ };
 
-            chunk->mesh.texcoords[vIndex * 2] = u;
-            chunk->mesh.texcoords[vIndex * 2 + 1] = v;
+    float scaleX = maxX > minX ? 65535.0f / (maxX - minX) : 0.0f;
+    float scaleY = maxY > minY ? 65535.0f / (maxY - minY) : 0.0f;
+    float scaleZ = maxZ > minZ ? 65535.0f / (maxZ - minZ) : 0.0f;
+    float morphRange = Vector3Length(chunk->boundsExtent);
+    float morphScale = morphRange > 0.0f ? 0.5f / morphRange : 0.0f;
 
-            // Indices
-            if (x < res && y < res) {
-                int topLeft = y * (res + 1) + x;
-                int topRight = topLeft + 1;
-                int bottomLeft = (y + 1) * (res + 1) + x;
-                int bottomRight = bottomLeft + 1;
+    for (int i = 0; i < count; i++) {
+        ChunkVertex* vertex = &chunk->vertices[i];
+        // Values are within [0, 65535] by construction of the bounds
+        vertex->position[0] = (unsigned short)((px[i] - minX) * scaleX + 0.5f);
+        vertex->position[1] = (unsigned short)((py[i] - minY) * scaleY + 0.5f);
+        vertex->position[2] = (unsigned short)((pz[i] - minZ) * scaleZ + 0.5f);
+        float morph = ws->morph[i] * morphScale + 0.5f;
+        morph = morph < 0.0f ? 0.0f : (morph > 1.0f ? 1.0f : morph);
+        vertex->morph = (unsigned short)(morph * 65535.0f + 0.5f);
+
+        // Project onto the octahedron, fold the lower hemisphere over the diagonals
+        float nx = ws->normalX[i], ny = ws->normalY[i], nz = ws->normalZ[i];
+        float l1 = fabsf(nx) + fabsf(ny) + fabsf(nz);
+        float inv = l1 > 0.0f ? 1.0f / l1 : 0.0f;
+        float ox = nx * inv;
+        float oy = ny * inv;
+        if (nz < 0.0f) {
+            float fx = (1.0f - fabsf(oy)) * (ox >= 0.0f ? 1.0f : -1.0f);
+            float fy = (1.0f - fabsf(ox)) * (oy >= 0.0f ? 1.0f : -1.0f);
+            ox = fx;
+            oy = fy;
+        }
+        vertex->normal[0] = PackSnorm16(ox);
+        vertex->normal[1] = PackSnorm16(oy);
+    }
+}
+
+int Chunk_GetHeightSampleCount(int resolution) {
+    return (resolution + 3) * (resolution + 3); // Padded grid, see StageNormals
+}
 
-                chunk->mesh.indices[tIndex * 3] = topLeft;
-                chunk->mesh.indices[tIndex * 3 + 1] = topRight;
-                chunk->mesh.indices[tIndex * 3 + 2] = bottomLeft;
+int Chunk_GetTriangleCount(int resolution) {
+    return resolution * resolution * 2 + (GetSkirtVertexCount(resolution) > 0 ? resolution * 8 : 0);
+}
+
+// Build the packed vertices on the CPU.
+// Safe on worker threads: touches no GPU state.
+static void BuildChunkGeometry(Chunk* chunk) {
+    int res = chunk->resolution;
+    int gridVertices = (res + 1) * (res + 1);
+    int paddedSamples = Chunk_GetHeightSampleCount(res);
+    int skirtVertices = GetSkirtVertexCount(res);
+    int numVertices = gridVertices + skirtVertices;
+    int numTriangles = Chunk_GetTriangleCount(res);
+
+    // Reuse the buffer when the chunk is recycled at the same resolution
+    if (chunk->vertexCount != numVertices) {
+        free(chunk->vertices);
+        chunk->vertices = (ChunkVertex*)malloc(numVertices * sizeof(ChunkVertex));
+    }
+    chunk->vertexCount = numVertices;
+    chunk->triangleCount = numTriangles;
+
+    ChunkBuildWorkspace* ws = GetBuildWorkspace(res);
+    StageGridPositions(chunk, ws);
+    StageProjectToSphere(chunk, ws, paddedSamples);
+    StageSampleHeight(chunk, ws, paddedSamples);
+    StageDisplace(chunk, ws, paddedSamples);
+    StageNormals(chunk, ws);
+    StageMorph(chunk, ws);
+    if (skirtVertices > 0) StageSkirts(chunk, ws);
+    StagePack(chunk, ws, numVertices);
+}
 
-                chunk->mesh.indices[tIndex * 3 + 3] = topRight;
-                chunk->mesh.indices[tIndex * 3 + 4] = bottomRight;
-                chunk->mesh.indices[tIndex * 3 + 5] = bottomLeft;
+// parentError of a height grid, as StageMorph measures it on the mesh: the
+// height above the midpoint of the parent edge under each odd vertex, plus
+// how far the chord of that edge sags below the sphere. The longest parent
+// edge, a cell diagonal, spans 2 * sqrt(2) steps of the face plane, and no
+// more on the sphere.
+static float GetHeightParentError(const Chunk* chunk, const float* heights) {
+    int res = chunk->resolution;
+    if (res % 2 != 0) return -1.0f;
 
-                tIndex += 2;
+    int pstride = res + 3;
+    float maxOffset = 0.0f;
+    for (int y = 0; y <= res; y++) {
+        const float* row = heights + (y + 1) * pstride + 1; // Vertex (0, y)
+        for (int x = y % 2 == 0 ? 1 : 0; x <= res; x += y % 2 == 0 ? 2 : 1) {
+            float mid;
+            if (y % 2 == 0) {
+                mid = 0.5f * (row[x - 1] + row[x + 1]);
+            } else if (x % 2 == 0) {
+                mid = 0.5f * (row[x - pstride] + row[x + pstride]);
+            } else {
+                mid = 0.5f * (row[x - pstride + 1] + row[x + pstride - 1]);
             }
+            maxOffset = fmaxf(maxOffset, fabsf(row[x] - mid));
+        }
+    }
+    float edge = 2.0f * fmaxf(chunk->width, chunk->height) / res * sqrtf(2.0f);
+    return maxOffset + edge * edge / (8.0f * chunk->radius);
+}
+
+// Instanced chunks only keep the padded height grid; the vertex shader
+// projects, displaces and shades it (see chunk_batch.h). With GPU terrain
+// the upload renders the grid, there is nothing to build.
+static void BuildChunkHeights(Chunk* chunk) {
+    int res = chunk->resolution;
+    if (chunk->gpuTerrain) {
+        chunk->triangleCount = Chunk_GetTriangleCount(res);
+        chunk->parentError = -1.0f;
+        return;
+    }
+
+    int count = Chunk_GetHeightSampleCount(res);
+    if (chunk->heightCount != count) {
+        free(chunk->heights);
+        chunk->heights = (float*)malloc(count * sizeof(float));
+        chunk->heightCount = count;
+    }
+    chunk->triangleCount = Chunk_GetTriangleCount(res);
+
+    ChunkBuildWorkspace* ws = GetBuildWorkspace(res);
+    StageGridPositions(chunk, ws);
+    StageSampleNoise(chunk, ws, count);
+
+    float amplitude = chunk->radius * chunk->terrainAmplitude;
+    for (int i = 0; i < count; i++) {
+        chunk->heights[i] = amplitude * ws->height[i];
+    }
+    chunk->parentError = GetHeightParentError(chunk, chunk->heights);
+}
+
+static void BuildChunk(Chunk* chunk) {
+    if (chunk->heightAtlas) {
+        BuildChunkHeights(chunk);
+    } else {
+        BuildChunkGeometry(chunk);
+    }
+}
+
+// --- GPU buffers ---
+
+static void SetChunkVertexAttributes(int firstVertex) {
+    int stride = sizeof(ChunkVertex);
+    int base = firstVertex * stride;
+    rlSetVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION, 4, RL_UNSIGNED_SHORT, true, stride, base); // Position and morph
+    rlSetVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_NORMAL, 2, RL_SHORT, true, stride, base + 8);
+}
+
+static void UnloadChunkBuffers(Chunk* chunk) {
+    if (chunk->atlasSlot >= 0) {
+        ChunkHeightAtlas_Release(chunk->heightAtlas, chunk);
+    } else {
+        rlUnloadVertexArray(chunk->vaoId);
+        rlUnloadVertexBuffer(chunk->vboId);
+        ChunkGpu_ReleaseIndexBuffer(chunk->gpuResolution);
+    }
+
+    chunk->vaoId = 0;
+    chunk->vboId = 0;
+    chunk->gpuVertexCount = 0;
+    chunk->gpuResolution = 0;
+    chunk->isUploaded = false;
+}
+
+static void UploadChunkVertices(Chunk* chunk) {
+    int size = chunk->vertexCount * sizeof(ChunkVertex);
+
+    // An uploaded chunk rebuilt at the same size rewrites its VBO in place
+    if (chunk->isUploaded && chunk->gpuVertexCount == chunk->vertexCount && chunk->gpuResolution == chunk->resolution) {
+        rlUpdateVertexBuffer(chunk->vboId, chunk->vertices, size, 0);
+        return;
+    }
+
+    if (chunk->isUploaded) {
+        UnloadChunkBuffers(chunk);
+    }
+
+    ChunkGpu_AcquireIndexBuffer(chunk->resolution);
+
+    chunk->vaoId = rlLoadVertexArray();
+    rlEnableVertexArray(chunk->vaoId);
+
+    // Dynamic buffer: a rebuilt chunk rewrites it in place
+    chunk->vboId = rlLoadVertexBuffer(chunk->vertices, size, true);
+    SetChunkVertexAttributes(0);
+    rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION);
+    rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_NORMAL);
+
+    // The element buffer binding is part of the VAO state
+    rlEnableVertexBufferElement(GetSharedIndexBuffer(chunk->resolution)->eboId);
+    rlDisableVertexArray();
+
+    chunk->gpuVertexCount = chunk->vertexCount;
+    chunk->gpuResolution = chunk->resolution;
+    chunk->isUploaded = true;
+}
+
+static void UploadChunk(Chunk* chunk) {
+    if (chunk->heightAtlas) {
+        ChunkHeightAtlas_Upload(chunk->heightAtlas, chunk);
+    } else {
+        UploadChunkVertices(chunk);
+    }
+}
+
+int Chunk_GetUploadSize(const Chunk* chunk) {
+    if (chunk->heightAtlas) return Chunk_GetHeightSampleCount(chunk->resolution) * sizeof(float);
+    return chunk->vertexCount * sizeof(ChunkVertex);
+}
+
+// --- Drawing ---
+
+static ChunkShaderLocations* shaderLocations = NULL;
+static int shaderLocationCount = 0;
+
+// Chunk_SetLodMorph state, disabled until set
+static Vector3 lodCamera = { 0 };
+static float lodMorphStart = 1.0f;
+
+void Chunk_SetLodMorph(Vector3 camera, float morphStart) {
+    lodCamera = camera;
+    lodMorphStart = morphStart;
+}
+
+void ChunkGpu_SetMorphUniforms(const ChunkShaderLocations* locs) {
+    if (locs->lodCamera != -1) rlSetUniform(locs->lodCamera, &lodCamera, SHADER_UNIFORM_VEC3, 1);
+    if (locs->lodMorphStart != -1) rlSetUniform(locs->lodMorphStart, &lodMorphStart, SHADER_UNIFORM_FLOAT, 1);
+}
+
+const ChunkShaderLocations* ChunkGpu_GetShaderLocations(Shader shader) {
+    ChunkShaderLocations* locs = NULL;
+    for (int i = 0; i < shaderLocationCount; i++) {
+        if (shaderLocations[i].shaderId != shader.id) continue;
+        if (shaderLocations[i].shaderLocs == shader.locs) return &shaderLocations[i];
+        // Same program id, new shader: the old one was unloaded, query again
+        locs = &shaderLocations[i];
+        break;
+    }
+
+    if (!locs) {
+        shaderLocations = (ChunkShaderLocations*)realloc(shaderLocations, sizeof(ChunkShaderLocations) * (shaderLocationCount + 1));
+        locs = &shaderLocations[shaderLocationCount++];
+    }
+    locs->shaderId = shader.id;
+    locs->shaderLocs = shader.locs;
+    locs->chunkOrigin = GetShaderLocation(shader, "chunkOrigin");
+    locs->chunkExtent = GetShaderLocation(shader, "chunkExtent");
+    locs->chunkResolution = GetShaderLocation(shader, "chunkResolution");
+    locs->chunkFirstVertex = GetShaderLocation(shader, "chunkFirstVertex");
+    locs->chunkInstanced = GetShaderLocation(shader, "chunkInstanced");
+    locs->heightAtlas = GetShaderLocation(shader, "heightAtlas");
+    locs->planetRadius = GetShaderLocation(shader, "planetRadius");
+    locs->planetOrigin = GetShaderLocation(shader, "planetOrigin");
+    locs->lodCamera = GetShaderLocation(shader, "lodCamera");
+    locs->lodMorphStart = GetShaderLocation(shader, "lodMorphStart");
+    locs->chunkMorphEnd = GetShaderLocation(shader, "chunkMorphEnd");
+    locs->instanceCorner = GetShaderLocationAttrib(shader, "instanceCorner");
+    locs->instanceAxisU = GetShaderLocationAttrib(shader, "instanceAxisU");
+    locs->instanceAxisV = GetShaderLocationAttrib(shader, "instanceAxisV");
+    locs->instanceLod = GetShaderLocationAttrib(shader, "instanceLod");
+    return locs;
+}
 
-            vIndex++;
+void ChunkGpu_BeginShader(Shader shader, Color color) {
+    Matrix matModel = rlGetMatrixTransform();
+    Matrix matView = rlGetMatrixModelview();
+    Matrix matProjection = rlGetMatrixProjection();
+    Matrix mvp = MatrixMultiply(MatrixMultiply(matModel, matView), matProjection);
+
+    rlEnableShader(shader.id);
+
+    if (shader.locs[SHADER_LOC_MATRIX_MVP] != -1) rlSetUniformMatrix(shader.locs[SHADER_LOC_MATRIX_MVP], mvp);
+    if (shader.locs[SHADER_LOC_MATRIX_VIEW] != -1) rlSetUniformMatrix(shader.locs[SHADER_LOC_MATRIX_VIEW], matView);
+    if (shader.locs[SHADER_LOC_MATRIX_PROJECTION] != -1) rlSetUniformMatrix(shader.locs[SHADER_LOC_MATRIX_PROJECTION], matProjection);
+    if (shader.locs[SHADER_LOC_MATRIX_MODEL] != -1) rlSetUniformMatrix(shader.locs[SHADER_LOC_MATRIX_MODEL], matModel);
+    if (shader.locs[SHADER_LOC_MATRIX_NORMAL] != -1) rlSetUniformMatrix(shader.locs[SHADER_LOC_MATRIX_NORMAL], MatrixTranspose(MatrixInvert(matModel)));
+    if (shader.locs[SHADER_LOC_COLOR_DIFFUSE] != -1) {
+        float diffuse[4] = { color.r / 255.0f, color.g / 255.0f, color.b / 255.0f, color.a / 255.0f };
+        rlSetUniform(shader.locs[SHADER_LOC_COLOR_DIFFUSE], diffuse, SHADER_UNIFORM_VEC4, 1);
+    }
+}
+
+// Equivalent of DrawMesh for the packed chunk layout, returns the draw calls
+static int DrawChunkGeometry(Chunk* chunk, Shader shader, Color color) {
+    const ChunkShaderLocations* locs = ChunkGpu_GetShaderLocations(shader);
+    ChunkGpu_BeginShader(shader, color);
+
+    int instanced = 0;
+    if (locs->chunkInstanced != -1) rlSetUniform(locs->chunkInstanced, &instanced, SHADER_UNIFORM_INT, 1);
+    if (locs->chunkOrigin != -1) rlSetUniform(locs->chunkOrigin, &chunk->boundsMin, SHADER_UNIFORM_VEC3, 1);
+    if (locs->chunkExtent != -1) rlSetUniform(locs->chunkExtent, &chunk->boundsExtent, SHADER_UNIFORM_VEC3, 1);
+    if (locs->chunkResolution != -1) rlSetUniform(locs->chunkResolution, &chunk->gpuResolution, SHADER_UNIFORM_INT, 1);
+    if (locs->chunkMorphEnd != -1) rlSetUniform(locs->chunkMorphEnd, &chunk->lodMorphEnd, SHADER_UNIFORM_FLOAT, 1);
+    if (locs->planetRadius != -1) rlSetUniform(locs->planetRadius, &chunk->radius, SHADER_UNIFORM_FLOAT, 1);
+    if (locs->planetOrigin != -1) rlSetUniform(locs->planetOrigin, &chunk->origin, SHADER_UNIFORM_VEC3, 1);
+    ChunkGpu_SetMorphUniforms(locs);
+
+    rlEnableVertexArray(chunk->vaoId);
+
+    int res = chunk->gpuResolution;
+    int bandRows = GetBandRows(res);
+    int draws = 0;
+    if (bandRows >= res) {
+        const SharedIndexBuffer* indices = GetSharedIndexBuffer(res);
+        int mask = chunk->seamMask & 15;
+        int firstVertex = 0;
+        if (locs->chunkFirstVertex != -1) rlSetUniform(locs->chunkFirstVertex, &firstVertex, SHADER_UNIFORM_INT, 1);
+        rlDrawVertexArrayElements(indices->variantOffset[mask], indices->variantCount[mask], 0);
+        draws++;
+    } else {
+        // Emulate base-vertex draws: each band re-points the attributes at its first row
+        rlEnableVertexBuffer(chunk->vboId);
+        for (int row = 0; row < res; row += bandRows) {
+            int rows = (res - row) < bandRows ? (res - row) : bandRows;
+            int firstVertex = row * (res + 1);
+            SetChunkVertexAttributes(firstVertex);
+            if (locs->chunkFirstVertex != -1) rlSetUniform(locs->chunkFirstVertex, &firstVertex, SHADER_UNIFORM_INT, 1);
+            rlDrawVertexArrayElements(0, rows * res * 6, 0);
+            draws++;
         }
+        SetChunkVertexAttributes(0);
+        rlDisableVertexBuffer();
+    }
+
+    rlDisableVertexArray();
+    rlDisableShader();
+    return draws;
+}
+
+void Chunk_Generate(Chunk* chunk) {
+    BuildChunk(chunk);
+
+    // Upload to GPU
+    UploadChunk(chunk);
+}
+
+int Chunk_Draw(Chunk* chunk, Color surfaceColor, Color wireframeColor, Shader lightingShader) {
+    int draws = 0;
+    // Instanced chunks have no VBO, ChunkBatch draws them
+    if (chunk->isUploaded && !chunk->heightAtlas) {
+        // Draw with lighting
+        draws += DrawChunkGeometry(chunk, lightingShader, surfaceColor);
+
+        // Draw wireframe over the surface
+        rlEnableWireMode();
+        draws += DrawChunkGeometry(chunk, lightingShader, wireframeColor);
+        rlDisableWireMode();
+    }
+    return draws;
+}
+
+int Chunk_DrawWithShadow(Chunk* chunk, Color surfaceColor, Color wireframeColor, Shader lightingShader, Texture2D shadowMap) {
+    // NOTE: Shadow map textures are now bound globally for CSM
+    // We no longer bind them per-chunk to avoid conflicts with cascade textures
+    return Chunk_Draw(chunk, surfaceColor, wireframeColor, lightingShader);
+}
+
+// Async generation - only generates mesh data on CPU (no GPU upload)
+// This can be safely called from worker threads
+void Chunk_GenerateAsync(Chunk* chunk) {
+    pthread_mutex_lock(&chunk->stateMutex);
+    if (chunk->epoch != chunk->jobEpoch) {
+        // Retired before the job started: nothing to build
+        chunk->state = CHUNK_STATE_UNINITIALIZED;
+        pthread_mutex_unlock(&chunk->stateMutex);
+        return;
     }
+    chunk->state = CHUNK_STATE_GENERATING;
+    unsigned int epoch = chunk->jobEpoch;
+    pthread_mutex_unlock(&chunk->stateMutex);
 
-    // Calculate normals
-    CalculateTerrainNormals(&chunk->mesh);
+    double buildStart = PLANET_STATS_NOW();
+    BuildChunk(chunk);
+    if (!chunk->gpuTerrain) PLANET_TRACE_SPAN("BuildChunk", buildStart); // GPU terrain builds nothing here
 
-    // Mark as ready for GPU upload
+    // Mark as ready and post in one step, unless the chunk was retired
+    // meanwhile. Once the state leaves GENERATING the main thread may
+    // recycle the chunk, so nothing here touches it after the unlock.
     pthread_mutex_lock(&chunk->stateMutex);
-    chunk->state = CHUNK_STATE_READY_TO_UPLOAD;
+    if (chunk->epoch != epoch) {
+        chunk->state = CHUNK_STATE_UNINITIALIZED;
+    } else {
+        chunk->state = CHUNK_STATE_READY_TO_UPLOAD;
+        PLANET_STATS_ONLY(chunk->readyTime = PlanetStats_Now());
+        if (chunk->uploadQueue) ChunkUploadQueue_Push(chunk->uploadQueue, chunk, epoch);
+    }
     pthread_mutex_unlock(&chunk->stateMutex);
 }
 
@@ -368,24 +998,7 @@ void Chunk_UploadToGPU(Chunk* chunk) {
 
     pthread_mutex_unlock(&chunk->stateMutex);
 
-    // Same GPU upload logic as before
-    if (chunk->isUploaded) {
-        if (chunk->model.meshes) {
-            chunk->model.meshes[0].vertices = NULL;
-            chunk->model.meshes[0].normals = NULL;
-            chunk->model.meshes[0].texcoords = NULL;
-            chunk->model.meshes[0].indices = NULL;
-        }
-
-        UnloadModel(chunk->model);
-
-        chunk->mesh.vaoId = 0;
-        chunk->mesh.vboId = 0;
-    }
-
-    UploadMesh(&chunk->mesh, false);
-    chunk->model = LoadModelFromMesh(chunk->mesh);
-    chunk->isUploaded = true;
+    UploadChunk(chunk);
 
     pthread_mutex_lock(&chunk->stateMutex);
     chunk->state = CHUNK_STATE_UPLOADED;
@@ -400,16 +1013,95 @@ ChunkState Chunk_GetState(Chunk* chunk) {
     return state;
 }
 
+void Chunk_MarkObsolete(Chunk* chunk) {
+    pthread_mutex_lock(&chunk->stateMutex);
+    chunk->epoch++;
+    if (chunk->state == CHUNK_STATE_READY_TO_UPLOAD) {
+        chunk->state = CHUNK_STATE_UNINITIALIZED;
+    }
+    // PENDING/GENERATING: the worker sees the new epoch and drops its result
+    pthread_mutex_unlock(&chunk->stateMutex);
+}
+
+void Chunk_QueueGeneration(Chunk* chunk) {
+    pthread_mutex_lock(&chunk->stateMutex);
+    chunk->state = CHUNK_STATE_PENDING;
+    chunk->jobEpoch = chunk->epoch;
+    PLANET_STATS_ONLY(chunk->queuedTime = PlanetStats_Now());
+    pthread_mutex_unlock(&chunk->stateMutex);
+}
+
+bool Chunk_IsJobInFlight(Chunk* chunk) {
+    ChunkState state = Chunk_GetState(chunk);
+    return state == CHUNK_STATE_PENDING || state == CHUNK_STATE_GENERATING;
+}
+
+size_t Chunk_GetCPUBytes(Chunk* chunk) {
+    // A running job may be reallocating the buffer: count the size it builds
+    if (Chunk_IsJobInFlight(chunk)) {
+        if (chunk->gpuTerrain) return sizeof(Chunk);
+        if (chunk->heightAtlas) return sizeof(Chunk) + (size_t)Chunk_GetHeightSampleCount(chunk->resolution) * sizeof(float);
+        int vertexCount = (chunk->resolution + 1) * (chunk->resolution + 1) + GetSkirtVertexCount(chunk->resolution);
+        return sizeof(Chunk) + (size_t)vertexCount * sizeof(ChunkVertex);
+    }
+    return sizeof(Chunk) + (chunk->vertices ? (size_t)chunk->vertexCount * sizeof(ChunkVertex) : 0) +
+           (size_t)chunk->heightCount * sizeof(float);
+}
+
+size_t Chunk_GetGPUBytes(const Chunk* chunk) {
+    if (!chunk->isUploaded) return 0;
+    if (chunk->atlasSlot >= 0) return (size_t)Chunk_GetHeightSampleCount(chunk->resolution) * sizeof(float);
+    return (size_t)chunk->gpuVertexCount * sizeof(ChunkVertex);
+}
+
+size_t Chunk_GetSharedIndexBytes(void) {
+    size_t bytes = 0;
+    for (int i = 0; i < sharedIndexBufferCount; i++) {
+        bytes += (size_t)sharedIndexBuffers[i].indexCount * sizeof(unsigned short);
+    }
+    return bytes;
+}
+
+void Chunk_ReleaseGPU(Chunk* chunk) {
+    if (!chunk->isUploaded) return;
+    UnloadChunkBuffers(chunk);
+
+    // The CPU mesh is intact, it only needs uploading again
+    pthread_mutex_lock(&chunk->stateMutex);
+    if (chunk->state == CHUNK_STATE_UPLOADED) chunk->state = CHUNK_STATE_READY_TO_UPLOAD;
+    pthread_mutex_unlock(&chunk->stateMutex);
+}
+
+void Chunk_SetHeightAtlas(Chunk* chunk, ChunkHeightAtlas* atlas, bool gpuTerrain) {
+    gpuTerrain = gpuTerrain && atlas;
+    if (chunk->heightAtlas == atlas && chunk->gpuTerrain == gpuTerrain) return;
+    if (chunk->isUploaded) UnloadChunkBuffers(chunk);
+
+    // The mesh of the other mode is of no use any more
+    free(chunk->vertices);
+    chunk->vertices = NULL;
+    chunk->vertexCount = 0;
+    free(chunk->heights);
+    chunk->heights = NULL;
+    chunk->heightCount = 0;
+    chunk->heightAtlas = atlas;
+    chunk->gpuTerrain = gpuTerrain;
+
+    pthread_mutex_lock(&chunk->stateMutex);
+    if (chunk->state == CHUNK_STATE_READY_TO_UPLOAD || chunk->state == CHUNK_STATE_UPLOADED) {
+        chunk->state = CHUNK_STATE_UNINITIALIZED;
+    }
+    pthread_mutex_unlock(&chunk->stateMutex);
+}
+
 void Chunk_Free(Chunk* chunk) {
     if (chunk->isUploaded) {
-        UnloadModel(chunk->model); // Unloads GPU data
+        UnloadChunkBuffers(chunk); // Unloads GPU data
     }
 
     // Free CPU data
-    if (chunk->mesh.vertices) free(chunk->mesh.vertices);
-    if (chunk->mesh.normals) free(chunk->mesh.normals);
-    if (chunk->mesh.texcoords) free(chunk->mesh.texcoords);
-    if (chunk->mesh.indices) free(chunk->mesh.indices);
+    free(chunk->vertices);
+    free(chunk->heights);
 
     pthread_mutex_destroy(&chunk->stateMutex);
 
@@ -0,0 +1,402 @@
+#include "chunk_batch.h"
+#include "chunk_gpu.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "rlgl.h"
+
+#ifndef RL_FLOAT
+#define RL_FLOAT 0x1406 // GL_FLOAT
+#endif
+
+#define CHUNK_BATCH_ATLAS_MAX_HEIGHT 16384 // Texels, a safe texture size on desktop GL 3.3
+#define CHUNK_BATCH_INITIAL_SLOTS 512
+
+// --- Height atlas ---
+
+static void InitAtlas(ChunkHeightAtlas* atlas, ChunkBatch* batch, int resolution) {
+    atlas->batch = batch;
+    atlas->resolution = resolution;
+    atlas->slotSize = resolution + 3;
+    atlas->slotsPerRow = CHUNK_BATCH_ATLAS_WIDTH / atlas->slotSize;
+    atlas->capacity = 0;
+    atlas->textureId = 0;
+    atlas->textureHeight = 0;
+    atlas->fboId = 0;
+    atlas->owners = NULL;
+    atlas->freeSlots = NULL;
+    atlas->freeCount = 0;
+}
+
+static void GetSlotOrigin(const ChunkHeightAtlas* atlas, int slot, int* x, int* y) {
+    *x = (slot % atlas->slotsPerRow) * atlas->slotSize;
+    *y = (slot / atlas->slotsPerRow) * atlas->slotSize;
+}
+
+// Terrain pass over one slot: the viewport covers the slot texels and the
+// shader evaluates one padded sample per fragment
+static void RenderSlotTerrain(ChunkHeightAtlas* atlas, const Chunk* chunk, int x, int y) {
+    ChunkBatch* batch = atlas->batch;
+    if (atlas->fboId == 0) {
+        atlas->fboId = rlLoadFramebuffer();
+        rlFramebufferAttach(atlas->fboId, atlas->textureId, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_TEXTURE2D, 0);
+    }
+    if (batch->terrainVaoId == 0) batch->terrainVaoId = rlLoadVertexArray();
+
+    rlDrawRenderBatchActive(); // Pending rlgl geometry belongs to the current target
+    rlEnableFramebuffer(atlas->fboId);
+    rlViewport(x, y, atlas->slotSize, atlas->slotSize);
+    rlDisableColorBlend(); // The slot's old texels may be NaN: replace, never blend
+
+    rlEnableShader(batch->terrainShader.id);
+    int slotOrigin[2] = { x, y };
+    float offset[2] = { chunk->offset.x, chunk->offset.y };
+    float step[2] = { chunk->width / chunk->resolution, chunk->height / chunk->resolution };
+    float noiseScale = chunk->terrainFrequency / (2.0f * chunk->radius);
+    float amplitude = chunk->radius * chunk->terrainAmplitude;
+    rlSetUniform(batch->terrainSlotOriginLoc, slotOrigin, RL_SHADER_UNIFORM_IVEC2, 1);
+    rlSetUniform(batch->terrainOffsetLoc, offset, RL_SHADER_UNIFORM_VEC2, 1);
+    rlSetUniform(batch->terrainStepLoc, step, RL_SHADER_UNIFORM_VEC2, 1);
+    rlSetUniform(batch->terrainRadiusLoc, &chunk->radius, RL_SHADER_UNIFORM_FLOAT, 1);
+    rlSetUniform(batch->terrainNoiseScaleLoc, &noiseScale, RL_SHADER_UNIFORM_FLOAT, 1);
+    rlSetUniform(batch->terrainAmplitudeLoc, &amplitude, RL_SHADER_UNIFORM_FLOAT, 1);
+
+    rlEnableVertexArray(batch->terrainVaoId);
+    rlDrawVertexArray(0, 3);
+    rlDisableVertexArray();
+    rlDisableShader();
+
+    rlEnableColorBlend();
+    rlDisableFramebuffer();
+    rlViewport(0, 0, rlGetFramebufferWidth(), rlGetFramebufferHeight());
+}
+
+static void WriteSlot(ChunkHeightAtlas* atlas, const Chunk* chunk) {
+    int x, y;
+    GetSlotOrigin(atlas, chunk->atlasSlot, &x, &y);
+    if (chunk->gpuTerrain) {
+        RenderSlotTerrain(atlas, chunk, x, y);
+    } else {
+        rlUpdateTexture(atlas->textureId, x, y, atlas->slotSize, atlas->slotSize, RL_PIXELFORMAT_UNCOMPRESSED_R32, chunk->heights);
+    }
+}
+
+// Doubles the slot rows (or creates the texture). The new texture starts
+// empty, so the resident chunks are written again: uploaded from their CPU
+// heights, or rendered anew for GPU terrain.
+static bool GrowAtlas(ChunkHeightAtlas* atlas) {
+    int rows = atlas->capacity > 0
+        ? 2 * (atlas->capacity / atlas->slotsPerRow)
+        : (CHUNK_BATCH_INITIAL_SLOTS + atlas->slotsPerRow - 1) / atlas->slotsPerRow;
+    if (rows * atlas->slotSize > CHUNK_BATCH_ATLAS_MAX_HEIGHT) rows = CHUNK_BATCH_ATLAS_MAX_HEIGHT / atlas->slotSize;
+    int capacity = rows * atlas->slotsPerRow;
+    if (capacity <= atlas->capacity) return false;
+
+    unsigned int textureId = rlLoadTexture(NULL, CHUNK_BATCH_ATLAS_WIDTH, rows * atlas->slotSize, RL_PIXELFORMAT_UNCOMPRESSED_R32, 1);
+    if (textureId == 0) return false;
+    rlTextureParameters(textureId, RL_TEXTURE_MIN_FILTER, RL_TEXTURE_FILTER_NEAREST);
+    rlTextureParameters(textureId, RL_TEXTURE_MAG_FILTER, RL_TEXTURE_FILTER_NEAREST);
+
+    int oldCapacity = atlas->capacity;
+    atlas->owners = (Chunk**)realloc(atlas->owners, sizeof(Chunk*) * capacity);
+    atlas->freeSlots = (int*)realloc(atlas->freeSlots, sizeof(int) * capacity);
+    // Pushed highest first, so the lowest new slot is handed out next
+    for (int slot = capacity - 1; slot >= oldCapacity; slot--) {
+        atlas->owners[slot] = NULL;
+        atlas->freeSlots[atlas->freeCount++] = slot;
+    }
+
+    if (atlas->textureId) rlUnloadTexture(atlas->textureId);
+    atlas->textureId = textureId;
+    atlas->textureHeight = rows * atlas->slotSize;
+    atlas->capacity = capacity;
+    if (atlas->fboId) rlFramebufferAttach(atlas->fboId, textureId, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_TEXTURE2D, 0);
+    // A chunk being regenerated has its heights rewritten by a worker: it
+    // is not drawn until its next upload, which writes the slot anyway
+    for (int slot = 0; slot < oldCapacity; slot++) {
+        Chunk* owner = atlas->owners[slot];
+        if (owner && !Chunk_IsJobInFlight(owner)) WriteSlot(atlas, owner);
+    }
+    return true;
+}
+
+bool ChunkHeightAtlas_Upload(ChunkHeightAtlas* atlas, Chunk* chunk) {
+    if (chunk->atlasSlot < 0) {
+        if (atlas->freeCount == 0 && !GrowAtlas(atlas)) {
+            TraceLog(LOG_WARNING, "CHUNK: Height atlas for resolution %d is full (%d slots)", atlas->resolution, atlas->capacity);
+            return false;
+        }
+        chunk->atlasSlot = atlas->freeSlots[--atlas->freeCount];
+        atlas->owners[chunk->atlasSlot] = chunk;
+    }
+    WriteSlot(atlas, chunk);
+    chunk->isUploaded = true;
+    return true;
+}
+
+void ChunkHeightAtlas_Release(ChunkHeightAtlas* atlas, Chunk* chunk) {
+    atlas->owners[chunk->atlasSlot] = NULL;
+    atlas->freeSlots[atlas->freeCount++] = chunk->atlasSlot;
+    chunk->atlasSlot = -1;
+}
+
+static void FreeAtlas(ChunkHeightAtlas* atlas) {
+    if (atlas->fboId) rlUnloadFramebuffer(atlas->fboId);
+    if (atlas->textureId) rlUnloadTexture(atlas->textureId);
+    free(atlas->owners);
+    free(atlas->freeSlots);
+}
+
+// --- Batch ---
+
+ChunkBatch* ChunkBatch_Create(float radius, Vector3 origin) {
+    ChunkBatch* batch = (ChunkBatch*)calloc(1, sizeof(ChunkBatch));
+    batch->radius = radius;
+    batch->origin = origin;
+    return batch;
+}
+
+bool ChunkBatch_SupportsResolution(int resolution) {
+    return resolution >= 1 && resolution <= CHUNK_BATCH_MAX_RESOLUTION;
+}
+
+static ChunkBatchGroup* GetGroup(ChunkBatch* batch, int resolution) {
+    for (int i = 0; i < batch->groupCount; i++) {
+        if (batch->groups[i]->atlas.resolution == resolution) return batch->groups[i];
+    }
+
+    ChunkBatchGroup* group = (ChunkBatchGroup*)calloc(1, sizeof(ChunkBatchGroup));
+    InitAtlas(&group->atlas, batch, resolution);
+    batch->groups = (ChunkBatchGroup**)realloc(batch->groups, sizeof(ChunkBatchGroup*) * (batch->groupCount + 1));
+    batch->groups[batch->groupCount++] = group;
+    return group;
+}
+
+ChunkHeightAtlas* ChunkBatch_GetAtlas(ChunkBatch* batch, int resolution) {
+    return &GetGroup(batch, resolution)->atlas;
+}
+
+void ChunkBatch_Add(ChunkBatch* batch, Chunk* chunk) {
+    ChunkBatchGroup* group = GetGroup(batch, chunk->resolution);
+    if (group->count >= group->capacity) {
+        group->capacity = group->capacity > 0 ? group->capacity * 2 : 64;
+        group->instances = (ChunkInstance*)realloc(group->instances, sizeof(ChunkInstance) * group->capacity);
+        group->seamMasks = (unsigned char*)realloc(group->seamMasks, group->capacity);
+    }
+
+    // Face plane to world: the same transform StageProjectToSphere applies
+    const Matrix m = chunk->localToWorld;
+    float x0 = chunk->offset.x, y0 = chunk->offset.y;
+    float w = chunk->width, h = chunk->height;
+    int slotX, slotY;
+    GetSlotOrigin(&group->atlas, chunk->atlasSlot, &slotX, &slotY);
+
+    ChunkInstance* instance = &group->instances[group->count];
+    instance->corner[0] = m.m0 * x0 + m.m4 * y0 + m.m12;
+    instance->corner[1] = m.m1 * x0 + m.m5 * y0 + m.m13;
+    instance->corner[2] = m.m2 * x0 + m.m6 * y0 + m.m14;
+    instance->corner[3] = (float)slotX;
+    instance->axisU[0] = m.m0 * w;
+    instance->axisU[1] = m.m1 * w;
+    instance->axisU[2] = m.m2 * w;
+    instance->axisU[3] = (float)slotY;
+    instance->axisV[0] = m.m4 * h;
+    instance->axisV[1] = m.m5 * h;
+    instance->axisV[2] = m.m6 * h;
+    instance->axisV[3] = CHUNK_SKIRT_DEPTH_CELLS * fmaxf(w, h) / chunk->resolution;
+    instance->lod[0] = chunk->lodMorphEnd;
+    instance->lod[1] = instance->lod[2] = instance->lod[3] = 0.0f;
+    group->seamMasks[group->count] = chunk->seamMask & 15;
+    group->count++;
+}
+
+static void EnsureGroupBuffers(ChunkBatchGroup* group, int instances) {
+    if (group->vaoId == 0) {
+        // No vertex attributes: the shader works from gl_VertexID
+        int firstIndex, indexCount;
+        ChunkGpu_AcquireIndexBuffer(group->atlas.resolution);
+        unsigned int eboId = ChunkGpu_GetIndexBuffer(group->atlas.resolution, 0, &firstIndex, &indexCount);
+        group->vaoId = rlLoadVertexArray();
+        rlEnableVertexArray(group->vaoId);
+        rlEnableVertexBufferElement(eboId);
+        rlDisableVertexArray();
+    }
+
+    if (instances > group->instanceVboCapacity) {
+        int capacity = group->instanceVboCapacity > 0 ? group->instanceVboCapacity : 256;
+        while (capacity < instances) capacity *= 2;
+        if (group->instanceVboId) rlUnloadVertexBuffer(group->instanceVboId);
+        group->instanceVboId = rlLoadVertexBuffer(NULL, capacity * (int)sizeof(ChunkInstance), true);
+        group->instanceVboCapacity = capacity;
+    }
+}
+
+// Base-instance emulation: the attributes point at the first instance of the draw
+static void SetInstanceAttributes(const ChunkShaderLocations* locs, int firstInstance) {
+    int stride = sizeof(ChunkInstance);
+    int locations[4] = { locs->instanceCorner, locs->instanceAxisU, locs->instanceAxisV, locs->instanceLod };
+    for (int i = 0; i < 4; i++) {
+        if (locations[i] == -1) continue;
+        rlSetVertexAttribute(locations[i], 4, RL_FLOAT, false, stride, firstInstance * stride + i * 16);
+        rlSetVertexAttributeDivisor(locations[i], 1);
+        rlEnableVertexAttribute(locations[i]);
+    }
+}
+
+static void DrawGroupPass(ChunkBatch* batch, ChunkBatchGroup* group, Shader shader, const ChunkShaderLocations* locs,
+                          Color color, const int* maskStart) {
+    int res = group->atlas.resolution;
+    int instanced = 1;
+    int atlasSlot = CHUNK_BATCH_ATLAS_TEXTURE_SLOT;
+
+    ChunkGpu_BeginShader(shader, color);
+    rlSetUniform(locs->chunkInstanced, &instanced, SHADER_UNIFORM_INT, 1);
+    if (locs->chunkResolution != -1) rlSetUniform(locs->chunkResolution, &res, SHADER_UNIFORM_INT, 1);
+    if (locs->chunkFirstVertex != -1) {
+        int firstVertex = 0;
+        rlSetUniform(locs->chunkFirstVertex, &firstVertex, SHADER_UNIFORM_INT, 1);
+    }
+    if (locs->planetRadius != -1) rlSetUniform(locs->planetRadius, &batch->radius, SHADER_UNIFORM_FLOAT, 1);
+    if (locs->planetOrigin != -1) rlSetUniform(locs->planetOrigin, &batch->origin, SHADER_UNIFORM_VEC3, 1);
+    ChunkGpu_SetMorphUniforms(locs); // The morph end comes with each instance
+    if (locs->heightAtlas != -1) rlSetUniform(locs->heightAtlas, &atlasSlot, SHADER_UNIFORM_INT, 1);
+    rlActiveTextureSlot(CHUNK_BATCH_ATLAS_TEXTURE_SLOT);
+    rlEnableTexture(group->atlas.textureId);
+
+    rlEnableVertexArray(group->vaoId);
+    rlEnableVertexBuffer(group->instanceVboId);
+    for (int mask = 0; mask < 16; mask++) {
+        int instances = maskStart[mask + 1] - maskStart[mask];
+        if (instances == 0) continue;
+        int firstIndex, indexCount;
+        ChunkGpu_GetIndexBuffer(res, mask, &firstIndex, &indexCount);
+        SetInstanceAttributes(locs, maskStart[mask]);
+        rlDrawVertexArrayElementsInstanced(firstIndex, indexCount, 0, instances);
+        batch->drawCalls++;
+    }
+    rlDisableVertexAttribute(locs->instanceCorner);
+    rlDisableVertexAttribute(locs->instanceAxisU);
+    rlDisableVertexAttribute(locs->instanceAxisV);
+    if (locs->instanceLod != -1) rlDisableVertexAttribute(locs->instanceLod);
+    rlDisableVertexBuffer();
+    rlDisableVertexArray();
+
+    rlDisableTexture();
+    rlActiveTextureSlot(0);
+    rlDisableShader();
+}
+
+int ChunkBatch_Flush(ChunkBatch* batch, Shader shader, Color color, Color wireframeColor) {
+    static unsigned int warnedShaderId = 0;
+    const ChunkShaderLocations* locs = ChunkGpu_GetShaderLocations(shader);
+    bool supported = locs->chunkInstanced != -1 && locs->instanceCorner != -1 &&
+                     locs->instanceAxisU != -1 && locs->instanceAxisV != -1;
+
+    batch->drawCalls = 0;
+    for (int g = 0; g < batch->groupCount; g++) {
+        ChunkBatchGroup* group = batch->groups[g];
+        if (group->count == 0) continue;
+        if (!supported) {
+            if (warnedShaderId != shader.id) {
+                TraceLog(LOG_WARNING, "CHUNK: Shader %u has no instanced path, instanced chunks are not drawn", shader.id);
+                warnedShaderId = shader.id;
+            }
+            group->count = 0;
+            continue;
+        }
+
+        // Instances grouped by seam mask, one draw per mask
+        int maskStart[17] = { 0 };
+        for (int i = 0; i < group->count; i++) maskStart[group->seamMasks[i] + 1]++;
+        for (int mask = 0; mask < 16; mask++) maskStart[mask + 1] += maskStart[mask];
+        if (group->count > group->sortedCapacity) {
+            group->sortedCapacity = group->capacity;
+            group->sorted = (ChunkInstance*)realloc(group->sorted, sizeof(ChunkInstance) * group->sortedCapacity);
+        }
+        int cursor[16];
+        memcpy(cursor, maskStart, sizeof(cursor));
+        for (int i = 0; i < group->count; i++) {
+            group->sorted[cursor[group->seamMasks[i]]++] = group->instances[i];
+        }
+
+        EnsureGroupBuffers(group, group->count);
+        rlUpdateVertexBuffer(group->instanceVboId, group->sorted, group->count * (int)sizeof(ChunkInstance), 0);
+
+        DrawGroupPass(batch, group, shader, locs, color, maskStart);
+        if (wireframeColor.a > 0) {
+            rlEnableWireMode();
+            DrawGroupPass(batch, group, shader, locs, wireframeColor, maskStart);
+            rlDisableWireMode();
+        }
+        group->count = 0;
+    }
+    return batch->drawCalls;
+}
+
+void ChunkBatch_Destroy(ChunkBatch* batch) {
+    for (int i = 0; i < batch->groupCount; i++) {
+        ChunkBatchGroup* group = batch->groups[i];
+        if (group->vaoId) {
+            rlUnloadVertexArray(group->vaoId);
+            ChunkGpu_ReleaseIndexBuffer(group->atlas.resolution);
+        }
+        if (group->instanceVboId) rlUnloadVertexBuffer(group->instanceVboId);
+        FreeAtlas(&group->atlas);
+        free(group->instances);
+        free(group->seamMasks);
+        free(group->sorted);
+        free(group);
+    }
+    if (batch->terrainVaoId) rlUnloadVertexArray(batch->terrainVaoId);
+    free(batch->groups);
+    free(batch);
+}
+
+// --- GPU terrain ---
+
+// Float render targets are core in GL 3.3, but check the driver agrees
+static bool CanRenderToR32(void) {
+    unsigned int textureId = rlLoadTexture(NULL, 4, 4, RL_PIXELFORMAT_UNCOMPRESSED_R32, 1);
+    if (textureId == 0) return false;
+    unsigned int fboId = rlLoadFramebuffer();
+    rlFramebufferAttach(fboId, textureId, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_TEXTURE2D, 0);
+    bool complete = rlFramebufferComplete(fboId);
+    rlUnloadFramebuffer(fboId);
+    rlUnloadTexture(textureId);
+    return complete;
+}
+
+bool ChunkBatch_SetTerrainShader(ChunkBatch* batch, Shader shader) {
+    batch->gpuTerrain = false;
+    if (shader.id == 0) return true;
+    if (shader.id == batch->terrainShader.id) {
+        batch->gpuTerrain = true;
+        return true;
+    }
+
+    int slotOrigin = GetShaderLocation(shader, "terrainSlotOrigin");
+    int offset = GetShaderLocation(shader, "terrainOffset");
+    int step = GetShaderLocation(shader, "terrainStep");
+    int radius = GetShaderLocation(shader, "terrainRadius");
+    int noiseScale = GetShaderLocation(shader, "terrainNoiseScale");
+    int amplitude = GetShaderLocation(shader, "terrainAmplitude");
+    if (slotOrigin < 0 || offset < 0 || step < 0 || radius < 0 || noiseScale < 0 || amplitude < 0) {
+        TraceLog(LOG_WARNING, "CHUNK: Shader %u is not a terrain shader, heights stay on the CPU", shader.id);
+        return false;
+    }
+    // Probed once, with the first terrain shader
+    if (batch->terrainShader.id == 0 && !CanRenderToR32()) {
+        TraceLog(LOG_WARNING, "CHUNK: Cannot render to float textures, heights stay on the CPU");
+        return false;
+    }
+
+    batch->terrainShader = shader;
+    batch->terrainSlotOriginLoc = slotOrigin;
+    batch->terrainOffsetLoc = offset;
+    batch->terrainStepLoc = step;
+    batch->terrainRadiusLoc = radius;
+    batch->terrainNoiseScaleLoc = noiseScale;
+    batch->terrainAmplitudeLoc = amplitude;
+    batch->gpuTerrain = true;
+    return true;
+}
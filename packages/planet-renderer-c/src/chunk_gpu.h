@@ -0,0 +1,54 @@
+// GPU state shared by the per-chunk draws in chunk.c and the instanced
+// draws in chunk_batch.c. Not a public header. Main thread only.
+
+#ifndef CHUNK_GPU_H
+#define CHUNK_GPU_H
+
+#include <raylib.h>
+
+// Skirt depth below the chunk border, in grid cells of the longer side
+#define CHUNK_SKIRT_DEPTH_CELLS 2.0f
+
+// Uniform and attribute locations of the chunk shader contract, cached per
+// shader (-1 = the shader does not use it). Keyed on the program id and the
+// shader's locs array: GL reuses program ids, but every LoadShader allocates
+// a new locs array, so a reloaded shader never inherits stale locations.
+typedef struct ChunkShaderLocations {
+    unsigned int shaderId;
+    const int* shaderLocs;
+    int chunkOrigin;
+    int chunkExtent;
+    int chunkResolution;
+    int chunkFirstVertex;
+    // Instanced path, see chunk_batch.h
+    int chunkInstanced;
+    int heightAtlas;
+    int planetRadius;
+    int planetOrigin;
+    // Geomorphing, see ChunkVertex
+    int lodCamera;
+    int lodMorphStart;
+    int chunkMorphEnd;
+    int instanceCorner; // Attributes
+    int instanceAxisU;
+    int instanceAxisV;
+    int instanceLod;    // Optional
+} ChunkShaderLocations;
+
+const ChunkShaderLocations* ChunkGpu_GetShaderLocations(Shader shader);
+
+// Enables the shader and sets the raylib matrices of the current rlgl state
+// and colDiffuse, as DrawMesh would
+void ChunkGpu_BeginShader(Shader shader, Color color);
+
+// Uploads the Chunk_SetLodMorph parameters to the enabled shader
+void ChunkGpu_SetMorphUniforms(const ChunkShaderLocations* locs);
+
+// Seam-variant index buffers, one per resolution, reference counted
+void ChunkGpu_AcquireIndexBuffer(int resolution);
+void ChunkGpu_ReleaseIndexBuffer(int resolution);
+// Element buffer of an acquired resolution and the index range of one
+// CHUNK_ID_EDGE_* seam mask within it
+unsigned int ChunkGpu_GetIndexBuffer(int resolution, int seamMask, int* firstIndex, int* indexCount);
+
+#endif // CHUNK_GPU_H
@@ -0,0 +1,103 @@
+#include "chunk_id.h"
+
+#define FACE_SHIFT 61
+#define LEVEL_SHIFT 56
+#define LEVEL_MASK 0x1FULL
+#define MORTON_MASK ((1ULL << LEVEL_SHIFT) - 1)
+
+// Spread the low 28 bits of v to the even bit positions
+static unsigned long long SpreadBits(unsigned int v) {
+    unsigned long long x = v & 0x0FFFFFFFu;
+    x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x << 8)) & 0x00FF00FF00FF00FFULL;
+    x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    x = (x | (x << 2)) & 0x3333333333333333ULL;
+    x = (x | (x << 1)) & 0x5555555555555555ULL;
+    return x;
+}
+
+// Inverse of SpreadBits: gather the even bits
+static unsigned int CompactBits(unsigned long long x) {
+    x &= 0x5555555555555555ULL;
+    x = (x | (x >> 1)) & 0x3333333333333333ULL;
+    x = (x | (x >> 2)) & 0x0F0F0F0F0F0F0F0FULL;
+    x = (x | (x >> 4)) & 0x00FF00FF00FF00FFULL;
+    x = (x | (x >> 8)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x >> 16)) & 0x00000000FFFFFFFFULL;
+    return (unsigned int)x;
+}
+
+static ChunkId Compose(int face, int level, unsigned long long morton) {
+    return ((ChunkId)face << FACE_SHIFT) | ((ChunkId)level << LEVEL_SHIFT) | morton;
+}
+
+ChunkId ChunkId_Make(int face, int level, unsigned int x, unsigned int y) {
+    return Compose(face, level, SpreadBits(x) | (SpreadBits(y) << 1));
+}
+
+ChunkId ChunkId_MakeRoot(int face) {
+    return Compose(face, 0, 0);
+}
+
+int ChunkId_GetFace(ChunkId id) {
+    return (int)(id >> FACE_SHIFT);
+}
+
+int ChunkId_GetLevel(ChunkId id) {
+    return (int)((id >> LEVEL_SHIFT) & LEVEL_MASK);
+}
+
+unsigned int ChunkId_GetX(ChunkId id) {
+    return CompactBits(id & MORTON_MASK);
+}
+
+unsigned int ChunkId_GetY(ChunkId id) {
+    return CompactBits((id & MORTON_MASK) >> 1);
+}
+
+bool ChunkId_IsValid(ChunkId id) {
+    int level = ChunkId_GetLevel(id);
+    return ChunkId_GetFace(id) < 6 && level <= CHUNK_ID_MAX_LEVEL &&
+           ((id & MORTON_MASK) >> (2 * level)) == 0;
+}
+
+ChunkId ChunkId_GetParent(ChunkId id) {
+    int level = ChunkId_GetLevel(id);
+    if (level == 0) return CHUNK_ID_INVALID;
+    return Compose(ChunkId_GetFace(id), level - 1, (id & MORTON_MASK) >> 2);
+}
+
+ChunkId ChunkId_GetChild(ChunkId id, int index) {
+    int level = ChunkId_GetLevel(id);
+    if (level >= CHUNK_ID_MAX_LEVEL) return CHUNK_ID_INVALID;
+    return Compose(ChunkId_GetFace(id), level + 1, ((id & MORTON_MASK) << 2) | (unsigned long long)(index & 3));
+}
+
+int ChunkId_GetChildIndex(ChunkId id) {
+    return (int)(id & 3);
+}
+
+int ChunkId_GetChildIndexAt(ChunkId id, int level) {
+    return (int)((id >> (2 * (ChunkId_GetLevel(id) - level))) & 3);
+}
+
+ChunkId ChunkId_GetAncestor(ChunkId id, int level) {
+    int idLevel = ChunkId_GetLevel(id);
+    if (level >= idLevel) return id;
+    if (level < 0) return CHUNK_ID_INVALID;
+    return Compose(ChunkId_GetFace(id), level, (id & MORTON_MASK) >> (2 * (idLevel - level)));
+}
+
+bool ChunkId_IsAncestorOf(ChunkId ancestor, ChunkId id) {
+    return ChunkId_GetFace(ancestor) == ChunkId_GetFace(id) &&
+           ChunkId_GetAncestor(id, ChunkId_GetLevel(ancestor)) == ancestor;
+}
+
+ChunkId ChunkId_GetNeighbor(ChunkId id, int dx, int dy) {
+    int level = ChunkId_GetLevel(id);
+    long long tiles = 1LL << level;
+    long long x = (long long)ChunkId_GetX(id) + dx;
+    long long y = (long long)ChunkId_GetY(id) + dy;
+    if (x < 0 || y < 0 || x >= tiles || y >= tiles) return CHUNK_ID_INVALID;
+    return ChunkId_Make(ChunkId_GetFace(id), level, (unsigned int)x, (unsigned int)y);
+}
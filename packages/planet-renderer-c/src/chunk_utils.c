@@ -1,127 +1,454 @@
 #include "chunk_utils.h"
+#include "planet_trace.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <raymath.h>
 
 // --- Chunk Map ---
 
+// Slots fill to at most 7/8 before the table doubles
+#define CHUNK_MAP_MAX_LOAD_NUM 7
+#define CHUNK_MAP_MAX_LOAD_DEN 8
+
+// splitmix64 finalizer: tile IDs differ mostly in a few bit ranges, so they
+// must be mixed before masking down to a slot index
+static unsigned int MixKey(ChunkId key) {
+    key ^= key >> 30;
+    key *= 0xBF58476D1CE4E5B9ULL;
+    key ^= key >> 27;
+    key *= 0x94D049BB133111EBULL;
+    key ^= key >> 31;
+    return (unsigned int)key;
+}
+
+static void AllocateSlots(ChunkMap* map, int capacity) {
+    map->capacity = capacity;
+    map->slots = (ChunkMapSlot*)malloc(sizeof(ChunkMapSlot) * capacity);
+    for (int i = 0; i < capacity; i++) {
+        map->slots[i].entry = -1;
+    }
+}
+
+// Robin Hood insertion: an incoming slot displaces any resident that is
+// closer to its home slot, which keeps probe lengths short and even
+static void PlaceSlot(ChunkMap* map, ChunkMapSlot slot) {
+    int mask = map->capacity - 1;
+    int index = (int)(slot.hash & mask);
+    int distance = 0;
+
+    while (map->slots[index].entry >= 0) {
+        ChunkMapSlot* resident = &map->slots[index];
+        int residentDistance = (index - (int)(resident->hash & mask)) & mask;
+        if (residentDistance < distance) {
+            ChunkMapSlot displaced = *resident;
+            *resident = slot;
+            slot = displaced;
+            distance = residentDistance;
+        }
+        index = (index + 1) & mask;
+        distance++;
+    }
+    map->slots[index] = slot;
+}
+
+static void Grow(ChunkMap* map) {
+    ChunkMapSlot* oldSlots = map->slots;
+    int oldCapacity = map->capacity;
+
+    AllocateSlots(map, oldCapacity * 2);
+    for (int i = 0; i < oldCapacity; i++) {
+        if (oldSlots[i].entry >= 0) PlaceSlot(map, oldSlots[i]);
+    }
+    free(oldSlots);
+}
+
+// Slot index holding key, or -1. Stops as soon as the probe is longer than
+// the resident's own, since Robin Hood order guarantees the key is absent.
+static int FindSlot(const ChunkMap* map, ChunkId key, unsigned int hash) {
+    int mask = map->capacity - 1;
+    int index = (int)(hash & mask);
+
+    for (int distance = 0;; distance++) {
+        const ChunkMapSlot* slot = &map->slots[index];
+        if (slot->entry < 0) return -1;
+        if (((index - (int)(slot->hash & mask)) & mask) < distance) return -1;
+        if (slot->hash == hash && map->entries[slot->entry].key == key) return index;
+        index = (index + 1) & mask;
+    }
+}
+
 ChunkMap* ChunkMap_Create(int capacity) {
     ChunkMap* map = (ChunkMap*)malloc(sizeof(ChunkMap));
-    map->capacity = capacity;
+
+    int slots = 16;
+    while (slots * CHUNK_MAP_MAX_LOAD_NUM < capacity * CHUNK_MAP_MAX_LOAD_DEN) slots *= 2;
+    AllocateSlots(map, slots);
+
+    map->entryCapacity = capacity > 16 ? capacity : 16;
+    map->entries = (ChunkMapEntry*)malloc(sizeof(ChunkMapEntry) * map->entryCapacity);
     map->count = 0;
-    map->buckets = (ChunkMapEntry**)calloc(capacity, sizeof(ChunkMapEntry*));
     return map;
 }
 
-static int Hash(unsigned long long key, int capacity) {
-    return key % capacity;
-}
+void ChunkMap_Insert(ChunkMap* map, ChunkId key, Chunk* chunk) {
+    unsigned int hash = MixKey(key);
+    int found = FindSlot(map, key, hash);
+    if (found >= 0) {
+        // Replace existing
+        map->entries[map->slots[found].entry].value = chunk;
+        return;
+    }
 
-void ChunkMap_Insert(ChunkMap* map, unsigned long long key, Chunk* chunk) {
-    int index = Hash(key, map->capacity);
-    
-    ChunkMapEntry* entry = map->buckets[index];
-    while (entry) {
-        if (entry->key == key) {
-            // Replace existing
-            entry->value = chunk;
-            return;
-        }
-        entry = entry->next;
-    }
-    
-    // New entry
-    ChunkMapEntry* newEntry = (ChunkMapEntry*)malloc(sizeof(ChunkMapEntry));
-    newEntry->key = key;
-    newEntry->value = chunk;
-    newEntry->next = map->buckets[index];
-    map->buckets[index] = newEntry;
+    if ((map->count + 1) * CHUNK_MAP_MAX_LOAD_DEN > map->capacity * CHUNK_MAP_MAX_LOAD_NUM) {
+        Grow(map);
+    }
+    if (map->count >= map->entryCapacity) {
+        map->entryCapacity *= 2;
+        map->entries = (ChunkMapEntry*)realloc(map->entries, sizeof(ChunkMapEntry) * map->entryCapacity);
+    }
+
+    map->entries[map->count].key = key;
+    map->entries[map->count].value = chunk;
+    PlaceSlot(map, (ChunkMapSlot){ map->count, hash });
     map->count++;
 }
 
-Chunk* ChunkMap_Get(ChunkMap* map, unsigned long long key) {
-    int index = Hash(key, map->capacity);
-    ChunkMapEntry* entry = map->buckets[index];
-    while (entry) {
-        if (entry->key == key) {
-            return entry->value;
-        }
-        entry = entry->next;
-    }
-    return NULL;
-}
-
-Chunk* ChunkMap_Remove(ChunkMap* map, unsigned long long key) {
-    int index = Hash(key, map->capacity);
-    ChunkMapEntry* entry = map->buckets[index];
-    ChunkMapEntry* prev = NULL;
-    
-    while (entry) {
-        if (entry->key == key) {
-            if (prev) {
-                prev->next = entry->next;
-            } else {
-                map->buckets[index] = entry->next;
-            }
-            Chunk* chunk = entry->value;
-            free(entry);
-            map->count--;
-            return chunk;
-        }
-        prev = entry;
-        entry = entry->next;
+Chunk* ChunkMap_Get(ChunkMap* map, ChunkId key) {
+    int found = FindSlot(map, key, MixKey(key));
+    return found >= 0 ? map->entries[map->slots[found].entry].value : NULL;
+}
+
+Chunk* ChunkMap_Remove(ChunkMap* map, ChunkId key) {
+    int found = FindSlot(map, key, MixKey(key));
+    if (found < 0) return NULL;
+
+    int entry = map->slots[found].entry;
+    Chunk* chunk = map->entries[entry].value;
+
+    // Backward-shift deletion: pull following displaced slots one step back
+    int mask = map->capacity - 1;
+    int hole = found;
+    for (;;) {
+        int next = (hole + 1) & mask;
+        ChunkMapSlot* slot = &map->slots[next];
+        if (slot->entry < 0 || (int)(slot->hash & mask) == next) break;
+        map->slots[hole] = *slot;
+        hole = next;
     }
-    return NULL;
+    map->slots[hole].entry = -1;
+
+    // Keep entries dense: move the last one into the gap and repoint its slot
+    // (found through entries[last], which still holds the same key)
+    int last = map->count - 1;
+    if (entry != last) {
+        map->entries[entry] = map->entries[last];
+        int moved = FindSlot(map, map->entries[entry].key, MixKey(map->entries[entry].key));
+        map->slots[moved].entry = entry;
+    }
+    map->count--;
+    return chunk;
 }
 
 void ChunkMap_Clear(ChunkMap* map) {
     for (int i = 0; i < map->capacity; i++) {
-        ChunkMapEntry* entry = map->buckets[i];
-        while (entry) {
-            ChunkMapEntry* next = entry->next;
-            free(entry);
-            entry = next;
-        }
-        map->buckets[i] = NULL;
+        map->slots[i].entry = -1;
     }
     map->count = 0;
 }
 
 void ChunkMap_Destroy(ChunkMap* map) {
-    ChunkMap_Clear(map);
-    free(map->buckets);
+    free(map->slots);
+    free(map->entries);
     free(map);
 }
 
 // --- Chunk Pool ---
 
-ChunkPool* ChunkPool_Create(int initialCapacity) {
-    ChunkPool* pool = (ChunkPool*)malloc(sizeof(ChunkPool));
-    pool->capacity = initialCapacity;
-    pool->count = 0;
-    pool->chunks = (Chunk**)malloc(sizeof(Chunk*) * initialCapacity);
+ChunkPool* ChunkPool_Create(size_t cpuBudget, size_t gpuBudget) {
+    ChunkPool* pool = (ChunkPool*)calloc(1, sizeof(ChunkPool));
+    pool->bucketCapacity = 4;
+    pool->buckets = (ChunkPoolBucket*)malloc(sizeof(ChunkPoolBucket) * pool->bucketCapacity);
+    pool->deferredCapacity = 16;
+    pool->deferred = (Chunk**)malloc(sizeof(Chunk*) * pool->deferredCapacity);
+    pool->cpuBudget = cpuBudget;
+    pool->gpuBudget = gpuBudget;
     return pool;
 }
 
+// Few distinct resolutions are in use at once: a linear scan is enough
+static ChunkPoolBucket* GetPoolBucket(ChunkPool* pool, int resolution, bool create) {
+    for (int i = 0; i < pool->bucketCount; i++) {
+        if (pool->buckets[i].resolution == resolution) return &pool->buckets[i];
+    }
+    if (!create) return NULL;
+
+    if (pool->bucketCount >= pool->bucketCapacity) {
+        pool->bucketCapacity *= 2;
+        pool->buckets = (ChunkPoolBucket*)realloc(pool->buckets, sizeof(ChunkPoolBucket) * pool->bucketCapacity);
+    }
+    ChunkPoolBucket* bucket = &pool->buckets[pool->bucketCount++];
+    bucket->resolution = resolution;
+    bucket->newest = NULL;
+    bucket->count = 0;
+    return bucket;
+}
+
+static void UnlinkFromPool(ChunkPool* pool, Chunk* chunk) {
+    if (pool->oldestWithGPU == chunk) pool->oldestWithGPU = chunk->poolNewer;
+    if (chunk->poolNewer) chunk->poolNewer->poolOlder = chunk->poolOlder; else pool->newest = chunk->poolOlder;
+    if (chunk->poolOlder) chunk->poolOlder->poolNewer = chunk->poolNewer; else pool->oldest = chunk->poolNewer;
+
+    ChunkPoolBucket* bucket = GetPoolBucket(pool, chunk->resolution, false);
+    if (chunk->bucketPrev) chunk->bucketPrev->bucketNext = chunk->bucketNext; else bucket->newest = chunk->bucketNext;
+    if (chunk->bucketNext) chunk->bucketNext->bucketPrev = chunk->bucketPrev;
+    bucket->count--;
+
+    chunk->poolNewer = chunk->poolOlder = NULL;
+    chunk->bucketNext = chunk->bucketPrev = NULL;
+    pool->count--;
+    pool->cpuBytes -= Chunk_GetCPUBytes(chunk);
+    pool->gpuBytes -= Chunk_GetGPUBytes(chunk);
+}
+
+void ChunkPool_Trim(ChunkPool* pool) {
+    // GPU memory is the scarcer one: unload VBOs oldest first
+    while (pool->gpuBudget > 0 && pool->gpuBytes > pool->gpuBudget && pool->oldestWithGPU) {
+        Chunk* chunk = pool->oldestWithGPU;
+        if (chunk->isUploaded) {
+            pool->gpuBytes -= Chunk_GetGPUBytes(chunk);
+            Chunk_ReleaseGPU(chunk);
+            pool->gpuEvictions++;
+        }
+        pool->oldestWithGPU = chunk->poolNewer;
+    }
+
+    // Then free whole chunks, oldest first
+    while (pool->cpuBudget > 0 && pool->cpuBytes > pool->cpuBudget && pool->oldest) {
+        Chunk* chunk = pool->oldest;
+        UnlinkFromPool(pool, chunk);
+        // Its stale posts would be checked against freed memory
+        if (pool->uploadQueue) ChunkUploadQueue_Remove(pool->uploadQueue, chunk);
+        Chunk_Free(chunk);
+        pool->cpuEvictions++;
+    }
+}
+
+static void AddToPool(ChunkPool* pool, Chunk* chunk) {
+    chunk->poolOlder = pool->newest;
+    chunk->poolNewer = NULL;
+    if (pool->newest) pool->newest->poolNewer = chunk; else pool->oldest = chunk;
+    pool->newest = chunk;
+    if (!pool->oldestWithGPU && chunk->isUploaded) pool->oldestWithGPU = chunk;
+
+    ChunkPoolBucket* bucket = GetPoolBucket(pool, chunk->resolution, true);
+    chunk->bucketPrev = NULL;
+    chunk->bucketNext = bucket->newest;
+    if (bucket->newest) bucket->newest->bucketPrev = chunk;
+    bucket->newest = chunk;
+    bucket->count++;
+
+    pool->count++;
+    pool->cpuBytes += Chunk_GetCPUBytes(chunk);
+    pool->gpuBytes += Chunk_GetGPUBytes(chunk);
+    ChunkPool_Trim(pool);
+}
+
 void ChunkPool_Release(ChunkPool* pool, Chunk* chunk) {
-    if (pool->count >= pool->capacity) {
-        pool->capacity *= 2;
-        pool->chunks = (Chunk**)realloc(pool->chunks, sizeof(Chunk*) * pool->capacity);
+    Chunk_MarkObsolete(chunk);
+    pool->releases++;
+    if (!Chunk_IsJobInFlight(chunk)) {
+        AddToPool(pool, chunk);
+        return;
+    }
+
+    // A worker may still be writing the mesh: park it until the job is done
+    if (pool->deferredCount >= pool->deferredCapacity) {
+        pool->deferredCapacity *= 2;
+        pool->deferred = (Chunk**)realloc(pool->deferred, sizeof(Chunk*) * pool->deferredCapacity);
     }
-    pool->chunks[pool->count++] = chunk;
+    pool->deferred[pool->deferredCount++] = chunk;
 }
 
-Chunk* ChunkPool_Acquire(ChunkPool* pool) {
-    if (pool->count > 0) {
-        return pool->chunks[--pool->count];
+Chunk* ChunkPool_Acquire(ChunkPool* pool, int resolution) {
+    ChunkPoolBucket* bucket = GetPoolBucket(pool, resolution, false);
+    if (!bucket || !bucket->newest) {
+        pool->misses++;
+        return NULL;
     }
-    return NULL;
+    Chunk* chunk = bucket->newest;
+    UnlinkFromPool(pool, chunk);
+    pool->hits++;
+    return chunk;
+}
+
+int ChunkPool_Reclaim(ChunkPool* pool) {
+    int kept = 0;
+    for (int i = 0; i < pool->deferredCount; i++) {
+        Chunk* chunk = pool->deferred[i];
+        if (Chunk_IsJobInFlight(chunk)) {
+            pool->deferred[kept++] = chunk;
+        } else {
+            AddToPool(pool, chunk);
+        }
+    }
+    int reclaimed = pool->deferredCount - kept;
+    pool->deferredCount = kept;
+    return reclaimed;
 }
 
 void ChunkPool_Destroy(ChunkPool* pool) {
-    for (int i = 0; i < pool->count; i++) {
-        Chunk_Free(pool->chunks[i]);
+    Chunk* chunk = pool->newest;
+    while (chunk) {
+        Chunk* older = chunk->poolOlder;
+        Chunk_Free(chunk);
+        chunk = older;
+    }
+    for (int i = 0; i < pool->deferredCount; i++) {
+        Chunk_Free(pool->deferred[i]);
     }
-    free(pool->chunks);
+    free(pool->buckets);
+    free(pool->deferred);
     free(pool);
 }
+
+// --- Chunk Upload Queue ---
+
+ChunkUploadQueue* ChunkUploadQueue_Create(int initialCapacity) {
+    ChunkUploadQueue* queue = (ChunkUploadQueue*)malloc(sizeof(ChunkUploadQueue));
+    queue->incomingCapacity = initialCapacity;
+    queue->incomingCount = 0;
+    queue->incoming = (ChunkUploadEntry*)malloc(sizeof(ChunkUploadEntry) * initialCapacity);
+    queue->pendingCapacity = initialCapacity;
+    queue->pendingCount = 0;
+    queue->pending = (ChunkUploadEntry*)malloc(sizeof(ChunkUploadEntry) * initialCapacity);
+    queue->onUpload = NULL;
+    queue->onUploadContext = NULL;
+    queue->lastProcessBytes = 0;
+#ifdef PLANET_ENABLE_STATS
+    queue->statsReady = 0;
+    queue->statsWaitSeconds = 0.0;
+    queue->statsWaitMaxSeconds = 0.0;
+    queue->statsUploads = 0;
+    queue->statsUploadBytes = 0;
+#endif
+    pthread_mutex_init(&queue->mutex, NULL);
+    return queue;
+}
+
+void ChunkUploadQueue_Push(ChunkUploadQueue* queue, Chunk* chunk, unsigned int epoch) {
+    pthread_mutex_lock(&queue->mutex);
+    if (queue->incomingCount >= queue->incomingCapacity) {
+        queue->incomingCapacity *= 2;
+        queue->incoming = (ChunkUploadEntry*)realloc(queue->incoming, sizeof(ChunkUploadEntry) * queue->incomingCapacity);
+    }
+    queue->incoming[queue->incomingCount].chunk = chunk;
+    queue->incoming[queue->incomingCount].epoch = epoch;
+    queue->incomingCount++;
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+static int CompareUploadEntries(const void* a, const void* b) {
+    float da = ((const ChunkUploadEntry*)a)->distanceSqr;
+    float db = ((const ChunkUploadEntry*)b)->distanceSqr;
+    return (da > db) - (da < db);
+}
+
+int ChunkUploadQueue_Process(ChunkUploadQueue* queue, Vector3 cameraPosition, double budgetMs, int budgetBytes) {
+    // Move newly finished chunks over to the main-thread list
+    pthread_mutex_lock(&queue->mutex);
+    int needed = queue->pendingCount + queue->incomingCount;
+    if (needed > queue->pendingCapacity) {
+        while (queue->pendingCapacity < needed) queue->pendingCapacity *= 2;
+        queue->pending = (ChunkUploadEntry*)realloc(queue->pending, sizeof(ChunkUploadEntry) * queue->pendingCapacity);
+    }
+    PLANET_STATS_ONLY(int firstNew = queue->pendingCount);
+    for (int i = 0; i < queue->incomingCount; i++) {
+        queue->pending[queue->pendingCount++] = queue->incoming[i];
+    }
+    queue->incomingCount = 0;
+    pthread_mutex_unlock(&queue->mutex);
+
+    // Drop stale posts: the chunk was retired (and maybe recycled and posted
+    // again) since the mesh was built, or it was already uploaded. Then sort
+    // by distance.
+    int kept = 0;
+    for (int i = 0; i < queue->pendingCount; i++) {
+        Chunk* chunk = queue->pending[i].chunk;
+        unsigned int epoch = queue->pending[i].epoch;
+        pthread_mutex_lock(&chunk->stateMutex);
+        bool current = chunk->state == CHUNK_STATE_READY_TO_UPLOAD && chunk->epoch == epoch;
+#ifdef PLANET_ENABLE_STATS
+        if (current && i >= firstNew) {
+            double wait = chunk->readyTime - chunk->queuedTime;
+            queue->statsReady++;
+            queue->statsWaitSeconds += wait;
+            if (wait > queue->statsWaitMaxSeconds) queue->statsWaitMaxSeconds = wait;
+        }
+#endif
+        pthread_mutex_unlock(&chunk->stateMutex);
+        if (!current) continue;
+        queue->pending[kept].chunk = chunk;
+        queue->pending[kept].epoch = epoch;
+        queue->pending[kept].distanceSqr = Vector3DistanceSqr(chunk->center, cameraPosition);
+        kept++;
+    }
+    queue->pendingCount = kept;
+    queue->lastProcessBytes = 0;
+    if (kept == 0) return 0;
+    qsort(queue->pending, kept, sizeof(ChunkUploadEntry), CompareUploadEntries);
+
+    double start = GetTime();
+    int bytes = 0;
+    int uploaded = 0;
+    while (uploaded < queue->pendingCount) {
+        Chunk* chunk = queue->pending[uploaded].chunk;
+        int size = Chunk_GetUploadSize(chunk);
+        if (uploaded > 0) {
+            if (budgetBytes > 0 && bytes + size > budgetBytes) break;
+            if (budgetMs > 0.0 && (GetTime() - start) * 1000.0 >= budgetMs) break;
+        }
+        Chunk_UploadToGPU(chunk);
+        if (queue->onUpload) queue->onUpload(chunk, queue->onUploadContext);
+        bytes += size;
+        uploaded++;
+    }
+
+    PLANET_STATS_ONLY(queue->statsUploads += uploaded);
+    PLANET_STATS_ONLY(queue->statsUploadBytes += bytes);
+    queue->lastProcessBytes = bytes;
+
+    // Keep the rest for the next frame
+    queue->pendingCount -= uploaded;
+    memmove(queue->pending, queue->pending + uploaded, sizeof(ChunkUploadEntry) * queue->pendingCount);
+    return uploaded;
+}
+
+static int RemoveUploadEntries(ChunkUploadEntry* entries, int count, const Chunk* chunk) {
+    int kept = 0;
+    for (int i = 0; i < count; i++) {
+        if (entries[i].chunk != chunk) entries[kept++] = entries[i];
+    }
+    return kept;
+}
+
+void ChunkUploadQueue_Remove(ChunkUploadQueue* queue, Chunk* chunk) {
+    pthread_mutex_lock(&queue->mutex);
+    queue->incomingCount = RemoveUploadEntries(queue->incoming, queue->incomingCount, chunk);
+    pthread_mutex_unlock(&queue->mutex);
+    queue->pendingCount = RemoveUploadEntries(queue->pending, queue->pendingCount, chunk);
+}
+
+int ChunkUploadQueue_GetPendingCount(ChunkUploadQueue* queue) {
+    pthread_mutex_lock(&queue->mutex);
+    int count = queue->pendingCount + queue->incomingCount;
+    pthread_mutex_unlock(&queue->mutex);
+    return count;
+}
+
+void ChunkUploadQueue_Destroy(ChunkUploadQueue* queue) {
+    pthread_mutex_destroy(&queue->mutex);
+    free(queue->incoming);
+    free(queue->pending);
+    free(queue);
+}
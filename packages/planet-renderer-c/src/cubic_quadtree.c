@@ -1,8 +1,17 @@
 #include "cubic_quadtree.h"
 #include <stdlib.h>
+#include <math.h>
 #include <raymath.h>
 
-CubicQuadTree* CubicQuadTree_Create(float radius, float minNodeSize, float comparatorValue, Vector3 origin) {
+// Edge neighbors in CHUNK_ID_EDGE_* bit order, and the two children of a
+// tile that touch each edge
+static const int edgeDx[4] = { -1, 1, 0, 0 };
+static const int edgeDy[4] = { 0, 0, -1, 1 };
+static const int edgeChildren[4][2] = { { 0, 2 }, { 1, 3 }, { 0, 1 }, { 2, 3 } };
+
+static bool BalancedMerge(const Quadtree* face, const QuadtreeNode* node, void* context);
+
+CubicQuadTree* CubicQuadTree_Create(float radius, float minNodeSize, float comparatorValue, float maxDisplacement, Vector3 origin) {
     CubicQuadTree* tree = (CubicQuadTree*)malloc(sizeof(CubicQuadTree));
     
     Matrix transforms[6];
@@ -26,16 +35,134 @@ CubicQuadTree* CubicQuadTree_Create(float radius, float minNodeSize, float compa
     transforms[5] = MatrixMultiply(MatrixRotateY(PI), MatrixTranslate(0, 0, -radius));
     
     for (int i = 0; i < 6; i++) {
-        tree->faces[i] = Quadtree_Create(radius, minNodeSize, comparatorValue, origin, transforms[i], i);
+        tree->faces[i] = Quadtree_Create(radius, minNodeSize, comparatorValue, maxDisplacement, origin, transforms[i], i);
+        tree->faces[i]->mergeFilter = BalancedMerge;
+        tree->faces[i]->mergeFilterContext = tree;
     }
     
     return tree;
 }
 
-void CubicQuadTree_Insert(CubicQuadTree* tree, Vector3 cameraPosition, QuadtreeSplitCallback onSplit) {
+// --- 2:1 balance ---
+// Edge-adjacent leaves never differ by more than one level, so a chunk only
+// has to stitch to neighbors exactly one level coarser. Merges that would
+// break this are held back; splits that would break it force the coarse
+// neighbor to split too. Both only look at the leaves in the diff.
+
+// A leaf with this ID would border leaves more than one level finer: the
+// same-level neighbor is split and one of its children along the shared
+// edge is split too
+static bool HasDeepNeighbor(CubicQuadTree* tree, ChunkId id) {
+    for (int e = 0; e < 4; e++) {
+        ChunkId neighborId = CubicQuadTree_GetNeighborId(tree, id, edgeDx[e], edgeDy[e]);
+        if (neighborId == CHUNK_ID_INVALID) continue;
+        QuadtreeNode* neighbor = CubicQuadTree_FindNode(tree, neighborId);
+        if (!neighbor || neighbor->id != neighborId || neighbor->isLeaf) continue;
+
+        QuadtreeNode* children = Quadtree_GetChildren(tree->faces[neighbor->faceId], neighbor);
+        for (int k = 0; k < 2; k++) {
+            ChunkId child = ChunkId_GetChild(id, edgeChildren[e][k]);
+            ChunkId fineId = CubicQuadTree_GetNeighborId(tree, child, edgeDx[e], edgeDy[e]);
+            if (fineId == CHUNK_ID_INVALID) continue;
+            if (!children[ChunkId_GetChildIndex(fineId)].isLeaf) return true;
+        }
+    }
+    return false;
+}
+
+static bool BalancedMerge(const Quadtree* face, const QuadtreeNode* node, void* context) {
+    (void)face;
+    return !HasDeepNeighbor((CubicQuadTree*)context, node->id);
+}
+
+// Walks the added leaves (including those appended by forced splits) and
+// splits whatever breaks the balance; retracted entries become NULL
+static void BalanceLeaves(CubicQuadTree* tree, QuadtreeLeafChanges* changes, int firstAdded) {
+    for (int i = firstAdded; i < changes->addedCount; i++) {
+        QuadtreeNode* leaf = changes->added[i];
+        if (!leaf || !leaf->isLeaf) continue;
+
+        // Merged while a neighbor split further this same update
+        if (HasDeepNeighbor(tree, leaf->id)) {
+            Quadtree_SplitLeaf(tree->faces[leaf->faceId], leaf, changes);
+            continue;
+        }
+
+        int level = ChunkId_GetLevel(leaf->id);
+        for (int e = 0; e < 4; e++) {
+            ChunkId neighborId = CubicQuadTree_GetNeighborId(tree, leaf->id, edgeDx[e], edgeDy[e]);
+            if (neighborId == CHUNK_ID_INVALID) continue;
+            QuadtreeNode* neighbor = CubicQuadTree_FindNode(tree, neighborId);
+            if (neighbor && ChunkId_GetLevel(neighbor->id) < level - 1) {
+                Quadtree_SplitLeaf(tree->faces[neighbor->faceId], neighbor, changes);
+            }
+        }
+    }
+
+    int kept = firstAdded;
+    for (int i = firstAdded; i < changes->addedCount; i++) {
+        if (changes->added[i]) changes->added[kept++] = changes->added[i];
+    }
+    changes->addedCount = kept;
+}
+
+unsigned char CubicQuadTree_GetCoarserEdges(CubicQuadTree* tree, ChunkId id) {
+    unsigned char mask = 0;
+    int level = ChunkId_GetLevel(id);
+    for (int e = 0; e < 4; e++) {
+        ChunkId neighborId = CubicQuadTree_GetNeighborId(tree, id, edgeDx[e], edgeDy[e]);
+        if (neighborId == CHUNK_ID_INVALID) continue;
+        QuadtreeNode* neighbor = CubicQuadTree_FindNode(tree, neighborId);
+        if (neighbor && ChunkId_GetLevel(neighbor->id) < level) mask |= (unsigned char)(1 << e);
+    }
+    return mask;
+}
+
+// Refresh coarserEdges of the added leaves and of every leaf bordering them
+// (the added leaves cover all the area that changed)
+static void UpdateCoarserEdges(CubicQuadTree* tree, QuadtreeLeafChanges* changes, int firstAdded) {
+    for (int i = firstAdded; i < changes->addedCount; i++) {
+        QuadtreeNode* leaf = changes->added[i];
+        leaf->coarserEdges = CubicQuadTree_GetCoarserEdges(tree, leaf->id);
+
+        for (int e = 0; e < 4; e++) {
+            ChunkId neighborId = CubicQuadTree_GetNeighborId(tree, leaf->id, edgeDx[e], edgeDy[e]);
+            if (neighborId == CHUNK_ID_INVALID) continue;
+            QuadtreeNode* neighbor = CubicQuadTree_FindNode(tree, neighborId);
+            if (!neighbor) continue;
+            if (neighbor->isLeaf) {
+                neighbor->coarserEdges = CubicQuadTree_GetCoarserEdges(tree, neighbor->id);
+                continue;
+            }
+
+            // Split neighbor: the two finer leaves along the shared edge
+            for (int k = 0; k < 2; k++) {
+                ChunkId child = ChunkId_GetChild(leaf->id, edgeChildren[e][k]);
+                ChunkId fineId = CubicQuadTree_GetNeighborId(tree, child, edgeDx[e], edgeDy[e]);
+                QuadtreeNode* fine = fineId != CHUNK_ID_INVALID ? CubicQuadTree_FindNode(tree, fineId) : NULL;
+                if (fine && fine->isLeaf) fine->coarserEdges = CubicQuadTree_GetCoarserEdges(tree, fine->id);
+            }
+        }
+    }
+}
+
+void CubicQuadTree_Update(CubicQuadTree* tree, Vector3 cameraPosition, QuadtreeLeafChanges* changes) {
+    // Balancing works off the diff, so keep one even if the caller does not
+    QuadtreeLeafChanges scratch;
+    QuadtreeLeafChanges* diff = changes;
+    if (!diff) {
+        QuadtreeLeafChanges_Init(&scratch);
+        diff = &scratch;
+    }
+    int firstAdded = diff->addedCount;
+
     for (int i = 0; i < 6; i++) {
-        Quadtree_Insert(tree->faces[i], cameraPosition, onSplit);
+        Quadtree_Update(tree->faces[i], cameraPosition, diff);
     }
+    BalanceLeaves(tree, diff, firstAdded);
+    UpdateCoarserEdges(tree, diff, firstAdded);
+
+    if (!changes) QuadtreeLeafChanges_Free(&scratch);
 }
 
 void CubicQuadTree_GetLeafNodes(CubicQuadTree* tree, QuadtreeNode*** outNodes, int* outCount) {
@@ -64,6 +191,117 @@ void CubicQuadTree_GetLeafNodes(CubicQuadTree* tree, QuadtreeNode*** outNodes, i
     }
 }
 
+// Face transforms are rotations by multiples of 90 degrees plus a push out
+// along the face normal. Rounded to integers they map tile coordinates
+// exactly, with no float error at deep levels.
+typedef struct FaceBasis {
+    int axes[3][3]; // cube = axes * local (rows = cube axes)
+    int normal[3];  // Outward face normal
+} FaceBasis;
+
+static FaceBasis GetFaceBasis(const Quadtree* face) {
+    Matrix m = face->localToWorld;
+    float rows[3][4] = {
+        { m.m0, m.m4, m.m8, m.m12 },
+        { m.m1, m.m5, m.m9, m.m13 },
+        { m.m2, m.m6, m.m10, m.m14 }
+    };
+    FaceBasis basis;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            basis.axes[i][j] = (int)roundf(rows[i][j]);
+        }
+        basis.normal[i] = (int)roundf(rows[i][3] / face->size);
+    }
+    return basis;
+}
+
+ChunkId CubicQuadTree_GetNeighborId(const CubicQuadTree* tree, ChunkId id, int dx, int dy) {
+    ChunkId sameFace = ChunkId_GetNeighbor(id, dx, dy);
+    if (sameFace != CHUNK_ID_INVALID) return sameFace;
+    if (abs(dx) + abs(dy) != 1) return CHUNK_ID_INVALID; // Cube corners have no single neighbor
+
+    // Work in half-tile units, where the face spans [-tiles, tiles] and tile
+    // centers sit on odd coordinates
+    int level = ChunkId_GetLevel(id);
+    long long tiles = 1LL << level;
+    long long local[3] = {
+        2 * ((long long)ChunkId_GetX(id) + dx) + 1 - tiles,
+        2 * ((long long)ChunkId_GetY(id) + dy) + 1 - tiles,
+        0
+    };
+
+    FaceBasis from = GetFaceBasis(tree->faces[ChunkId_GetFace(id)]);
+    long long cube[3];
+    int normalAxis = 0;
+    for (int i = 0; i < 3; i++) {
+        cube[i] = from.normal[i] * tiles;
+        for (int j = 0; j < 3; j++) cube[i] += from.axes[i][j] * local[j];
+        if (from.normal[i] != 0) normalAxis = i;
+    }
+
+    // The center overhangs one face edge: fold the overhang around it
+    int edgeAxis = -1;
+    for (int i = 0; i < 3; i++) {
+        if (i != normalAxis && llabs(cube[i]) > tiles) edgeAxis = i;
+    }
+    if (edgeAxis < 0) return CHUNK_ID_INVALID;
+    long long overhang = llabs(cube[edgeAxis]) - tiles;
+    int edgeSign = cube[edgeAxis] > 0 ? 1 : -1;
+    cube[edgeAxis] = edgeSign * tiles;
+    cube[normalAxis] -= from.normal[normalAxis] * overhang;
+
+    for (int face = 0; face < 6; face++) {
+        FaceBasis to = GetFaceBasis(tree->faces[face]);
+        if (to.normal[edgeAxis] != edgeSign) continue;
+
+        // Rotations are orthogonal: local = axes^T * (cube - normal * tiles)
+        long long target[3];
+        for (int j = 0; j < 3; j++) {
+            target[j] = 0;
+            for (int i = 0; i < 3; i++) target[j] += to.axes[i][j] * (cube[i] - to.normal[i] * tiles);
+        }
+        return ChunkId_Make(face, level, (unsigned int)((target[0] + tiles - 1) / 2),
+                            (unsigned int)((target[1] + tiles - 1) / 2));
+    }
+    return CHUNK_ID_INVALID;
+}
+
+int CubicQuadTree_ProjectDirection(const CubicQuadTree* tree, Vector3 direction, float* x, float* y) {
+    // The face whose outward normal (its translation over the size) is
+    // closest to the direction
+    int best = 0;
+    float bestDot = -INFINITY;
+    for (int face = 0; face < 6; face++) {
+        const Quadtree* q = tree->faces[face];
+        Matrix m = q->localToWorld;
+        float dot = (m.m12 * direction.x + m.m13 * direction.y + m.m14 * direction.z) / q->size;
+        if (dot > bestDot) {
+            bestDot = dot;
+            best = face;
+        }
+    }
+
+    // Onto the cube face, then into the face's local axes
+    const Quadtree* q = tree->faces[best];
+    Matrix m = q->localToWorld;
+    float scale = bestDot > 0.0f ? q->size / bestDot : 0.0f;
+    Vector3 cube = Vector3Scale(direction, scale);
+    *x = m.m0 * cube.x + m.m1 * cube.y + m.m2 * cube.z;
+    *y = m.m4 * cube.x + m.m5 * cube.y + m.m6 * cube.z;
+    return best;
+}
+
+QuadtreeNode* CubicQuadTree_FindNode(CubicQuadTree* tree, ChunkId id) {
+    if (!ChunkId_IsValid(id)) return NULL;
+    return Quadtree_FindNode(tree->faces[ChunkId_GetFace(id)], id);
+}
+
+void CubicQuadTree_ReportMeshError(CubicQuadTree* tree, ChunkId id, float parentError) {
+    if (!ChunkId_IsValid(id)) return;
+    Quadtree_ReportMeshError(tree->faces[ChunkId_GetFace(id)], id, parentError);
+}
+
 void CubicQuadTree_Free(CubicQuadTree* tree) {
     for (int i = 0; i < 6; i++) {
         Quadtree_Free(tree->faces[i]);
@@ -1,4 +1,5 @@
 #include "math_utils.h"
+#include <math.h>
 
 Vector3 Vector3AddScalar(Vector3 v, float scalar) {
     return (Vector3){ v.x + scalar, v.y + scalar, v.z + scalar };
@@ -23,3 +24,48 @@ Vector3 BoundingBoxSize(BoundingBox3 box) {
         box.max.z - box.min.z
     };
 }
+
+static Vector4 NormalizePlane(float a, float b, float c, float d) {
+    float length = sqrtf(a * a + b * b + c * c);
+    if (length > 0.0f) {
+        float inv = 1.0f / length;
+        a *= inv; b *= inv; c *= inv; d *= inv;
+    }
+    return (Vector4){ a, b, c, d };
+}
+
+Frustum FrustumFromMatrix(Matrix m) {
+    // Rows of the matrix as applied to column vectors (clip = M * v)
+    // row0 = (m0, m4, m8, m12), row1 = (m1, m5, m9, m13), ...
+    Frustum frustum;
+    frustum.planes[0] = NormalizePlane(m.m3 + m.m0, m.m7 + m.m4, m.m11 + m.m8,  m.m15 + m.m12); // Left
+    frustum.planes[1] = NormalizePlane(m.m3 - m.m0, m.m7 - m.m4, m.m11 - m.m8,  m.m15 - m.m12); // Right
+    frustum.planes[2] = NormalizePlane(m.m3 + m.m1, m.m7 + m.m5, m.m11 + m.m9,  m.m15 + m.m13); // Bottom
+    frustum.planes[3] = NormalizePlane(m.m3 - m.m1, m.m7 - m.m5, m.m11 - m.m9,  m.m15 - m.m13); // Top
+    frustum.planes[4] = NormalizePlane(m.m3 + m.m2, m.m7 + m.m6, m.m11 + m.m10, m.m15 + m.m14); // Near
+    frustum.planes[5] = NormalizePlane(m.m3 - m.m2, m.m7 - m.m6, m.m11 - m.m10, m.m15 - m.m14); // Far
+    return frustum;
+}
+
+FrustumTestResult FrustumTestSphere(const Frustum* frustum, Vector3 center, float radius) {
+    FrustumTestResult result = FRUSTUM_INSIDE;
+    for (int i = 0; i < 6; i++) {
+        Vector4 p = frustum->planes[i];
+        float distance = p.x * center.x + p.y * center.y + p.z * center.z + p.w;
+        if (distance < -radius) return FRUSTUM_OUTSIDE;
+        if (distance < radius) result = FRUSTUM_INTERSECTS;
+    }
+    return result;
+}
+
+bool IsSphereBelowHorizon(Vector3 cameraPosition, Vector3 planetCenter, float occluderRadius, float maxSurfaceRadius, Vector3 center, float radius) {
+    // A surface point at most maxSurfaceRadius from the center is visible only if it is
+    // closer than the camera's horizon distance plus that point's own horizon distance
+    float cameraDistSqr = Vector3DistanceSqr(cameraPosition, planetCenter);
+    float occluderSqr = occluderRadius * occluderRadius;
+    if (cameraDistSqr <= occluderSqr) return false; // Inside the occluder, nothing to cull
+
+    float maxVisibleDistance = sqrtf(cameraDistSqr - occluderSqr) +
+                               sqrtf(fmaxf(maxSurfaceRadius * maxSurfaceRadius - occluderSqr, 0.0f));
+    return Vector3Distance(cameraPosition, center) - radius > maxVisibleDistance;
+}
@@ -1,5 +1,7 @@
 #include "noise.h"
 #include <math.h>
+#include <stdlib.h>
+#include <pthread.h>
 
 // Hash function for pseudo-random values
 static unsigned int hash(unsigned int x) {
@@ -297,3 +299,141 @@ float MoonTerrain(float x, float y) {
 
     return terrain;
 }
+
+// --- Batch evaluation ---
+
+// Scalar reference: every SIMD kernel is checked against this
+static void MoonTerrainBatch_Scalar(const float* x, const float* y, float* out, int count) {
+    for (int i = 0; i < count; i++) {
+        out[i] = MoonTerrain(x[i], y[i]);
+    }
+}
+
+typedef void (*MoonTerrainBatchFunction)(const float* x, const float* y, float* out, int count);
+
+// Per-ISA kernels (noise_sse2.c, noise_avx2.c, noise_avx512.c, noise_neon.c),
+// only linked on the architectures CMake builds them for
+#if defined(PLANET_NOISE_X86_KERNELS)
+void MoonTerrainBatch_SSE2(const float* x, const float* y, float* out, int count);
+void MoonTerrainBatch_AVX2(const float* x, const float* y, float* out, int count);
+void MoonTerrainBatch_AVX512(const float* x, const float* y, float* out, int count);
+#endif
+#if defined(PLANET_NOISE_NEON_KERNEL)
+void MoonTerrainBatch_NEON(const float* x, const float* y, float* out, int count);
+#endif
+
+#if defined(PLANET_NOISE_X86_KERNELS) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+
+// CPUID leaf 1/7 feature bits, plus the OS having enabled the YMM/ZMM state
+static bool CpuSupports(MoonTerrainKernel kernel) {
+    int info[4];
+    __cpuid(info, 1);
+    bool sse2 = (info[3] & (1 << 26)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (kernel == MOON_TERRAIN_KERNEL_SSE2) return sse2;
+    if (!osxsave) return false;
+
+    unsigned long long xcr0 = _xgetbv(0);
+    __cpuidex(info, 7, 0);
+    if (kernel == MOON_TERRAIN_KERNEL_AVX2) {
+        return (xcr0 & 0x6) == 0x6 && (info[1] & (1 << 5)) != 0;
+    }
+    if (kernel == MOON_TERRAIN_KERNEL_AVX512) {
+        return (xcr0 & 0xE6) == 0xE6 && (info[1] & (1 << 16)) != 0;
+    }
+    return false;
+}
+#elif defined(PLANET_NOISE_X86_KERNELS)
+static bool CpuSupports(MoonTerrainKernel kernel) {
+    __builtin_cpu_init();
+    if (kernel == MOON_TERRAIN_KERNEL_SSE2) return __builtin_cpu_supports("sse2");
+    if (kernel == MOON_TERRAIN_KERNEL_AVX2) return __builtin_cpu_supports("avx2");
+    if (kernel == MOON_TERRAIN_KERNEL_AVX512) return __builtin_cpu_supports("avx512f");
+    return false;
+}
+#endif
+
+static MoonTerrainBatchFunction GetKernelFunction(MoonTerrainKernel kernel) {
+    switch (kernel) {
+        case MOON_TERRAIN_KERNEL_SCALAR: return MoonTerrainBatch_Scalar;
+#if defined(PLANET_NOISE_X86_KERNELS)
+        case MOON_TERRAIN_KERNEL_SSE2: return CpuSupports(kernel) ? MoonTerrainBatch_SSE2 : NULL;
+        case MOON_TERRAIN_KERNEL_AVX2: return CpuSupports(kernel) ? MoonTerrainBatch_AVX2 : NULL;
+        case MOON_TERRAIN_KERNEL_AVX512: return CpuSupports(kernel) ? MoonTerrainBatch_AVX512 : NULL;
+#endif
+#if defined(PLANET_NOISE_NEON_KERNEL)
+        case MOON_TERRAIN_KERNEL_NEON: return MoonTerrainBatch_NEON; // Baseline on AArch64
+#endif
+        default: return NULL;
+    }
+}
+
+static pthread_once_t kernelOnce = PTHREAD_ONCE_INIT;
+static MoonTerrainBatchFunction kernelFunction = MoonTerrainBatch_Scalar;
+static MoonTerrainKernel kernelSelected = MOON_TERRAIN_KERNEL_SCALAR;
+
+// Widest kernel the CPU runs wins
+static void SelectFastestKernel(void) {
+    for (int kernel = MOON_TERRAIN_KERNEL_COUNT - 1; kernel > MOON_TERRAIN_KERNEL_SCALAR; kernel--) {
+        MoonTerrainBatchFunction function = GetKernelFunction((MoonTerrainKernel)kernel);
+        if (function) {
+            kernelFunction = function;
+            kernelSelected = (MoonTerrainKernel)kernel;
+            return;
+        }
+    }
+}
+
+void MoonTerrainBatch(const float* x, const float* y, float* out, int count) {
+    pthread_once(&kernelOnce, SelectFastestKernel);
+    kernelFunction(x, y, out, count);
+}
+
+MoonTerrainKernel MoonTerrainBatch_GetKernel(void) {
+    pthread_once(&kernelOnce, SelectFastestKernel);
+    return kernelSelected;
+}
+
+bool MoonTerrainBatch_IsKernelSupported(MoonTerrainKernel kernel) {
+    return GetKernelFunction(kernel) != NULL;
+}
+
+bool MoonTerrainBatch_SetKernel(MoonTerrainKernel kernel) {
+    pthread_once(&kernelOnce, SelectFastestKernel);
+    MoonTerrainBatchFunction function = GetKernelFunction(kernel);
+    if (!function) return false;
+    kernelFunction = function;
+    kernelSelected = kernel;
+    return true;
+}
+
+const char* MoonTerrainBatch_KernelName(MoonTerrainKernel kernel) {
+    switch (kernel) {
+        case MOON_TERRAIN_KERNEL_SCALAR: return "scalar";
+        case MOON_TERRAIN_KERNEL_SSE2: return "sse2";
+        case MOON_TERRAIN_KERNEL_AVX2: return "avx2";
+        case MOON_TERRAIN_KERNEL_AVX512: return "avx512";
+        case MOON_TERRAIN_KERNEL_NEON: return "neon";
+        default: return "unknown";
+    }
+}
+
+float MoonTerrainBatch_Validate(MoonTerrainKernel kernel, const float* x, const float* y, int count) {
+    MoonTerrainBatchFunction function = GetKernelFunction(kernel);
+    if (!function) return -1.0f;
+
+    float* expected = (float*)malloc(sizeof(float) * count * 2);
+    float* actual = expected + count;
+    MoonTerrainBatch_Scalar(x, y, expected, count);
+    function(x, y, actual, count);
+
+    float maxError = 0.0f;
+    for (int i = 0; i < count; i++) {
+        float error = fabsf(actual[i] - expected[i]);
+        if (!(error <= maxError)) maxError = error; // Also propagates NaN
+    }
+    free(expected);
+    return maxError;
+}
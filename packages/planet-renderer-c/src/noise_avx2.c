@@ -0,0 +1,42 @@
+// AVX2 MoonTerrain kernel, 8 samples per iteration (built with -mavx2)
+#include "noise.h"
+#include <immintrin.h>
+
+typedef __m256 vf;
+typedef __m256i vi;
+typedef __m256 vm;
+#define VW 8
+#define NOISE_KERNEL_ENTRY MoonTerrainBatch_AVX2
+
+#define vf_set1(a) _mm256_set1_ps(a)
+#define vf_load(p) _mm256_loadu_ps(p)
+#define vf_store(p, a) _mm256_storeu_ps(p, a)
+#define vf_add(a, b) _mm256_add_ps(a, b)
+#define vf_sub(a, b) _mm256_sub_ps(a, b)
+#define vf_mul(a, b) _mm256_mul_ps(a, b)
+#define vf_div(a, b) _mm256_div_ps(a, b)
+#define vf_min(a, b) _mm256_min_ps(a, b)
+#define vf_max(a, b) _mm256_max_ps(a, b)
+#define vf_sqrt(a) _mm256_sqrt_ps(a)
+#define vf_abs(a) _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a)
+#define vf_floor(a) _mm256_floor_ps(a)
+#define vf_lt(a, b) _mm256_cmp_ps(a, b, _CMP_LT_OQ)
+#define vf_gt(a, b) _mm256_cmp_ps(a, b, _CMP_GT_OQ)
+#define vf_select(m, a, b) _mm256_blendv_ps(b, a, m)
+#define vf_to_vi(a) _mm256_cvttps_epi32(a)
+#define vf_as_vi(a) _mm256_castps_si256(a)
+
+#define vi_set1(a) _mm256_set1_epi32(a)
+#define vi_add(a, b) _mm256_add_epi32(a, b)
+#define vi_sub(a, b) _mm256_sub_epi32(a, b)
+#define vi_and(a, b) _mm256_and_si256(a, b)
+#define vi_or(a, b) _mm256_or_si256(a, b)
+#define vi_xor(a, b) _mm256_xor_si256(a, b)
+#define vi_sll(a, n) _mm256_slli_epi32(a, n)
+#define vi_srl(a, n) _mm256_srli_epi32(a, n)
+#define vi_to_vf(a) _mm256_cvtepi32_ps(a)
+#define vi_as_vf(a) _mm256_castsi256_ps(a)
+#define vi_lane0(a) _mm_cvtsi128_si32(_mm256_castsi256_si128(a))
+#define vi_all_eq(a, b) (_mm256_movemask_epi8(_mm256_cmpeq_epi32(a, b)) == -1)
+
+#include "noise_simd_kernel.h"
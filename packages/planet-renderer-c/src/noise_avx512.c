@@ -0,0 +1,42 @@
+// AVX-512F MoonTerrain kernel, 16 samples per iteration (built with -mavx512f)
+#include "noise.h"
+#include <immintrin.h>
+
+typedef __m512 vf;
+typedef __m512i vi;
+typedef __mmask16 vm;
+#define VW 16
+#define NOISE_KERNEL_ENTRY MoonTerrainBatch_AVX512
+
+#define vf_set1(a) _mm512_set1_ps(a)
+#define vf_load(p) _mm512_loadu_ps(p)
+#define vf_store(p, a) _mm512_storeu_ps(p, a)
+#define vf_add(a, b) _mm512_add_ps(a, b)
+#define vf_sub(a, b) _mm512_sub_ps(a, b)
+#define vf_mul(a, b) _mm512_mul_ps(a, b)
+#define vf_div(a, b) _mm512_div_ps(a, b)
+#define vf_min(a, b) _mm512_min_ps(a, b)
+#define vf_max(a, b) _mm512_max_ps(a, b)
+#define vf_sqrt(a) _mm512_sqrt_ps(a)
+#define vf_abs(a) _mm512_abs_ps(a)
+#define vf_floor(a) _mm512_roundscale_ps(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC)
+#define vf_lt(a, b) _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ)
+#define vf_gt(a, b) _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ)
+#define vf_select(m, a, b) _mm512_mask_blend_ps(m, b, a)
+#define vf_to_vi(a) _mm512_cvttps_epi32(a)
+#define vf_as_vi(a) _mm512_castps_si512(a)
+
+#define vi_set1(a) _mm512_set1_epi32(a)
+#define vi_add(a, b) _mm512_add_epi32(a, b)
+#define vi_sub(a, b) _mm512_sub_epi32(a, b)
+#define vi_and(a, b) _mm512_and_si512(a, b)
+#define vi_or(a, b) _mm512_or_si512(a, b)
+#define vi_xor(a, b) _mm512_xor_si512(a, b)
+#define vi_sll(a, n) _mm512_slli_epi32(a, n)
+#define vi_srl(a, n) _mm512_srli_epi32(a, n)
+#define vi_to_vf(a) _mm512_cvtepi32_ps(a)
+#define vi_as_vf(a) _mm512_castsi512_ps(a)
+#define vi_lane0(a) _mm_cvtsi128_si32(_mm512_castsi512_si128(a))
+#define vi_all_eq(a, b) (_mm512_cmpeq_epi32_mask(a, b) == 0xFFFF)
+
+#include "noise_simd_kernel.h"
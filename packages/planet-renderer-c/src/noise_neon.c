@@ -0,0 +1,42 @@
+// NEON MoonTerrain kernel, 4 samples per iteration (AArch64)
+#include "noise.h"
+#include <arm_neon.h>
+
+typedef float32x4_t vf;
+typedef int32x4_t vi;
+typedef uint32x4_t vm;
+#define VW 4
+#define NOISE_KERNEL_ENTRY MoonTerrainBatch_NEON
+
+#define vf_set1(a) vdupq_n_f32(a)
+#define vf_load(p) vld1q_f32(p)
+#define vf_store(p, a) vst1q_f32(p, a)
+#define vf_add(a, b) vaddq_f32(a, b)
+#define vf_sub(a, b) vsubq_f32(a, b)
+#define vf_mul(a, b) vmulq_f32(a, b)
+#define vf_div(a, b) vdivq_f32(a, b)
+#define vf_min(a, b) vminq_f32(a, b)
+#define vf_max(a, b) vmaxq_f32(a, b)
+#define vf_sqrt(a) vsqrtq_f32(a)
+#define vf_abs(a) vabsq_f32(a)
+#define vf_floor(a) vrndmq_f32(a)
+#define vf_lt(a, b) vcltq_f32(a, b)
+#define vf_gt(a, b) vcgtq_f32(a, b)
+#define vf_select(m, a, b) vbslq_f32(m, a, b)
+#define vf_to_vi(a) vcvtq_s32_f32(a)
+#define vf_as_vi(a) vreinterpretq_s32_f32(a)
+
+#define vi_set1(a) vdupq_n_s32(a)
+#define vi_add(a, b) vaddq_s32(a, b)
+#define vi_sub(a, b) vsubq_s32(a, b)
+#define vi_and(a, b) vandq_s32(a, b)
+#define vi_or(a, b) vorrq_s32(a, b)
+#define vi_xor(a, b) veorq_s32(a, b)
+#define vi_sll(a, n) vshlq_n_s32(a, n)
+#define vi_srl(a, n) vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(a), n))
+#define vi_to_vf(a) vcvtq_f32_s32(a)
+#define vi_as_vf(a) vreinterpretq_f32_s32(a)
+#define vi_lane0(a) vgetq_lane_s32(a, 0)
+#define vi_all_eq(a, b) (vminvq_u32(vceqq_s32(a, b)) != 0)
+
+#include "noise_simd_kernel.h"
@@ -0,0 +1,395 @@
+// Vectorized MoonTerrain, shared by the per-ISA kernels (noise_sse2.c,
+// noise_avx2.c, noise_avx512.c, noise_neon.c). Not a public header.
+//
+// The including file defines, for its instruction set:
+//   vf, vi, vm          float vector, int32 vector, comparison mask
+//   VW                  lanes per vector
+//   NOISE_KERNEL_ENTRY  name of the exported batch function
+// and the operations used below (vf_*, vi_*; masks only feed vf_select;
+// vi_lane0 extracts the first lane, vi_all_eq compares all lanes).
+//
+// Every step follows the scalar code in noise.c operation for operation, so
+// hashing, value noise, FBM and Worley distances match bit for bit. Only
+// powf and sinf are replaced by polynomial approximations (Cephes-style
+// exp/log, Taylor cosine); the batch result stays within ~1e-6 of
+// MoonTerrain (checked by MoonTerrainBatch_Validate).
+//
+// Hashes are cached per lattice cell (see NK_NoiseCell), which skips most
+// of them for octaves coarser than the sample spacing without changing a bit.
+//
+// CraterFieldSized is not evaluated: MoonTerrain does not add its result.
+
+#ifndef NOISE_KERNEL_ENTRY
+#error "Define the vector operations and NOISE_KERNEL_ENTRY before including noise_simd_kernel.h"
+#endif
+
+// --- Hashing (matches hash / hash2D / randomValue*) ---
+
+static inline vi NK_Hash(vi x) {
+    x = vi_add(x, vi_sll(x, 10));
+    x = vi_xor(x, vi_srl(x, 6));
+    x = vi_add(x, vi_sll(x, 3));
+    x = vi_xor(x, vi_srl(x, 11));
+    x = vi_add(x, vi_sll(x, 15));
+    return x;
+}
+
+static inline vf NK_Random01(vi x, vi y) {
+    vi h = vi_and(NK_Hash(vi_xor(x, NK_Hash(y))), vi_set1(0xFFFF));
+    return vf_div(vi_to_vf(h), vf_set1(65535.0f));
+}
+
+static inline vf NK_Random(vi x, vi y) {
+    return vf_sub(vf_mul(NK_Random01(x, y), vf_set1(2.0f)), vf_set1(1.0f));
+}
+
+static inline vf NK_Smoothstep(vf t) {
+    return vf_mul(vf_mul(t, t), vf_sub(vf_set1(3.0f), vf_mul(vf_set1(2.0f), t)));
+}
+
+static inline vf NK_Lerp(vf a, vf b, vf t) {
+    return vf_add(a, vf_mul(vf_sub(b, a), t));
+}
+
+// --- Transcendentals (only used where the scalar code calls powf/sinf) ---
+
+// Natural log for positive normal floats
+static inline vf NK_Log(vf x) {
+    vi bits = vf_as_vi(x);
+    vf e = vi_to_vf(vi_sub(vi_srl(bits, 23), vi_set1(126)));
+    vf m = vi_as_vf(vi_or(vi_and(bits, vi_set1(0x807FFFFF)), vi_set1(0x3F000000))); // [0.5, 1)
+
+    // Shift the mantissa into [sqrt(0.5), sqrt(2)) around 1
+    vm small = vf_lt(m, vf_set1(0.707106781186547524f));
+    e = vf_sub(e, vf_select(small, vf_set1(1.0f), vf_set1(0.0f)));
+    vf t = vf_sub(vf_add(m, vf_select(small, m, vf_set1(0.0f))), vf_set1(1.0f));
+
+    vf z = vf_mul(t, t);
+    vf p = vf_set1(7.0376836292E-2f);
+    p = vf_add(vf_mul(p, t), vf_set1(-1.1514610310E-1f));
+    p = vf_add(vf_mul(p, t), vf_set1(1.1676998740E-1f));
+    p = vf_add(vf_mul(p, t), vf_set1(-1.2420140846E-1f));
+    p = vf_add(vf_mul(p, t), vf_set1(1.4249322787E-1f));
+    p = vf_add(vf_mul(p, t), vf_set1(-1.6668057665E-1f));
+    p = vf_add(vf_mul(p, t), vf_set1(2.0000714765E-1f));
+    p = vf_add(vf_mul(p, t), vf_set1(-2.4999993993E-1f));
+    p = vf_add(vf_mul(p, t), vf_set1(3.3333331174E-1f));
+    p = vf_mul(vf_mul(p, t), z);
+
+    p = vf_add(p, vf_mul(e, vf_set1(-2.12194440E-4f)));
+    p = vf_sub(p, vf_mul(z, vf_set1(0.5f)));
+    return vf_add(vf_add(t, p), vf_mul(e, vf_set1(0.693359375f)));
+}
+
+// exp for arguments in [-87, 88]
+static inline vf NK_Exp(vf x) {
+    vf n = vf_floor(vf_add(vf_mul(x, vf_set1(1.44269504088896341f)), vf_set1(0.5f)));
+    x = vf_sub(x, vf_mul(n, vf_set1(0.693359375f)));
+    x = vf_sub(x, vf_mul(n, vf_set1(-2.12194440E-4f)));
+
+    vf z = vf_mul(x, x);
+    vf p = vf_set1(1.9875691500E-4f);
+    p = vf_add(vf_mul(p, x), vf_set1(1.3981999507E-3f));
+    p = vf_add(vf_mul(p, x), vf_set1(8.3334519073E-3f));
+    p = vf_add(vf_mul(p, x), vf_set1(4.1665795894E-2f));
+    p = vf_add(vf_mul(p, x), vf_set1(1.6666665459E-1f));
+    p = vf_add(vf_mul(p, x), vf_set1(5.0000001201E-1f));
+    p = vf_add(vf_add(vf_mul(p, z), x), vf_set1(1.0f));
+
+    vi scale = vi_sll(vi_add(vf_to_vi(n), vi_set1(127)), 23);
+    return vf_mul(p, vi_as_vf(scale));
+}
+
+// sin(a) for a in [0, pi], as cos(a - pi/2) with a Taylor series to t^12
+static inline vf NK_SinHalfTurn(vf a) {
+    vf t = vf_sub(a, vf_set1(1.57079637f));
+    vf s = vf_mul(t, t);
+    vf p = vf_set1(1.0f / 479001600.0f);
+    p = vf_add(vf_mul(p, s), vf_set1(-1.0f / 3628800.0f));
+    p = vf_add(vf_mul(p, s), vf_set1(1.0f / 40320.0f));
+    p = vf_add(vf_mul(p, s), vf_set1(-1.0f / 720.0f));
+    p = vf_add(vf_mul(p, s), vf_set1(1.0f / 24.0f));
+    p = vf_add(vf_mul(p, s), vf_set1(-0.5f));
+    return vf_add(vf_mul(p, s), vf_set1(1.0f));
+}
+
+// --- Cell caches ---
+// Chunks are sampled row by row, so the lanes of a vector are grid
+// neighbors, and an octave (or crater layer) coarser than a few grid cells
+// puts all of them in the same lattice cell. Each call site keeps the hashed
+// corners of the last such cell (for a crater layer, its Worley points and
+// crater size) and reuses them while the following vectors stay inside:
+// low-frequency layers hash per cell instead of per sample, which at deep
+// LOD levels is once or twice per chunk. Octaves finer than that straddle
+// cells and hash per lane as before. The values are the same either way.
+
+typedef struct NK_NoiseCell {
+    vi x, y;      // Lattice cell of all lanes, once filled
+    bool filled;
+    vf v00, v10, v01, v11;
+} NK_NoiseCell;
+
+typedef struct NK_CraterCell {
+    vi x, y;      // Worley cell of all lanes, once filled
+    bool filled;
+    vf pointX[9]; // Points of the 3x3 neighborhood, NK_WorleyPoints order
+    vf pointY[9];
+    vf craterSize;
+} NK_CraterCell;
+
+// One per NK_MoonTerrain call site, in MoonTerrain order
+typedef struct NK_Cache {
+    NK_NoiseCell maria[3];
+    NK_CraterCell largeCraters;
+    NK_CraterCell complexCraters;
+    NK_CraterCell simpleCraters;
+    NK_CraterCell smallCraters;
+    NK_NoiseCell ridges[2];
+    NK_NoiseCell highlandRoughness[3];
+    NK_NoiseCell mariaRoughness[2];
+    NK_NoiseCell regolith[3];
+} NK_Cache;
+
+static void NK_ClearCache(NK_Cache* cache) {
+    NK_NoiseCell* noiseCells[] = { cache->maria, cache->ridges, cache->highlandRoughness,
+                                   cache->mariaRoughness, cache->regolith };
+    int counts[] = { 3, 2, 3, 2, 3 };
+    for (int i = 0; i < 5; i++) {
+        for (int k = 0; k < counts[i]; k++) noiseCells[i][k].filled = false;
+    }
+    cache->largeCraters.filled = false;
+    cache->complexCraters.filled = false;
+    cache->simpleCraters.filled = false;
+    cache->smallCraters.filled = false;
+}
+
+// Every lane is in the cached cell
+static inline bool NK_CellHit(bool filled, vi cachedX, vi cachedY, vi x, vi y) {
+    return filled && vi_all_eq(x, cachedX) && vi_all_eq(y, cachedY);
+}
+
+// Every lane is in the same cell
+static inline bool NK_CellUniform(vi x, vi y) {
+    return vi_all_eq(x, vi_set1(vi_lane0(x))) && vi_all_eq(y, vi_set1(vi_lane0(y)));
+}
+
+// --- Noise primitives ---
+
+static inline vf NK_Noise2D(vf x, vf y, NK_NoiseCell* cell) {
+    vf fx0 = vf_floor(x);
+    vf fy0 = vf_floor(y);
+    vi x0 = vf_to_vi(fx0);
+    vi y0 = vf_to_vi(fy0);
+
+    vf sx = NK_Smoothstep(vf_sub(x, fx0));
+    vf sy = NK_Smoothstep(vf_sub(y, fy0));
+
+    vf v00, v10, v01, v11;
+    if (NK_CellHit(cell->filled, cell->x, cell->y, x0, y0)) {
+        v00 = cell->v00;
+        v10 = cell->v10;
+        v01 = cell->v01;
+        v11 = cell->v11;
+    } else {
+        vi x1 = vi_add(x0, vi_set1(1));
+        vi y1 = vi_add(y0, vi_set1(1));
+        v00 = NK_Random(x0, y0);
+        v10 = NK_Random(x1, y0);
+        v01 = NK_Random(x0, y1);
+        v11 = NK_Random(x1, y1);
+        if (NK_CellUniform(x0, y0)) {
+            cell->x = x0;
+            cell->y = y0;
+            cell->filled = true;
+            cell->v00 = v00;
+            cell->v10 = v10;
+            cell->v01 = v01;
+            cell->v11 = v11;
+        }
+    }
+
+    return NK_Lerp(NK_Lerp(v00, v10, sx), NK_Lerp(v01, v11, sx), sy);
+}
+
+// cells: one per octave
+static inline vf NK_FBM(vf x, vf y, int octaves, float persistence, float lacunarity, NK_NoiseCell* cells) {
+    vf total = vf_set1(0.0f);
+    float amplitude = 1.0f;
+    float frequency = 1.0f;
+    float maxValue = 0.0f;
+
+    for (int i = 0; i < octaves; i++) {
+        vf f = vf_set1(frequency);
+        total = vf_add(total, vf_mul(NK_Noise2D(vf_mul(x, f), vf_mul(y, f), &cells[i]), vf_set1(amplitude)));
+        maxValue += amplitude;
+        amplitude *= persistence;
+        frequency *= lacunarity;
+    }
+
+    return vf_div(total, vf_set1(maxValue));
+}
+
+// Worley points of the 3x3 cells around (xi, yi), row by row
+static inline void NK_WorleyPoints(vi xi, vi yi, vf* pointX, vf* pointY) {
+    for (int yOffset = -1, k = 0; yOffset <= 1; yOffset++) {
+        vi cellY = vi_add(yi, vi_set1(yOffset));
+        vi cellYOffset = vi_add(cellY, vi_set1(1000));
+        vf cellYf = vi_to_vf(cellY);
+        for (int xOffset = -1; xOffset <= 1; xOffset++, k++) {
+            vi cellX = vi_add(xi, vi_set1(xOffset));
+            pointX[k] = vf_add(vi_to_vf(cellX), NK_Random01(cellX, cellY));
+            pointY[k] = vf_add(cellYf, NK_Random01(cellX, cellYOffset));
+        }
+    }
+}
+
+// Distance to the nearest Worley point. sqrt is monotonic, so taking it
+// once on the smallest squared distance gives the scalar result exactly.
+static inline vf NK_WorleyF1(vf x, vf y, const vf* pointX, const vf* pointY) {
+    vf minDistSqr = vf_set1(10000.0f * 10000.0f);
+    for (int k = 0; k < 9; k++) {
+        vf dx = vf_sub(x, pointX[k]);
+        vf dy = vf_sub(y, pointY[k]);
+        minDistSqr = vf_min(minDistSqr, vf_add(vf_mul(dx, dx), vf_mul(dy, dy)));
+    }
+    return vf_sqrt(minDistSqr);
+}
+
+static inline vf NK_CraterProfile(vf d) {
+    // Bowl interior: (1 - (d / 0.95)^2)^0.8, negated
+    vf n = vf_div(d, vf_set1(0.95f));
+    vf bowl = vf_sub(vf_set1(1.0f), vf_mul(n, n));
+    bowl = NK_Exp(vf_mul(NK_Log(vf_max(bowl, vf_set1(1e-30f))), vf_set1(0.8f)));
+    bowl = vf_sub(vf_set1(0.0f), bowl);
+
+    // Raised rim
+    vf rimPos = vf_div(vf_sub(d, vf_set1(0.95f)), vf_set1(0.1f));
+    vf rim = vf_mul(NK_SinHalfTurn(vf_mul(rimPos, vf_set1(3.14159f))), vf_set1(0.3f));
+
+    // Ejecta blanket
+    vf ejectaDist = vf_div(vf_sub(d, vf_set1(1.05f)), vf_set1(0.15f));
+    vf ejecta = vf_mul(vf_sub(vf_set1(1.0f), ejectaDist), vf_set1(0.1f));
+
+    vf result = vf_select(vf_lt(d, vf_set1(1.05f)), rim, ejecta);
+    result = vf_select(vf_lt(d, vf_set1(0.95f)), bowl, result);
+    return vf_select(vf_gt(d, vf_set1(1.2f)), vf_set1(0.0f), result);
+}
+
+static inline vf NK_CraterField(vf x, vf y, float scale, float intensity, NK_CraterCell* cell) {
+    vf sx = vf_mul(x, vf_set1(scale));
+    vf sy = vf_mul(y, vf_set1(scale));
+    vi cellX = vf_to_vi(vf_floor(sx));
+    vi cellY = vf_to_vi(vf_floor(sy));
+
+    vf lanePointX[9], lanePointY[9];
+    vf* pointX = cell->pointX;
+    vf* pointY = cell->pointY;
+    vf craterSize;
+    if (NK_CellHit(cell->filled, cell->x, cell->y, cellX, cellY)) {
+        craterSize = cell->craterSize;
+    } else {
+        bool uniform = NK_CellUniform(cellX, cellY);
+        if (!uniform) {
+            pointX = lanePointX;
+            pointY = lanePointY;
+        }
+        NK_WorleyPoints(cellX, cellY, pointX, pointY);
+        craterSize = vf_add(vf_set1(0.3f), vf_mul(NK_Random01(cellX, cellY), vf_set1(0.4f)));
+        if (uniform) {
+            cell->x = cellX;
+            cell->y = cellY;
+            cell->filled = true;
+            cell->craterSize = craterSize;
+        }
+    }
+
+    vf f1 = NK_WorleyF1(sx, sy, pointX, pointY);
+    vf craterHeight = NK_CraterProfile(vf_div(f1, craterSize));
+    vf depthRatio = vf_sub(vf_set1(0.5f), vf_mul(craterSize, vf_set1(0.15f)));
+
+    return vf_mul(vf_mul(craterHeight, depthRatio), vf_set1(intensity));
+}
+
+static inline vf NK_WrinkleRidges(vf x, vf y, NK_NoiseCell* cells) {
+    vf n1 = vf_abs(NK_Noise2D(vf_mul(x, vf_set1(0.3f)), vf_mul(y, vf_set1(0.3f)), &cells[0]));
+    vf n2 = vf_abs(NK_Noise2D(vf_add(vf_mul(x, vf_set1(0.5f)), vf_set1(100.0f)),
+                              vf_add(vf_mul(y, vf_set1(0.5f)), vf_set1(100.0f)), &cells[1]));
+
+    vf ridges = vf_add(vf_mul(vf_sub(vf_set1(1.0f), n1), vf_set1(0.6f)),
+                       vf_mul(vf_sub(vf_set1(1.0f), n2), vf_set1(0.4f)));
+
+    // ridges^2.5
+    ridges = vf_mul(vf_mul(ridges, ridges), vf_sqrt(ridges));
+
+    return vf_mul(ridges, vf_set1(0.15f));
+}
+
+static inline vf NK_MariaPattern(vf x, vf y, NK_NoiseCell* cells) {
+    vf largeScale = NK_FBM(vf_mul(x, vf_set1(0.08f)), vf_mul(y, vf_set1(0.08f)), 3, 0.5f, 2.0f, cells);
+    vf t = vf_div(vf_add(largeScale, vf_set1(0.3f)), vf_set1(0.6f));
+    t = vf_min(vf_max(t, vf_set1(0.0f)), vf_set1(1.0f));
+    return NK_Smoothstep(t);
+}
+
+static inline vf NK_MoonTerrain(vf x, vf y, NK_Cache* cache) {
+    vf mariaAmount = NK_MariaPattern(x, y, cache->maria);
+    vf highlandAmount = vf_sub(vf_set1(1.0f), mariaAmount);
+
+    vf baseElevation = vf_sub(vf_mul(highlandAmount, vf_set1(0.3f)), vf_mul(mariaAmount, vf_set1(0.3f)));
+
+    vf largeCraters = NK_CraterField(x, y, 0.15f, 3.0f, &cache->largeCraters);
+    vf complexCraters = NK_CraterField(x, y, 0.5f, 2.0f, &cache->complexCraters);
+    vf simpleCraters = vf_mul(NK_CraterField(x, y, 2.0f, 0.8f, &cache->simpleCraters),
+                              vf_add(vf_set1(0.5f), vf_mul(highlandAmount, vf_set1(0.5f))));
+    vf smallCraters = vf_mul(NK_CraterField(x, y, 8.0f, 0.4f, &cache->smallCraters),
+                             vf_add(vf_set1(0.3f), vf_mul(highlandAmount, vf_set1(0.7f))));
+
+    vf ridges = vf_mul(NK_WrinkleRidges(x, y, cache->ridges), mariaAmount);
+
+    vf highlandRoughness = vf_mul(vf_mul(NK_FBM(vf_mul(x, vf_set1(5.0f)), vf_mul(y, vf_set1(5.0f)), 3, 0.6f, 2.0f,
+                                                cache->highlandRoughness),
+                                         vf_set1(0.2f)), highlandAmount);
+    vf mariaRoughness = vf_mul(vf_mul(NK_FBM(vf_mul(x, vf_set1(15.0f)), vf_mul(y, vf_set1(15.0f)), 2, 0.3f, 2.0f,
+                                             cache->mariaRoughness),
+                                      vf_set1(0.02f)), mariaAmount);
+    vf regolith = vf_mul(NK_FBM(vf_mul(x, vf_set1(30.0f)), vf_mul(y, vf_set1(30.0f)), 3, 0.5f, 2.0f,
+                                cache->regolith),
+                         vf_set1(0.005f));
+
+    // Same summation order as MoonTerrain
+    vf terrain = baseElevation;
+    terrain = vf_add(terrain, largeCraters);
+    terrain = vf_add(terrain, vf_mul(complexCraters, vf_set1(0.8f)));
+    terrain = vf_add(terrain, vf_mul(simpleCraters, vf_set1(0.6f)));
+    terrain = vf_add(terrain, vf_mul(smallCraters, vf_set1(0.3f)));
+    terrain = vf_add(terrain, ridges);
+    terrain = vf_add(terrain, highlandRoughness);
+    terrain = vf_add(terrain, mariaRoughness);
+    terrain = vf_add(terrain, regolith);
+    return terrain;
+}
+
+void NOISE_KERNEL_ENTRY(const float* x, const float* y, float* out, int count) {
+    NK_Cache cache;
+    NK_ClearCache(&cache);
+
+    int i = 0;
+    for (; i + VW <= count; i += VW) {
+        vf_store(out + i, NK_MoonTerrain(vf_load(x + i), vf_load(y + i), &cache));
+    }
+
+    // Tail: pad the last vector by repeating the final sample
+    if (i < count) {
+        float tx[VW], ty[VW], tout[VW];
+        int remaining = count - i;
+        for (int k = 0; k < VW; k++) {
+            int src = i + (k < remaining ? k : remaining - 1);
+            tx[k] = x[src];
+            ty[k] = y[src];
+        }
+        vf_store(tout, NK_MoonTerrain(vf_load(tx), vf_load(ty), &cache));
+        for (int k = 0; k < remaining; k++) {
+            out[i + k] = tout[k];
+        }
+    }
+}
@@ -0,0 +1,47 @@
+// SSE2 MoonTerrain kernel, 4 samples per iteration (baseline on x86-64)
+#include "noise.h"
+#include <emmintrin.h>
+
+typedef __m128 vf;
+typedef __m128i vi;
+typedef __m128 vm;
+#define VW 4
+#define NOISE_KERNEL_ENTRY MoonTerrainBatch_SSE2
+
+#define vf_set1(a) _mm_set1_ps(a)
+#define vf_load(p) _mm_loadu_ps(p)
+#define vf_store(p, a) _mm_storeu_ps(p, a)
+#define vf_add(a, b) _mm_add_ps(a, b)
+#define vf_sub(a, b) _mm_sub_ps(a, b)
+#define vf_mul(a, b) _mm_mul_ps(a, b)
+#define vf_div(a, b) _mm_div_ps(a, b)
+#define vf_min(a, b) _mm_min_ps(a, b)
+#define vf_max(a, b) _mm_max_ps(a, b)
+#define vf_sqrt(a) _mm_sqrt_ps(a)
+#define vf_abs(a) _mm_andnot_ps(_mm_set1_ps(-0.0f), a)
+#define vf_lt(a, b) _mm_cmplt_ps(a, b)
+#define vf_gt(a, b) _mm_cmpgt_ps(a, b)
+#define vf_select(m, a, b) _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b))
+#define vf_to_vi(a) _mm_cvttps_epi32(a)
+#define vf_as_vi(a) _mm_castps_si128(a)
+
+#define vi_set1(a) _mm_set1_epi32(a)
+#define vi_add(a, b) _mm_add_epi32(a, b)
+#define vi_sub(a, b) _mm_sub_epi32(a, b)
+#define vi_and(a, b) _mm_and_si128(a, b)
+#define vi_or(a, b) _mm_or_si128(a, b)
+#define vi_xor(a, b) _mm_xor_si128(a, b)
+#define vi_sll(a, n) _mm_slli_epi32(a, n)
+#define vi_srl(a, n) _mm_srli_epi32(a, n)
+#define vi_to_vf(a) _mm_cvtepi32_ps(a)
+#define vi_as_vf(a) _mm_castsi128_ps(a)
+#define vi_lane0(a) _mm_cvtsi128_si32(a)
+#define vi_all_eq(a, b) (_mm_movemask_epi8(_mm_cmpeq_epi32(a, b)) == 0xFFFF)
+
+// SSE2 has no round instruction: truncate, then step down where that rounded up
+static inline vf vf_floor(vf x) {
+    vf t = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+    return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, x), _mm_set1_ps(1.0f)));
+}
+
+#include "noise_simd_kernel.h"
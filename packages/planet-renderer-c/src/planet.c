@@ -1,236 +1,877 @@
 #include "planet.h"
+#include "planet_internal.h"
+#include "noise.h"
+#include "planet_trace.h"
 #include "rlgl.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
-// No longer needed as we don't use the callback for freeing anymore
-static void OnNodeSplit(QuadtreeNode* node) {
-    // Empty for now, logic moved to Update
+// Worker function for async chunk generation. The finished mesh is posted
+// to chunk->uploadQueue; results for a retired chunk are dropped.
+static void GenerateChunkWorker(void* data) {
+    Chunk_GenerateAsync((Chunk*)data);
 }
 
-// Worker function for async chunk generation
-static void GenerateChunkWorker(void* data) {
-    Chunk* chunk = (Chunk*)data;
-    Chunk_GenerateAsync(chunk);
+// Generation priority: distance over size approximates inverse screen-space
+// size, so big nearby chunks run first. Lower value = more urgent. Chunks
+// hidden behind a fallback mesh yield to ones that would leave a hole, and
+// speculative ones for a predicted leaf yield to everything visible.
+static float ChunkGenerationPriority(const Planet* planet, const Chunk* chunk) {
+    float priority = Vector3Distance(chunk->center, planet->cameraPosition) / chunk->width;
+    if (chunk->hasFallback) priority *= planet->fallbackPriorityScale;
+    if (chunk->isPrefetch) priority *= planet->prefetchPriorityScale;
+    return priority;
 }
 
-Planet* Planet_Create(float radius, float minCellSize, int minCellResolution, Vector3 origin, float terrainFrequency, float terrainAmplitude) {
+// Jobs of several planets can share a pool, so each is scored by its own
+static float ReprioritizeChunkJob(void* data, void* context) {
+    (void)context;
+    const Chunk* chunk = data;
+    return ChunkGenerationPriority((const Planet*)chunk->owner, chunk);
+}
+
+void PlanetInternal_ReprioritizeJobs(ThreadPool* threadPool) {
+    ThreadPool_Reprioritize(threadPool, ReprioritizeChunkJob, NULL);
+}
+
+// --- Parent/child fallback ---
+// A split keeps the parent chunk, a merge keeps the children's, and they are
+// drawn in place of the new tiles until those have all uploaded. Retired
+// chunks are filed under the ID of the node that covers them.
+
+static bool IsChunkDrawable(Chunk* chunk) {
+    return chunk && Chunk_GetState(chunk) == CHUNK_STATE_UPLOADED;
+}
+
+// Every leaf below node has its own mesh on the GPU
+static bool IsSubtreeUploaded(Quadtree* face, QuadtreeNode* node) {
+    if (node->isLeaf) return IsChunkDrawable((Chunk*)node->userData);
+    QuadtreeNode* children = Quadtree_GetChildren(face, node);
+    for (int i = 0; i < 4; i++) {
+        if (!IsSubtreeUploaded(face, &children[i])) return false;
+    }
+    return true;
+}
+
+static void ReleaseFallbackList(Planet* planet, Chunk* chunk) {
+    while (chunk) {
+        Chunk* next = chunk->nextFallback;
+        chunk->nextFallback = NULL;
+        ChunkPool_Release(planet->chunkPool, chunk);
+        chunk = next;
+    }
+}
+
+// Append a list of retired chunks to the node's fallback list
+static void AddFallbacks(Planet* planet, ChunkId nodeId, Chunk* list) {
+    Chunk* head = ChunkMap_Get(planet->fallbackMap, nodeId);
+    if (head) {
+        Chunk* tail = head;
+        while (tail->nextFallback) tail = tail->nextFallback;
+        tail->nextFallback = list;
+    } else {
+        ChunkMap_Insert(planet->fallbackMap, nodeId, list);
+    }
+}
+
+// True if the tile or one of its ancestors is drawn from a fallback
+static bool HasFallbackCover(const Planet* planet, ChunkId id) {
+    if (planet->fallbackMap->count == 0) return false;
+    for (ChunkId current = id; current != CHUNK_ID_INVALID; current = ChunkId_GetParent(current)) {
+        if (ChunkMap_Get(planet->fallbackMap, current)) return true;
+    }
+    return false;
+}
+
+// Drop fallbacks whose node is fully uploaded, and move those whose node was
+// merged away to the leaf that now covers the area. Runs after this frame's
+// uploads, so a fallback and its replacement never draw on the same frame.
+static void UpdateFallbacks(Planet* planet) {
+    ChunkMap* map = planet->fallbackMap;
+
+    // Backwards: removing entry i only moves an already visited entry into i
+    for (int i = map->count - 1; i >= 0; i--) {
+        ChunkId holderId = map->entries[i].key;
+        Chunk* list = map->entries[i].value;
+        Quadtree* face = planet->quadtree->faces[ChunkId_GetFace(holderId)];
+        QuadtreeNode* node = Quadtree_FindNode(face, holderId);
+
+        // Checked first: the leaf may have taken back its own mesh this frame
+        if (IsSubtreeUploaded(face, node)) {
+            ChunkMap_Remove(map, holderId);
+            ReleaseFallbackList(planet, list);
+            planet->drawnVersion++;
+        } else if (node->id != holderId) {
+            ChunkMap_Remove(map, holderId);
+            AddFallbacks(planet, node->id, list);
+        }
+    }
+}
+
+// Merging back into a tile whose old mesh is still held as a fallback: take
+// that mesh again instead of generating it. Returns true if it was reused.
+static bool ReattachFallback(Planet* planet, QuadtreeNode* node) {
+    Chunk* list = ChunkMap_Get(planet->fallbackMap, node->id);
+    Chunk* previous = NULL;
+    for (Chunk* chunk = list; chunk; previous = chunk, chunk = chunk->nextFallback) {
+        if (chunk->id != node->id) continue;
+
+        if (previous) previous->nextFallback = chunk->nextFallback;
+        else list = chunk->nextFallback;
+        chunk->nextFallback = NULL;
+
+        // Everything else in the list was finer detail of this same tile
+        ChunkMap_Remove(planet->fallbackMap, node->id);
+        ReleaseFallbackList(planet, list);
+
+        chunk->hasFallback = false;
+        ChunkMap_Insert(planet->chunkMap, node->id, chunk);
+        node->userData = chunk;
+        return true;
+    }
+    return false;
+}
+
+// Take a chunk from the pool (or allocate one) and set it up for a node.
+// The pool only hands out chunks with no job in flight, so no worker can
+// see the fields written here.
+static Chunk* AcquireNodeChunk(Planet* planet, QuadtreeNode* node) {
+    Matrix localToWorld = planet->quadtree->faces[node->faceId]->localToWorld;
+
+    // Try to get from pool first
+    Chunk* chunk = ChunkPool_Acquire(planet->chunkPool, planet->minCellResolution);
+    
+    if (!chunk) {
+        // Allocate new if pool empty
+        chunk = Chunk_Create(
+            node->bounds.min,
+            node->size.x,
+            node->size.y,
+            planet->radius,
+            planet->minCellResolution,
+            planet->origin,
+            localToWorld,
+            planet->terrainFrequency,
+            planet->terrainAmplitude
+        );
+    } else {
+        // Reset pooled chunk. Its GPU copy (VBO or atlas slot) shows the old
+        // tile, and a worker is about to rewrite the CPU mesh it came from:
+        // drop it, so the main thread never reads that mesh while it does
+        Chunk_ReleaseGPU(chunk);
+        chunk->offset = node->bounds.min;
+        chunk->width = node->size.x;
+        chunk->height = node->size.y;
+        chunk->radius = planet->radius;
+        chunk->resolution = planet->minCellResolution;
+        chunk->origin = planet->origin;
+        chunk->localToWorld = localToWorld;
+        chunk->terrainFrequency = planet->terrainFrequency;
+        chunk->terrainAmplitude = planet->terrainAmplitude;
+        // Mesh needs regeneration
+    }
+    chunk->id = node->id;
+    chunk->center = node->sphereCenter;
+    chunk->tileCache = planet->tileCache;
+    chunk->owner = planet;
+    bool instanced = planet->instancedRendering && ChunkBatch_SupportsResolution(chunk->resolution);
+    Chunk_SetHeightAtlas(chunk, instanced ? ChunkBatch_GetAtlas(planet->batch, chunk->resolution) : NULL,
+                         instanced && planet->batch->gpuTerrain);
+    return chunk;
+}
+
+static void QueueChunkGeneration(Planet* planet, Chunk* chunk) {
+    Chunk_QueueGeneration(chunk);
+    if (chunk->gpuTerrain) {
+        // Nothing to build on the CPU: straight to the upload queue, whose
+        // budget then paces the terrain draws
+        Chunk_GenerateAsync(chunk);
+        return;
+    }
+    ThreadPool_EnqueueWithPriority(planet->threadPool, GenerateChunkWorker, chunk,
+                                   ChunkGenerationPriority(planet, chunk));
+}
+
+// Return a chunk that is not drawn to the pool. Drop the job if it has not
+// started. A running one sees the chunk's new epoch and discards its
+// result; the pool holds the chunk back until it has finished.
+static void RetireChunk(Planet* planet, Chunk* chunk) {
+    if (ThreadPool_Cancel(planet->threadPool, chunk)) {
+        pthread_mutex_lock(&chunk->stateMutex);
+        chunk->state = CHUNK_STATE_UNINITIALIZED;
+        pthread_mutex_unlock(&chunk->stateMutex);
+    }
+    ChunkPool_Release(planet->chunkPool, chunk);
+}
+
+// --- LOD ---
+
+// Split distances of a tree from the LOD settings and the budget scale
+static void ApplyLodSettings(const Planet* planet, CubicQuadTree* tree) {
+    float errorDistanceScale = 0.0f;
+    if (planet->lodPixelError > 0.0f) {
+        // An error e spans about e * pixelsPerRadian / d pixels at distance d
+        float pixelsPerRadian = planet->lodScreenHeight / (2.0f * tanf(planet->lodFovy * DEG2RAD * 0.5f));
+        errorDistanceScale = pixelsPerRadian * planet->lodDistanceScale / (planet->lodPixelError * planet->lodBudgetScale);
+    }
+    for (int i = 0; i < 6; i++) {
+        tree->faces[i]->comparatorValue = planet->lodComparator * planet->lodDistanceScale / planet->lodBudgetScale;
+        tree->faces[i]->errorDistanceScale = errorDistanceScale;
+    }
+}
+
+// Leaf count grows about with the square of the split distances, so the
+// scale follows the square root of the overshoot, at most 10% per update.
+// Under 90% of the budget it relaxes back toward 1.
+static void UpdateLodBudget(Planet* planet) {
+    if (planet->lodTriangleBudget <= 0) {
+        planet->lodBudgetScale = 1.0f;
+        return;
+    }
+    float triangles = (float)planet->chunkMap->count * Chunk_GetTriangleCount(planet->minCellResolution);
+    float ratio = triangles / planet->lodTriangleBudget;
+    if (ratio > 1.0f) {
+        planet->lodBudgetScale *= fminf(sqrtf(ratio), 1.1f);
+    } else if (ratio < 0.9f && planet->lodBudgetScale > 1.0f) {
+        planet->lodBudgetScale = fmaxf(planet->lodBudgetScale * fmaxf(sqrtf(ratio / 0.9f), 1.0f / 1.1f), 1.0f);
+    }
+}
+
+// Uploaded meshes change what is drawn, and feed their parent error to the
+// trees (Quadtree_ReportMeshError)
+static void OnChunkUploaded(Chunk* chunk, void* context) {
+    Planet* planet = context;
+    planet->drawnVersion++;
+    if (chunk->parentError < 0.0f) return;
+    CubicQuadTree_ReportMeshError(planet->quadtree, chunk->id, chunk->parentError);
+    if (planet->prefetchTree) CubicQuadTree_ReportMeshError(planet->prefetchTree, chunk->id, chunk->parentError);
+}
+
+// --- Prefetch ---
+// Planet_UpdateWithVelocity keeps a second cubic quadtree at the camera's
+// predicted position. Its new leaves that the live tree lacks are generated
+// ahead of time, at lower priority and without an upload queue, and parked
+// in prefetchMap until the live tree reaches them. When the prediction
+// changes and a predicted leaf goes away, its chunk is cancelled.
+
+// A new leaf the prediction already generated (or is generating): hand the
+// chunk over to the live tree. Returns true if there was one.
+static bool ClaimPrefetchedChunk(Planet* planet, QuadtreeNode* node) {
+    Chunk* chunk = ChunkMap_Remove(planet->prefetchMap, node->id);
+    if (!chunk) return false;
+
+    chunk->isPrefetch = false;
+    chunk->hasFallback = HasFallbackCover(planet, node->id);
+
+    // A running job reads uploadQueue under the same lock when it finishes,
+    // so exactly one side posts the mesh
+    pthread_mutex_lock(&chunk->stateMutex);
+    chunk->uploadQueue = planet->uploadQueue;
+    ChunkState state = chunk->state;
+    if (state == CHUNK_STATE_READY_TO_UPLOAD) ChunkUploadQueue_Push(planet->uploadQueue, chunk, chunk->epoch);
+    pthread_mutex_unlock(&chunk->stateMutex);
+    if (state == CHUNK_STATE_UNINITIALIZED) QueueChunkGeneration(planet, chunk);
+
+    ChunkMap_Insert(planet->chunkMap, node->id, chunk);
+    node->userData = chunk;
+    return true;
+}
+
+// Drops all speculation; the next update with a velocity starts over
+static void DisablePrefetch(Planet* planet) {
+    for (int i = 0; i < planet->prefetchMap->count; i++) {
+        RetireChunk(planet, planet->prefetchMap->entries[i].value);
+    }
+    ChunkMap_Clear(planet->prefetchMap);
+    CubicQuadTree_Free(planet->prefetchTree);
+    planet->prefetchTree = NULL;
+}
+
+static void UpdatePrefetch(Planet* planet, Vector3 predictedPosition) {
+    if (!planet->prefetchTree) {
+        Quadtree* face = planet->quadtree->faces[0];
+        planet->prefetchTree = CubicQuadTree_Create(planet->radius, planet->minCellSize, face->comparatorValue,
+                                                    planet->maxDisplacement, planet->origin);
+    }
+
+    QuadtreeLeafChanges* changes = &planet->prefetchChanges;
+    QuadtreeLeafChanges_Clear(changes);
+    ApplyLodSettings(planet, planet->prefetchTree);
+    CubicQuadTree_Update(planet->prefetchTree, predictedPosition, changes);
+
+    // The prediction no longer needs these
+    for (int i = 0; i < changes->removedCount; i++) {
+        Chunk* chunk = ChunkMap_Remove(planet->prefetchMap, changes->removed[i].id);
+        if (chunk) RetireChunk(planet, chunk);
+    }
+
+    // Up to the cap, generate what the live tree does not have yet; leaves
+    // past it are skipped until the prediction adds them again
+    for (int i = 0; i < changes->addedCount && planet->prefetchMap->count < planet->prefetchMaxChunks; i++) {
+        QuadtreeNode* node = changes->added[i];
+        if (ChunkMap_Get(planet->chunkMap, node->id) || ChunkMap_Get(planet->prefetchMap, node->id)) continue;
+
+        Chunk* chunk = AcquireNodeChunk(planet, node);
+        chunk->uploadQueue = NULL; // Held back until claimed
+        chunk->isPrefetch = true;
+        chunk->hasFallback = false;
+        QueueChunkGeneration(planet, chunk);
+        ChunkMap_Insert(planet->prefetchMap, node->id, chunk);
+    }
+}
+
+// Create (or recycle) a chunk for a new leaf and queue its generation
+static void AttachChunk(Planet* planet, QuadtreeNode* node) {
+    if (planet->fallbackMap->count > 0 && ReattachFallback(planet, node)) return;
+    if (planet->prefetchMap->count > 0 && ClaimPrefetchedChunk(planet, node)) return;
+
+    Chunk* chunk = AcquireNodeChunk(planet, node);
+    chunk->uploadQueue = planet->uploadQueue;
+    chunk->isPrefetch = false;
+    chunk->hasFallback = HasFallbackCover(planet, node->id);
+    QueueChunkGeneration(planet, chunk);
+
+    ChunkMap_Insert(planet->chunkMap, node->id, chunk);
+    node->userData = chunk;
+}
+
+// --- Instrumentation (PLANET_ENABLE_STATS, see planet_stats.h) ---
+// Each update opens a frame record in the ring; its phases close into the
+// frame's timers, and the draws that follow append their passes.
+
+#ifdef PLANET_ENABLE_STATS
+
+static PlanetFrameStats* GetStatsFrame(Planet* planet) {
+    return &planet->stats->frames[planet->stats->newest];
+}
+
+static void BeginStatsFrame(Planet* planet) {
+    PlanetStats* stats = planet->stats;
+    stats->newest = (stats->newest + 1) % PLANET_STATS_HISTORY;
+    if (stats->count < PLANET_STATS_HISTORY) stats->count++;
+
+    PlanetFrameStats* frame = GetStatsFrame(planet);
+    memset(frame, 0, sizeof(*frame));
+    frame->frame = ++stats->frameCount;
+    frame->time = PlanetStats_Now();
+    stats->phaseStart = frame->time;
+    stats->idleSeconds = 0.0;
+}
+
+// Closes the current phase of the update into one of the frame's timers
+static void EndStatsPhase(Planet* planet, float* ms, const char* name) {
+    double now = PlanetStats_Now();
+    PlanetTrace_AddSpan(name, planet->stats->phaseStart, now);
+    *ms = (float)((now - planet->stats->phaseStart) * 1000.0);
+    planet->stats->phaseStart = now;
+}
+
+static void EndStatsFrame(Planet* planet) {
+    PlanetStats* stats = planet->stats;
+    PlanetFrameStats* frame = GetStatsFrame(planet);
+    double now = PlanetStats_Now();
+    PlanetTrace_AddSpan("Planet_Update", frame->time, now);
+    frame->updateMs = (float)((now - frame->time - stats->idleSeconds) * 1000.0);
+    frame->leafCount = planet->chunkMap->count;
+
+    ChunkPool* pool = planet->chunkPool;
+    frame->chunksCreated = (int)(pool->misses - stats->poolMisses);
+    frame->chunksReused = (int)(pool->hits - stats->poolHits);
+    frame->chunksPooled = (int)(pool->releases - stats->poolReleases);
+    stats->poolMisses = pool->misses;
+    stats->poolHits = pool->hits;
+    stats->poolReleases = pool->releases;
+
+    ChunkUploadQueue* queue = planet->uploadQueue;
+    frame->queueDepth = ThreadPool_GetQueueSize(planet->threadPool);
+    frame->chunksReady = queue->statsReady;
+    frame->waitMsAvg = queue->statsReady > 0 ? (float)(queue->statsWaitSeconds / queue->statsReady * 1000.0) : 0.0f;
+    frame->waitMsMax = (float)(queue->statsWaitMaxSeconds * 1000.0);
+    frame->uploads = queue->statsUploads;
+    frame->uploadBytes = queue->statsUploadBytes;
+    frame->uploadsPending = ChunkUploadQueue_GetPendingCount(queue);
+    queue->statsReady = 0;
+    queue->statsWaitSeconds = 0.0;
+    queue->statsWaitMaxSeconds = 0.0;
+    queue->statsUploads = 0;
+    queue->statsUploadBytes = 0;
+
+    double busySeconds[PLANET_STATS_MAX_WORKERS];
+    frame->workerCount = ThreadPool_GetBusySeconds(planet->threadPool, busySeconds, PLANET_STATS_MAX_WORKERS);
+    for (int i = 0; i < frame->workerCount; i++) {
+        frame->workerBusyMs[i] = (float)((busySeconds[i] - stats->workerBusySeconds[i]) * 1000.0);
+        stats->workerBusySeconds[i] = busySeconds[i];
+    }
+
+    PlanetMemoryStats memory = Planet_GetMemoryStats(planet);
+    frame->cpuBytes = memory.cpuBytes;
+    frame->gpuBytes = memory.gpuBytes;
+}
+
+#endif
+
+Planet* PlanetInternal_Create(float radius, float minCellSize, int minCellResolution, Vector3 origin,
+                              float terrainFrequency, float terrainAmplitude, ThreadPool* sharedThreadPool) {
     Planet* planet = (Planet*)malloc(sizeof(Planet));
+    planet->stats = NULL;
+    PLANET_STATS_ONLY(planet->stats = (PlanetStats*)calloc(1, sizeof(PlanetStats)));
+    PLANET_TRACE_THREAD_NAME("Main", -1); // The thread that drives the planet
     planet->radius = radius;
     planet->minCellSize = minCellSize;
-    planet->minCellResolution = minCellResolution;
+    planet->minCellResolution = minCellResolution < CHUNK_MAX_RESOLUTION ? minCellResolution : CHUNK_MAX_RESOLUTION;
     planet->origin = origin;
     planet->terrainFrequency = terrainFrequency;
     planet->terrainAmplitude = terrainAmplitude;
-
-    // Comparator value from TS default: 1.1 or similar.
-    float comparatorValue = 1.5f;
-
-    // Initialize Quadtree (will be recreated every frame)
-    planet->quadtree = CubicQuadTree_Create(radius, minCellSize, comparatorValue, origin);
+    planet->maxDisplacement = radius * terrainAmplitude * MOON_TERRAIN_MAX_ABS;
+    planet->frustumCulling = true;
+    planet->horizonCulling = true;
+    planet->cameraPosition = origin;
+    planet->uploadBudgetMs = 2.0f;
+    planet->uploadBudgetBytes = 0;
+    planet->fallbackPriorityScale = 4.0f;
+    planet->prefetchSeconds = 1.0f;
+    planet->prefetchMaxChunks = 256;
+    planet->prefetchPriorityScale = 8.0f;
+    planet->prefetchTree = NULL; // Created by the first update with a velocity
+
+    planet->lodPixelError = PLANET_DEFAULT_LOD_PIXEL_ERROR;
+    planet->lodFovy = PLANET_DEFAULT_LOD_FOVY;
+    planet->lodScreenHeight = PLANET_DEFAULT_LOD_SCREEN_HEIGHT;
+    planet->lodComparator = PLANET_DEFAULT_LOD_COMPARATOR;
+    planet->lodTriangleBudget = 0;
+    planet->lodBudgetScale = 1.0f;
+    planet->lodDistanceScale = 1.0f;
+    planet->lodMorphRange = PLANET_DEFAULT_LOD_MORPH_RANGE;
+    planet->drawnVersion = 0;
+
+    // Initialize Quadtree (persistent, updated in place every frame)
+    planet->quadtree = CubicQuadTree_Create(radius, minCellSize, planet->lodComparator, planet->maxDisplacement, origin);
+    QuadtreeLeafChanges_Init(&planet->leafChanges);
+    QuadtreeLeafChanges_Init(&planet->prefetchChanges);
 
     // Initialize Chunk Map and Pool
     planet->chunkMap = ChunkMap_Create(1024); // Initial capacity
-    planet->chunkPool = ChunkPool_Create(256); // Initial capacity
-
-    // Initialize Thread Pool (4 worker threads, similar to TypeScript implementation)
-    planet->threadPool = ThreadPool_Create(4);
+    planet->fallbackMap = ChunkMap_Create(64);
+    planet->prefetchMap = ChunkMap_Create(64);
+    planet->poolCpuBudgetBytes = PLANET_DEFAULT_POOL_CPU_BYTES;
+    planet->poolGpuBudgetBytes = PLANET_DEFAULT_POOL_GPU_BYTES;
+    planet->chunkPool = ChunkPool_Create(planet->poolCpuBudgetBytes, planet->poolGpuBudgetBytes);
+
+    // Initialize Thread Pool (one worker per spare hardware thread)
+    planet->sharedThreadPool = sharedThreadPool != NULL;
+    planet->threadPool = sharedThreadPool ? sharedThreadPool : ThreadPool_Create(0);
+    planet->uploadQueue = ChunkUploadQueue_Create(256);
+    planet->uploadQueue->onUpload = OnChunkUploaded;
+    planet->uploadQueue->onUploadContext = planet;
+    planet->chunkPool->uploadQueue = planet->uploadQueue;
+    planet->tileCache = TileCache_Create(TileCache_HashParams(radius, terrainFrequency, terrainAmplitude),
+                                         PLANET_DEFAULT_TILE_CACHE_BYTES);
+    planet->instancedRendering = false;
+    planet->batch = ChunkBatch_Create(radius, origin);
 
     planet->surfaceColor = WHITE;
     planet->wireframeColor = BLACK;
 
+    // Seed chunks for the initial leaves (the six face roots).
+    // Every later leaf arrives through the diff in Planet_Update.
+    QuadtreeNode** leafNodes;
+    int leafCount;
+    CubicQuadTree_GetLeafNodes(planet->quadtree, &leafNodes, &leafCount);
+    for (int i = 0; i < leafCount; i++) {
+        AttachChunk(planet, leafNodes[i]);
+    }
+    free(leafNodes);
+
     return planet;
 }
 
+Planet* Planet_Create(float radius, float minCellSize, int minCellResolution, Vector3 origin, float terrainFrequency, float terrainAmplitude) {
+    return PlanetInternal_Create(radius, minCellSize, minCellResolution, origin, terrainFrequency, terrainAmplitude, NULL);
+}
+
+bool Planet_OpenTileStore(Planet* planet, const char* path, int maxTiles) {
+    return TileCache_OpenStore(planet->tileCache, path, planet->minCellResolution,
+                               Chunk_GetHeightSampleCount(planet->minCellResolution), maxTiles);
+}
+
+bool Planet_SetTerrainShader(Planet* planet, Shader shader) {
+    return ChunkBatch_SetTerrainShader(planet->batch, shader);
+}
+
+const PlanetStats* Planet_GetStats(const Planet* planet) {
+    return planet->stats;
+}
+
+void Planet_SetLodCellPixels(Planet* planet, float pixels, float fovy, int screenHeight) {
+    // A leaf of size S splits at distance comparator * S, where one of its
+    // cells (S / resolution) spans about pixelsPerRadian / (comparator * resolution)
+    float pixelsPerRadian = screenHeight / (2.0f * tanf(fovy * DEG2RAD * 0.5f));
+    planet->lodComparator = pixelsPerRadian / (planet->minCellResolution * fmaxf(pixels, 1e-3f));
+    planet->lodFovy = fovy;
+    planet->lodScreenHeight = screenHeight;
+}
+
 void Planet_Update(Planet* planet, Vector3 cameraPosition) {
-    // 1. Create NEW Quadtree
-    CubicQuadTree* newQuadtree = CubicQuadTree_Create(
-        planet->radius, 
-        planet->minCellSize, 
-        1.5f, // comparator
-        planet->origin
-    );
-    
-    // 2. Insert Camera to build tree
-    CubicQuadTree_Insert(newQuadtree, cameraPosition, OnNodeSplit);
-    
-    // 3. Get new leaf nodes
-    QuadtreeNode** leafNodes;
-    int leafCount;
-    CubicQuadTree_GetLeafNodes(newQuadtree, &leafNodes, &leafCount);
-    
-    // 4. Diffing & Allocation
-    ChunkMap* newChunkMap = ChunkMap_Create(planet->chunkMap->capacity);
-    
-    for (int i = 0; i < leafCount; i++) {
-        QuadtreeNode* node = leafNodes[i];
-        unsigned long long id = node->id;
-        
-        // Check if we already have this chunk
-        Chunk* existingChunk = ChunkMap_Remove(planet->chunkMap, id);
-        
-        if (existingChunk) {
-            // REUSE: Move to new map
-            ChunkMap_Insert(newChunkMap, id, existingChunk);
-            node->userData = existingChunk;
-        } else {
-            // CREATE: Try to get from pool first
-            Chunk* chunk = ChunkPool_Acquire(planet->chunkPool);
-            
-            if (!chunk) {
-                // Allocate new if pool empty
-                chunk = Chunk_Create(
-                    node->bounds.min,
-                    node->size.x,
-                    node->size.y,
-                    planet->radius,
-                    planet->minCellResolution,
-                    planet->origin,
-                    node->localToWorld,
-                    planet->terrainFrequency,
-                    planet->terrainAmplitude
-                );
-                chunk->id = id;
-            } else {
-                // Reset pooled chunk
-                chunk->offset = node->bounds.min;
-                chunk->width = node->size.x;
-                chunk->height = node->size.y;
-                chunk->radius = planet->radius;
-                chunk->resolution = planet->minCellResolution;
-                chunk->origin = planet->origin;
-                chunk->localToWorld = node->localToWorld;
-                chunk->terrainFrequency = planet->terrainFrequency;
-                chunk->terrainAmplitude = planet->terrainAmplitude;
-                chunk->id = id;
-                // Mesh needs regeneration
-            }
-            
-            // Queue async generation for new chunk
-            pthread_mutex_lock(&chunk->stateMutex);
-            chunk->state = CHUNK_STATE_PENDING;
-            pthread_mutex_unlock(&chunk->stateMutex);
+    Planet_UpdateWithVelocity(planet, cameraPosition, (Vector3){ 0 });
+}
 
-            ThreadPool_Enqueue(planet->threadPool, GenerateChunkWorker, chunk);
+void Planet_UpdateWithVelocity(Planet* planet, Vector3 cameraPosition, Vector3 cameraVelocity) {
+    PlanetInternal_BeginUpdate(planet, cameraPosition, cameraVelocity);
+    PlanetInternal_EndUpdate(planet, planet->uploadBudgetMs, planet->uploadBudgetBytes);
+}
 
-            ChunkMap_Insert(newChunkMap, id, chunk);
-            node->userData = chunk;
+void PlanetInternal_BeginUpdate(Planet* planet, Vector3 cameraPosition, Vector3 cameraVelocity) {
+    planet->cameraPosition = cameraPosition;
+    PLANET_STATS_ONLY(BeginStatsFrame(planet));
+
+    // 1. Split/merge the persistent quadtree in place
+    QuadtreeLeafChanges* changes = &planet->leafChanges;
+    QuadtreeLeafChanges_Clear(changes);
+    UpdateLodBudget(planet);
+    ApplyLodSettings(planet, planet->quadtree);
+    CubicQuadTree_Update(planet->quadtree, cameraPosition, changes);
+    PLANET_STATS_ONLY(EndStatsPhase(planet, &GetStatsFrame(planet)->quadtreeMs, "Quadtree"));
+    PLANET_STATS_ONLY(GetStatsFrame(planet)->leavesAdded = changes->addedCount);
+    PLANET_STATS_ONLY(GetStatsFrame(planet)->leavesRemoved = changes->removedCount);
+    if (changes->addedCount > 0 || changes->removedCount > 0) planet->drawnVersion++;
+
+    // 2. Retire chunks of leaves that left the tree (split or merged away).
+    // An uploaded one keeps covering its area from the node that now holds
+    // it (the split parent, or the merged ancestor) until the new leaves there
+    // are on the GPU. The rest go back to the pool.
+    for (int i = 0; i < changes->removedCount; i++) {
+        ChunkId removedId = changes->removed[i].id;
+        Chunk* unusedChunk = ChunkMap_Remove(planet->chunkMap, removedId);
+        if (!unusedChunk) continue;
+
+        if (IsChunkDrawable(unusedChunk)) {
+            Quadtree* face = planet->quadtree->faces[ChunkId_GetFace(removedId)];
+            ChunkId holderId = Quadtree_FindNode(face, removedId)->id;
+
+            // A fallback already filed there is coarser or older: this mesh replaces it
+            Chunk* stale = ChunkMap_Get(planet->fallbackMap, holderId);
+            if (stale && holderId == removedId) {
+                ChunkMap_Remove(planet->fallbackMap, holderId);
+                ReleaseFallbackList(planet, stale);
+            }
+            AddFallbacks(planet, holderId, unusedChunk);
+            continue;
         }
+
+        RetireChunk(planet, unusedChunk);
+    }
+
+    // 3. Create chunks for leaves that entered the tree. Retiring first lets
+    // a merge take back a parent mesh that is still held as a fallback.
+    // Chunks whose jobs have finished since they were retired can be reused.
+    planet->chunkPool->cpuBudget = planet->poolCpuBudgetBytes;
+    planet->chunkPool->gpuBudget = planet->poolGpuBudgetBytes;
+    ChunkPool_Trim(planet->chunkPool);
+    ChunkPool_Reclaim(planet->chunkPool);
+    for (int i = 0; i < changes->addedCount; i++) {
+        AttachChunk(planet, changes->added[i]);
+    }
+    PLANET_STATS_ONLY(EndStatsPhase(planet, &GetStatsFrame(planet)->attachMs, "Attach chunks"));
+
+    // Speculative chunks for where the camera is heading. Once the
+    // prediction tree exists it keeps tracking (a stopped camera predicts
+    // its own position), so stale speculation gets cancelled.
+    if (planet->prefetchSeconds <= 0.0f || planet->prefetchMaxChunks <= 0) {
+        if (planet->prefetchTree) DisablePrefetch(planet);
+    } else if (planet->prefetchTree || Vector3LengthSqr(cameraVelocity) > 0.0f) {
+        UpdatePrefetch(planet, Vector3Add(cameraPosition, Vector3Scale(cameraVelocity, planet->prefetchSeconds)));
+    }
+
+    // Camera moved: pending jobs closest to it (relative to their size) go
+    // first. A shared pool is rescored once for all its planets.
+    if (!planet->sharedThreadPool) PlanetInternal_ReprioritizeJobs(planet->threadPool);
+    PLANET_STATS_ONLY(EndStatsPhase(planet, &GetStatsFrame(planet)->scheduleMs, "Schedule"));
+}
+
+void PlanetInternal_EndUpdate(Planet* planet, double uploadBudgetMs, int uploadBudgetBytes) {
+#ifdef PLANET_ENABLE_STATS
+    // Other planets of the system updated in between
+    double resumed = PlanetStats_Now();
+    planet->stats->idleSeconds += resumed - planet->stats->phaseStart;
+    planet->stats->phaseStart = resumed;
+#endif
+
+    // 4. Upload finished chunks (must be done on main thread), nearest first,
+    // stopping once the per-frame budget is spent
+    ChunkUploadQueue_Process(planet->uploadQueue, planet->cameraPosition, uploadBudgetMs, uploadBudgetBytes);
+    PLANET_STATS_ONLY(EndStatsPhase(planet, &GetStatsFrame(planet)->uploadMs, "Upload"));
+
+    // 5. Swap out fallbacks whose replacements are now all uploaded
+    UpdateFallbacks(planet);
+    PLANET_STATS_ONLY(EndStatsFrame(planet));
+}
+
+typedef struct DrawCullParams {
+    Frustum frustum;
+    bool useFrustum;
+    bool useHorizon;
+    Vector3 cameraPosition;
+    const Shader* shader; // NULL = lit pass with wireframe, otherwise depth-only pass
+    int drawCalls;        // Counted during the pass
+    int chunks;
+} DrawCullParams;
+
+// Camera position from a rigid view matrix: eye = -R^T * t
+static Vector3 GetViewPosition(Matrix view) {
+    return (Vector3){
+        -(view.m0 * view.m12 + view.m1 * view.m13 + view.m2 * view.m14),
+        -(view.m4 * view.m12 + view.m5 * view.m13 + view.m6 * view.m14),
+        -(view.m8 * view.m12 + view.m9 * view.m13 + view.m10 * view.m14)
+    };
+}
+
+static int DrawChunk(Planet* planet, Chunk* chunk, DrawCullParams* cull) {
+    if (chunk->heightAtlas) {
+        // Drawn together at the end of the pass
+        if (chunk->isUploaded) ChunkBatch_Add(planet->batch, chunk);
+    } else if (cull->shader) {
+        // Don't draw wireframe in shadow pass, use BLACK for color (doesn't matter for depth)
+        cull->drawCalls += Chunk_Draw(chunk, BLACK, BLACK, *cull->shader);
+    } else {
+        cull->drawCalls += Chunk_DrawWithShadow(chunk, planet->surfaceColor, planet->wireframeColor, planet->lightingShader, planet->shadowMapTexture);
+    }
+    cull->chunks++;
+
+    return chunk->triangleCount;
+}
+
+// Hierarchical traversal: a subtree is rejected as soon as its node bounds
+// fail a test, and frustum tests stop once a node is fully inside
+static int DrawNodeRecursive(Planet* planet, Quadtree* face, QuadtreeNode* node, DrawCullParams* cull, bool insideFrustum) {
+    if (cull->useHorizon &&
+        IsSphereBelowHorizon(cull->cameraPosition, planet->origin,
+                             planet->radius - planet->maxDisplacement,
+                             planet->radius + planet->maxDisplacement,
+                             node->sphereCenter, node->boundingRadius)) {
+        return 0;
     }
 
-    // 4.5. Process chunks ready for upload (must be done on main thread)
-    // Iterate through all chunks in the new map and upload any that are ready
-    for (int i = 0; i < newChunkMap->capacity; i++) {
-        ChunkMapEntry* entry = newChunkMap->buckets[i];
-        while (entry) {
-            Chunk* chunk = entry->value;
-            if (Chunk_GetState(chunk) == CHUNK_STATE_READY_TO_UPLOAD) {
-                Chunk_UploadToGPU(chunk);
+    if (cull->useFrustum && !insideFrustum) {
+        FrustumTestResult result = FrustumTestSphere(&cull->frustum, node->sphereCenter, node->boundingRadius);
+        if (result == FRUSTUM_OUTSIDE) return 0;
+        insideFrustum = (result == FRUSTUM_INSIDE);
+    }
+
+    // Retired meshes stand in for this tile until its replacement is ready.
+    // Seams and morph follow the tree as it is now, as for a leaf: the
+    // neighbors may have changed level, and finer meshes (from a merge)
+    // morph toward this tile, at its split distance.
+    if (planet->fallbackMap->count > 0) {
+        Chunk* fallback = ChunkMap_Get(planet->fallbackMap, node->id);
+        if (fallback) {
+            float splitDistance = Quadtree_GetSplitDistance(face, node);
+            int triangles = 0;
+            for (; fallback; fallback = fallback->nextFallback) {
+                fallback->seamMask = CubicQuadTree_GetCoarserEdges(planet->quadtree, fallback->id);
+                fallback->lodMorphEnd = fallback->id == node->id ? node->parentSplitDistance : splitDistance;
+                triangles += DrawChunk(planet, fallback, cull);
             }
-            entry = entry->next;
+            return triangles;
         }
     }
 
-    // 5. Recycle remaining chunks in old map
-    // Anything left in planet->chunkMap is no longer visible
-    for (int i = 0; i < planet->chunkMap->capacity; i++) {
-        ChunkMapEntry* entry = planet->chunkMap->buckets[i];
-        while (entry) {
-            Chunk* unusedChunk = entry->value;
-            ChunkPool_Release(planet->chunkPool, unusedChunk);
-            entry = entry->next;
+    if (!node->isLeaf) {
+        QuadtreeNode* children = Quadtree_GetChildren(face, node);
+        int triangles = 0;
+        for (int i = 0; i < 4; i++) {
+            triangles += DrawNodeRecursive(planet, face, &children[i], cull, insideFrustum);
         }
+        return triangles;
     }
-    
-    // 6. Cleanup
-    ChunkMap_Destroy(planet->chunkMap); // Destroys map structure, chunks are now in pool or newMap
-    planet->chunkMap = newChunkMap;
-    
-    CubicQuadTree_Free(planet->quadtree);
-    planet->quadtree = newQuadtree;
-    
-    free(leafNodes);
-}
 
-int Planet_Draw(Planet* planet) {
-    // Draw all chunks in the active map
-    // We could traverse the quadtree, but iterating the map is faster/easier if we just want to draw all
-    // However, traversing quadtree allows for frustum culling later.
-    // Let's stick to quadtree traversal for drawing to match original logic
+    // A recycled chunk still holds its previous tile's mesh until it uploads
+    Chunk* chunk = (Chunk*)node->userData;
+    if (!IsChunkDrawable(chunk)) return 0;
+    chunk->seamMask = node->coarserEdges; // Neighbors may have changed level since it was built
+    chunk->lodMorphEnd = node->parentSplitDistance;
+    return DrawChunk(planet, chunk, cull);
+}
 
-    QuadtreeNode** leafNodes;
-    int leafCount;
-    CubicQuadTree_GetLeafNodes(planet->quadtree, &leafNodes, &leafCount);
+#ifdef PLANET_ENABLE_STATS
+// Appends a finished draw pass to the current frame
+static void RecordStatsPass(Planet* planet, const DrawCullParams* cull, int triangles, double start) {
+    double now = PlanetStats_Now();
+    bool depth = cull->shader != NULL;
+    PlanetTrace_AddSpan(depth ? "Draw depth pass" : "Draw lit pass", start, now);
+
+    PlanetFrameStats* frame = GetStatsFrame(planet);
+    if (planet->stats->count == 0 || frame->passCount >= PLANET_STATS_MAX_PASSES) return;
+    PlanetPassStats* pass = &frame->passes[frame->passCount++];
+    pass->kind = depth ? PLANET_PASS_DEPTH : PLANET_PASS_LIT;
+    pass->drawCalls = cull->drawCalls;
+    pass->triangles = triangles;
+    pass->chunks = cull->chunks;
+    pass->cpuMs = (float)((now - start) * 1000.0);
+}
+#endif
+
+// A leaf is in the tree while the camera is between its own split distance
+// and its parent's from its patch, so every vertex is at least the former
+// away: about half the latter (0.5 for comparator LOD, about
+// QUADTREE_ERROR_REFINEMENT for screen-space error). The morph ends at the
+// parent's split distance (Chunk.lodMorphEnd, set per drawn mesh):
+// a leaf appears and merges away shaped like its parent.
+static void SetLodMorph(Planet* planet) {
+    float range = fminf(planet->lodMorphRange, 1.0f);
+    Chunk_SetLodMorph(planet->cameraPosition, range > 0.0f ? 1.0f - range * 0.5f : 1.0f);
+}
 
+static int DrawCulled(Planet* planet, DrawCullParams* cull) {
+    PLANET_STATS_ONLY(double start = PlanetStats_Now());
+    SetLodMorph(planet);
     int totalTriangles = 0;
-
-    for (int i = 0; i < leafCount; i++) {
-        QuadtreeNode* node = leafNodes[i];
-        if (node->userData) {
-            Chunk* chunk = (Chunk*)node->userData;
-            Chunk_DrawWithShadow(chunk, planet->surfaceColor, planet->wireframeColor, planet->lightingShader, planet->shadowMapTexture);
-
-            // Calculate triangles: resolution^2 * 2
-            totalTriangles += (chunk->resolution * chunk->resolution * 2);
-        }
+    for (int i = 0; i < 6; i++) {
+        Quadtree* face = planet->quadtree->faces[i];
+        totalTriangles += DrawNodeRecursive(planet, face, &face->root, cull, false);
     }
 
-    free(leafNodes);
+    planet->batch->radius = planet->radius;
+    planet->batch->origin = planet->origin;
+    if (cull->shader) {
+        cull->drawCalls += ChunkBatch_Flush(planet->batch, *cull->shader, BLACK, BLANK);
+    } else {
+        cull->drawCalls += ChunkBatch_Flush(planet->batch, planet->lightingShader, planet->surfaceColor, planet->wireframeColor);
+    }
+    PLANET_STATS_ONLY(RecordStatsPass(planet, cull, totalTriangles, start));
     return totalTriangles;
 }
 
+int Planet_Draw(Planet* planet) {
+    Matrix view = rlGetMatrixModelview();
+    Matrix projection = rlGetMatrixProjection();
+
+    DrawCullParams cull = { 0 };
+    cull.frustum = FrustumFromMatrix(MatrixMultiply(view, projection));
+    cull.useFrustum = planet->frustumCulling;
+    cull.useHorizon = planet->horizonCulling;
+    cull.cameraPosition = GetViewPosition(view);
+    cull.shader = NULL;
+
+    return DrawCulled(planet, &cull);
+}
+
 int Planet_DrawWithShader(Planet* planet, Shader shader) {
-    // Draw all chunks with a custom shader (useful for shadow pass)
-    QuadtreeNode** leafNodes;
-    int leafCount;
-    CubicQuadTree_GetLeafNodes(planet->quadtree, &leafNodes, &leafCount);
+    // Draw all chunks with a custom shader
+    DrawCullParams cull = { 0 };
+    cull.shader = &shader;
+    return DrawCulled(planet, &cull);
+}
 
-    int totalTriangles = 0;
+int Planet_DrawWithShaderCulled(Planet* planet, Shader shader, Matrix viewProjection) {
+    DrawCullParams cull = { 0 };
+    cull.frustum = FrustumFromMatrix(viewProjection);
+    cull.useFrustum = planet->frustumCulling;
+    cull.shader = &shader;
+    return DrawCulled(planet, &cull);
+}
 
-    for (int i = 0; i < leafCount; i++) {
-        QuadtreeNode* node = leafNodes[i];
-        if (node->userData) {
-            Chunk* chunk = (Chunk*)node->userData;
-            // Don't draw wireframe in shadow pass, use BLACK for color (doesn't matter for depth)
-            Chunk_Draw(chunk, BLACK, BLACK, shader);
-
-            // Calculate triangles: resolution^2 * 2
-            totalTriangles += (chunk->resolution * chunk->resolution * 2);
+static void AddChunkMemory(PlanetMemoryStats* stats, Chunk* chunk) {
+    stats->cpuBytes += Chunk_GetCPUBytes(chunk);
+    stats->gpuBytes += Chunk_GetGPUBytes(chunk);
+}
+
+PlanetMemoryStats Planet_GetMemoryStats(Planet* planet) {
+    PlanetMemoryStats stats = { 0 };
+    for (int i = 0; i < planet->chunkMap->count; i++) {
+        AddChunkMemory(&stats, planet->chunkMap->entries[i].value);
+        stats.liveChunks++;
+    }
+    for (int i = 0; i < planet->fallbackMap->count; i++) {
+        for (Chunk* chunk = planet->fallbackMap->entries[i].value; chunk; chunk = chunk->nextFallback) {
+            AddChunkMemory(&stats, chunk);
+            stats.liveChunks++;
         }
     }
+    for (int i = 0; i < planet->prefetchMap->count; i++) {
+        AddChunkMemory(&stats, planet->prefetchMap->entries[i].value);
+        stats.liveChunks++;
+    }
 
-    free(leafNodes);
-    return totalTriangles;
+    ChunkPool* pool = planet->chunkPool;
+    for (int i = 0; i < pool->deferredCount; i++) {
+        AddChunkMemory(&stats, pool->deferred[i]);
+    }
+    stats.pooledCpuBytes = pool->cpuBytes;
+    stats.pooledGpuBytes = pool->gpuBytes;
+    stats.cpuBytes += pool->cpuBytes;
+    stats.gpuBytes += pool->gpuBytes;
+    stats.sharedIndexBytes = Chunk_GetSharedIndexBytes();
+    for (int i = 0; i < planet->batch->groupCount; i++) {
+        const ChunkHeightAtlas* atlas = &planet->batch->groups[i]->atlas;
+        stats.heightAtlasBytes += (size_t)CHUNK_BATCH_ATLAS_WIDTH * atlas->textureHeight * sizeof(float);
+    }
+    stats.pooledChunks = pool->count;
+    stats.deferredChunks = pool->deferredCount;
+    stats.poolHits = pool->hits;
+    stats.poolMisses = pool->misses;
+    unsigned long long acquires = pool->hits + pool->misses;
+    stats.poolHitRate = acquires > 0 ? (float)((double)pool->hits / (double)acquires) : 0.0f;
+    stats.poolGpuEvictions = pool->gpuEvictions;
+    stats.poolCpuEvictions = pool->cpuEvictions;
+    return stats;
+}
+
+// Drops the planet's jobs that have not started from a shared pool
+static void CancelPlanetJobs(Planet* planet) {
+    for (int i = 0; i < planet->chunkMap->count; i++) {
+        ThreadPool_Cancel(planet->threadPool, planet->chunkMap->entries[i].value);
+    }
+    for (int i = 0; i < planet->prefetchMap->count; i++) {
+        ThreadPool_Cancel(planet->threadPool, planet->prefetchMap->entries[i].value);
+    }
+    for (int i = 0; i < planet->chunkPool->deferredCount; i++) {
+        ThreadPool_Cancel(planet->threadPool, planet->chunkPool->deferred[i]);
+    }
 }
 
 void Planet_Free(Planet* planet) {
-    // Wait for all pending chunk generation to complete
-    ThreadPool_WaitAll(planet->threadPool);
-
-    // Destroy thread pool
-    ThreadPool_Destroy(planet->threadPool);
-
-    // Free all chunks in map
-    ChunkMap_Clear(planet->chunkMap); // We need to actually free the chunks, not just clear
-    // Wait, ChunkMap_Clear just clears entries. We need to iterate and free.
-    // Actually, let's just destroy the map and pool.
-
-    // The map contains active chunks. The pool contains inactive chunks.
-    // We need to free ALL of them.
-
-    // 1. Free active chunks
-    for (int i = 0; i < planet->chunkMap->capacity; i++) {
-        ChunkMapEntry* entry = planet->chunkMap->buckets[i];
-        while (entry) {
-            Chunk_Free(entry->value);
-            entry = entry->next;
-        }
+    if (planet->sharedThreadPool) {
+        // The workers stay with the system. Once this planet's queued jobs
+        // are out, waiting for the pool covers its running ones (and
+        // whatever the other planets have queued).
+        CancelPlanetJobs(planet);
+        ThreadPool_WaitAll(planet->threadPool);
+    } else {
+        // Wait for all pending chunk generation to complete
+        ThreadPool_WaitAll(planet->threadPool);
+        ThreadPool_Destroy(planet->threadPool);
+    }
+    ChunkUploadQueue_Destroy(planet->uploadQueue);
+    planet->chunkPool->uploadQueue = NULL;
+    TileCache_Destroy(planet->tileCache);
+
+    // The map holds the active chunks, the fallback map the retired ones still
+    // drawn, and the pool the inactive ones: free all of them
+    for (int i = 0; i < planet->chunkMap->count; i++) {
+        Chunk_Free(planet->chunkMap->entries[i].value);
     }
     ChunkMap_Destroy(planet->chunkMap);
+    for (int i = 0; i < planet->fallbackMap->count; i++) {
+        for (Chunk* chunk = planet->fallbackMap->entries[i].value; chunk;) {
+            Chunk* next = chunk->nextFallback;
+            Chunk_Free(chunk);
+            chunk = next;
+        }
+    }
+    ChunkMap_Destroy(planet->fallbackMap);
+    for (int i = 0; i < planet->prefetchMap->count; i++) {
+        Chunk_Free(planet->prefetchMap->entries[i].value);
+    }
+    ChunkMap_Destroy(planet->prefetchMap);
 
-    // 2. Free pooled chunks
     ChunkPool_Destroy(planet->chunkPool); // This frees the chunks in the pool
+    ChunkBatch_Destroy(planet->batch);      // After the chunks, which release their atlas slots
 
     CubicQuadTree_Free(planet->quadtree);
+    QuadtreeLeafChanges_Free(&planet->leafChanges);
+    if (planet->prefetchTree) CubicQuadTree_Free(planet->prefetchTree);
+    QuadtreeLeafChanges_Free(&planet->prefetchChanges);
+    free(planet->stats);
     free(planet);
 }
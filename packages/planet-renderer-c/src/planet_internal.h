@@ -0,0 +1,22 @@
+#ifndef PLANET_INTERNAL_H
+#define PLANET_INTERNAL_H
+
+// Planet entry points for PlanetSystem (private, see planet_system.h)
+
+#include "planet.h"
+
+// Planet_Create on a thread pool the caller owns (NULL = its own)
+Planet* PlanetInternal_Create(float radius, float minCellSize, int minCellResolution, Vector3 origin,
+                              float terrainFrequency, float terrainAmplitude, ThreadPool* sharedThreadPool);
+
+// Planet_UpdateWithVelocity in two halves. Begin updates the LOD tree and
+// queues the jobs; a shared pool is not rescored. End uploads within the
+// given budget and swaps the fallbacks. Nothing else of the planet may run
+// in between.
+void PlanetInternal_BeginUpdate(Planet* planet, Vector3 cameraPosition, Vector3 cameraVelocity);
+void PlanetInternal_EndUpdate(Planet* planet, double uploadBudgetMs, int uploadBudgetBytes);
+
+// Rescores the pending jobs of every planet on the pool for its camera
+void PlanetInternal_ReprioritizeJobs(ThreadPool* threadPool);
+
+#endif // PLANET_INTERNAL_H
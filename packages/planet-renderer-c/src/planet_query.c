@@ -0,0 +1,326 @@
+#include "planet.h"
+#include "noise.h"
+#include <math.h>
+#include <raymath.h>
+
+// --- Terrain queries ---
+// A probe is answered from the chunk meshes already in memory where it can
+// be: the live leaf over the point, or a fallback mesh still standing in
+// for it, interpolated bilinearly in its grid cell. Tiles without CPU data
+// (generation in flight, GPU terrain) evaluate MoonTerrain the way the
+// chunk builder does. Main thread, between Planet_Update calls.
+
+#define PLANET_QUERY_BLOCK 64           // Analytic fallbacks evaluated per MoonTerrainBatch call
+#define PLANET_RAYCAST_STEP_SCALE 0.5f  // March step as a fraction of the altitude above the terrain
+#define PLANET_RAYCAST_MAX_STEPS 4096
+#define PLANET_RAYCAST_REFINE_STEPS 16  // Bisection steps once the ray is below the surface
+
+typedef struct SurfaceProbe {
+    Vector3 direction; // Unit, from the planet origin
+    int face;
+    float x;           // Face-plane point the direction crosses
+    float y;
+} SurfaceProbe;
+
+static SurfaceProbe MakeProbe(const Planet* planet, Vector3 position) {
+    SurfaceProbe probe;
+    probe.direction = Vector3Normalize(Vector3Subtract(position, planet->origin));
+    probe.face = CubicQuadTree_ProjectDirection(planet->quadtree, probe.direction, &probe.x, &probe.y);
+    return probe;
+}
+
+// Finest grid spacing the LOD can reach, the scale of the normal estimates
+static float GetFinestCellSize(const Planet* planet) {
+    return planet->minCellSize / planet->minCellResolution;
+}
+
+// --- From chunk data ---
+
+// The mesh is complete and no worker writes it. GPU terrain has no CPU copy.
+static bool HasQueryData(Chunk* chunk) {
+    if (chunk->heightAtlas ? chunk->heights == NULL : chunk->vertices == NULL) return false;
+    ChunkState state = Chunk_GetState(chunk);
+    return state == CHUNK_STATE_READY_TO_UPLOAD || state == CHUNK_STATE_UPLOADED;
+}
+
+static bool ChunkContains(const Chunk* chunk, const SurfaceProbe* probe) {
+    return ChunkId_GetFace(chunk->id) == probe->face &&
+           probe->x >= chunk->offset.x && probe->x <= chunk->offset.x + chunk->width &&
+           probe->y >= chunk->offset.y && probe->y <= chunk->offset.y + chunk->height;
+}
+
+static Chunk* FindQueryChunk(Planet* planet, const SurfaceProbe* probe) {
+    QuadtreeNode* leaf = Quadtree_FindLeafAt(planet->quadtree->faces[probe->face], probe->x, probe->y);
+    Chunk* chunk = (Chunk*)leaf->userData;
+    if (chunk && HasQueryData(chunk)) return chunk;
+
+    // Retired meshes drawn for the leaf or an ancestor until it uploads
+    if (planet->fallbackMap->count > 0) {
+        for (ChunkId id = leaf->id; id != CHUNK_ID_INVALID; id = ChunkId_GetParent(id)) {
+            for (Chunk* fallback = ChunkMap_Get(planet->fallbackMap, id); fallback; fallback = fallback->nextFallback) {
+                if (ChunkContains(fallback, probe) && HasQueryData(fallback)) return fallback;
+            }
+        }
+    }
+    return NULL;
+}
+
+// Surface points relative to the planet origin, in double: grid points sit
+// meters apart but a radius away, too far for float differences
+typedef struct QueryPoint {
+    double x, y, z;
+} QueryPoint;
+
+static QueryPoint QueryPoint_Subtract(QueryPoint a, QueryPoint b) {
+    return (QueryPoint){ a.x - b.x, a.y - b.y, a.z - b.z };
+}
+
+static QueryPoint QueryPoint_Lerp(QueryPoint a, QueryPoint b, double t) {
+    return (QueryPoint){ a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t };
+}
+
+static double QueryPoint_Length(QueryPoint a) {
+    return sqrt(a.x * a.x + a.y * a.y + a.z * a.z);
+}
+
+// Normal of the patch spanned by du and dv (both along the face axes, so
+// the cross product points outward)
+static Vector3 GetPatchNormal(QueryPoint du, QueryPoint dv) {
+    QueryPoint n = { du.y * dv.z - du.z * dv.y, du.z * dv.x - du.x * dv.z, du.x * dv.y - du.y * dv.x };
+    double length = QueryPoint_Length(n);
+    if (length <= 0.0) return (Vector3){ 0.0f, 0.0f, 0.0f };
+    return (Vector3){ (float)(n.x / length), (float)(n.y / length), (float)(n.z / length) };
+}
+
+// Face-plane point pushed onto the sphere at a given radius
+static QueryPoint GetSpherePoint(Matrix localToWorld, double x, double y, double radius) {
+    const Matrix m = localToWorld;
+    QueryPoint p = { m.m0 * x + m.m4 * y + m.m12, m.m1 * x + m.m5 * y + m.m13, m.m2 * x + m.m6 * y + m.m14 };
+    double scale = radius / QueryPoint_Length(p);
+    return (QueryPoint){ p.x * scale, p.y * scale, p.z * scale };
+}
+
+// Grid vertex (x, y) as the chunk is drawn
+static QueryPoint GetChunkGridPoint(const Chunk* chunk, int x, int y) {
+    int res = chunk->resolution;
+    if (chunk->heightAtlas) {
+        // Instanced: the vertex shader's projection of the padded heights
+        float h = chunk->heights[(y + 1) * (res + 3) + (x + 1)];
+        return GetSpherePoint(chunk->localToWorld, chunk->offset.x + (double)x * chunk->width / res,
+                              chunk->offset.y + (double)y * chunk->height / res, (double)chunk->radius + h);
+    }
+
+    const ChunkVertex* vertex = &chunk->vertices[y * (res + 1) + x];
+    return (QueryPoint){
+        (double)chunk->boundsMin.x - chunk->origin.x + vertex->position[0] * (chunk->boundsExtent.x / 65535.0),
+        (double)chunk->boundsMin.y - chunk->origin.y + vertex->position[1] * (chunk->boundsExtent.y / 65535.0),
+        (double)chunk->boundsMin.z - chunk->origin.z + vertex->position[2] * (chunk->boundsExtent.z / 65535.0)
+    };
+}
+
+// Bilinear over the grid cell under the probe: radial distance of the four
+// corners, normal of the interpolated patch
+static float SampleChunk(const Chunk* chunk, const SurfaceProbe* probe, Vector3* normal) {
+    int res = chunk->resolution;
+    float gx = Clamp((probe->x - chunk->offset.x) / chunk->width * res, 0.0f, (float)res);
+    float gy = Clamp((probe->y - chunk->offset.y) / chunk->height * res, 0.0f, (float)res);
+    int x = gx < res ? (int)gx : res - 1;
+    int y = gy < res ? (int)gy : res - 1;
+    double fx = gx - x;
+    double fy = gy - y;
+
+    QueryPoint p00 = GetChunkGridPoint(chunk, x, y);
+    QueryPoint p10 = GetChunkGridPoint(chunk, x + 1, y);
+    QueryPoint p01 = GetChunkGridPoint(chunk, x, y + 1);
+    QueryPoint p11 = GetChunkGridPoint(chunk, x + 1, y + 1);
+
+    if (normal) {
+        QueryPoint du = QueryPoint_Lerp(QueryPoint_Subtract(p10, p00), QueryPoint_Subtract(p11, p01), fy);
+        QueryPoint dv = QueryPoint_Lerp(QueryPoint_Subtract(p01, p00), QueryPoint_Subtract(p11, p10), fx);
+        *normal = GetPatchNormal(du, dv);
+    }
+
+    double h0 = QueryPoint_Length(p00) + (QueryPoint_Length(p10) - QueryPoint_Length(p00)) * fx;
+    double h1 = QueryPoint_Length(p01) + (QueryPoint_Length(p11) - QueryPoint_Length(p01)) * fx;
+    return (float)(h0 + (h1 - h0) * fy);
+}
+
+// --- Analytic fallback ---
+
+// Noise domain of a face-plane point, as in StageGridPositions
+static void GetNoisePosition(const Planet* planet, float x, float y, float* nx, float* ny) {
+    float noiseScale = planet->terrainFrequency / (2.0f * planet->radius);
+    *nx = (x + planet->radius) * noiseScale;
+    *ny = (y + planet->radius) * noiseScale;
+}
+
+static double GetSurfaceRadius(const Planet* planet, float noise) {
+    return planet->radius + (double)planet->radius * planet->terrainAmplitude * noise;
+}
+
+// Forward differences one finest cell along each face axis
+static Vector3 GetAnalyticNormal(const Planet* planet, const SurfaceProbe* probe, double radius, double radiusX, double radiusY) {
+    Matrix localToWorld = planet->quadtree->faces[probe->face]->localToWorld;
+    double step = GetFinestCellSize(planet);
+    QueryPoint p = GetSpherePoint(localToWorld, probe->x, probe->y, radius);
+    QueryPoint px = GetSpherePoint(localToWorld, probe->x + step, probe->y, radiusX);
+    QueryPoint py = GetSpherePoint(localToWorld, probe->x, probe->y + step, radiusY);
+    return GetPatchNormal(QueryPoint_Subtract(px, p), QueryPoint_Subtract(py, p));
+}
+
+static float SampleAnalytic(const Planet* planet, const SurfaceProbe* probe, Vector3* normal) {
+    float nx, ny;
+    GetNoisePosition(planet, probe->x, probe->y, &nx, &ny);
+    double radius = GetSurfaceRadius(planet, MoonTerrain(nx, ny));
+    if (normal) {
+        float step = GetFinestCellSize(planet);
+        float nxX, nyX, nxY, nyY;
+        GetNoisePosition(planet, probe->x + step, probe->y, &nxX, &nyX);
+        GetNoisePosition(planet, probe->x, probe->y + step, &nxY, &nyY);
+        *normal = GetAnalyticNormal(planet, probe, radius,
+                                    GetSurfaceRadius(planet, MoonTerrain(nxX, nyX)),
+                                    GetSurfaceRadius(planet, MoonTerrain(nxY, nyY)));
+    }
+    return (float)radius;
+}
+
+// --- API ---
+
+float Planet_SampleHeight(Planet* planet, Vector3 position, Vector3* normal) {
+    SurfaceProbe probe = MakeProbe(planet, position);
+    Chunk* chunk = FindQueryChunk(planet, &probe);
+    return chunk ? SampleChunk(chunk, &probe, normal) : SampleAnalytic(planet, &probe, normal);
+}
+
+// Analytic fallbacks of a batch, gathered so MoonTerrainBatch runs them in
+// SIMD: the point itself, then its two difference neighbors if normals
+typedef struct AnalyticBlock {
+    SurfaceProbe probes[PLANET_QUERY_BLOCK];
+    int indices[PLANET_QUERY_BLOCK];
+    int count;
+} AnalyticBlock;
+
+static void FlushAnalyticBlock(const Planet* planet, AnalyticBlock* block, float* heights, Vector3* normals) {
+    float nx[3 * PLANET_QUERY_BLOCK];
+    float ny[3 * PLANET_QUERY_BLOCK];
+    float noise[3 * PLANET_QUERY_BLOCK];
+    int perProbe = normals ? 3 : 1;
+    float step = GetFinestCellSize(planet);
+
+    for (int i = 0; i < block->count; i++) {
+        const SurfaceProbe* probe = &block->probes[i];
+        GetNoisePosition(planet, probe->x, probe->y, &nx[i * perProbe], &ny[i * perProbe]);
+        if (normals) {
+            GetNoisePosition(planet, probe->x + step, probe->y, &nx[i * 3 + 1], &ny[i * 3 + 1]);
+            GetNoisePosition(planet, probe->x, probe->y + step, &nx[i * 3 + 2], &ny[i * 3 + 2]);
+        }
+    }
+    MoonTerrainBatch(nx, ny, noise, block->count * perProbe);
+
+    for (int i = 0; i < block->count; i++) {
+        int index = block->indices[i];
+        double radius = GetSurfaceRadius(planet, noise[i * perProbe]);
+        heights[index] = (float)radius;
+        if (normals) {
+            normals[index] = GetAnalyticNormal(planet, &block->probes[i], radius,
+                                               GetSurfaceRadius(planet, noise[i * 3 + 1]),
+                                               GetSurfaceRadius(planet, noise[i * 3 + 2]));
+        }
+    }
+    block->count = 0;
+}
+
+void Planet_SampleHeightBatch(Planet* planet, const Vector3* positions, float* heights, Vector3* normals, int count) {
+    AnalyticBlock block;
+    block.count = 0;
+    Chunk* last = NULL; // Probes of one vehicle or placement pass tend to share a chunk
+
+    for (int i = 0; i < count; i++) {
+        SurfaceProbe probe = MakeProbe(planet, positions[i]);
+        Chunk* chunk = last && ChunkContains(last, &probe) ? last : FindQueryChunk(planet, &probe);
+        if (chunk) {
+            heights[i] = SampleChunk(chunk, &probe, normals ? &normals[i] : NULL);
+            last = chunk;
+            continue;
+        }
+
+        block.probes[block.count] = probe;
+        block.indices[block.count] = i;
+        if (++block.count == PLANET_QUERY_BLOCK) FlushAnalyticBlock(planet, &block, heights, normals);
+    }
+    if (block.count > 0) FlushAnalyticBlock(planet, &block, heights, normals);
+}
+
+// Height of a point above the terrain under it (negative below)
+static float GetAltitude(Planet* planet, Vector3 point) {
+    return Vector3Distance(point, planet->origin) - Planet_SampleHeight(planet, point, NULL);
+}
+
+// Entry and exit distances of a ray through a sphere around the origin
+static bool IntersectSphere(Vector3 origin, Vector3 direction, Vector3 center, float radius, float* tNear, float* tFar) {
+    Vector3 oc = Vector3Subtract(origin, center);
+    float b = Vector3DotProduct(oc, direction);
+    float c = Vector3DotProduct(oc, oc) - radius * radius;
+    float discriminant = b * b - c;
+    if (discriminant < 0.0f) return false;
+    float root = sqrtf(discriminant);
+    *tNear = -b - root;
+    *tFar = -b + root;
+    return true;
+}
+
+bool Planet_Raycast(Planet* planet, Ray ray, float maxDistance, RayCollision* hit) {
+    RayCollision result = { 0 };
+    Vector3 direction = Vector3Normalize(ray.direction);
+
+    // The terrain lies between two spheres: march only through the outer one,
+    // and no further than the inner one, which is always below the surface
+    float tStart, tEnd;
+    if (!IntersectSphere(ray.position, direction, planet->origin, planet->radius + planet->maxDisplacement, &tStart, &tEnd) ||
+        tEnd < 0.0f) {
+        if (hit) *hit = result;
+        return false;
+    }
+    tStart = fmaxf(tStart, 0.0f);
+    tEnd = fminf(tEnd, maxDistance);
+    float tInner, tInnerFar;
+    if (IntersectSphere(ray.position, direction, planet->origin, planet->radius - planet->maxDisplacement, &tInner, &tInnerFar) &&
+        tInnerFar >= 0.0f && tInner < tEnd) {
+        tEnd = fmaxf(tInner, tStart);
+    }
+
+    float minStep = GetFinestCellSize(planet);
+    float tPrev = tStart;
+    float t = tStart;
+    float altitude = GetAltitude(planet, Vector3Add(ray.position, Vector3Scale(direction, t)));
+    for (int i = 0; altitude > 0.0f && i < PLANET_RAYCAST_MAX_STEPS; i++) {
+        if (t >= tEnd) break;
+        tPrev = t;
+        t = fminf(t + fmaxf(altitude * PLANET_RAYCAST_STEP_SCALE, minStep), tEnd);
+        altitude = GetAltitude(planet, Vector3Add(ray.position, Vector3Scale(direction, t)));
+    }
+    if (altitude > 0.0f) {
+        if (hit) *hit = result;
+        return false;
+    }
+
+    // The surface crossing lies in (tPrev, t]
+    float lo = tPrev;
+    float hi = t;
+    for (int i = 0; i < PLANET_RAYCAST_REFINE_STEPS && hi > lo; i++) {
+        float mid = 0.5f * (lo + hi);
+        if (GetAltitude(planet, Vector3Add(ray.position, Vector3Scale(direction, mid))) > 0.0f) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    result.hit = true;
+    result.distance = hi;
+    Vector3 point = Vector3Add(ray.position, Vector3Scale(direction, hi));
+    float surface = Planet_SampleHeight(planet, point, &result.normal);
+    result.point = Vector3Add(planet->origin, Vector3Scale(Vector3Normalize(Vector3Subtract(point, planet->origin)), surface));
+    if (hit) *hit = result;
+    return true;
+}
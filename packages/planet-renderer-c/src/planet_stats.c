@@ -0,0 +1,162 @@
+#include "planet_stats.h"
+#include "planet_trace.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+// Kept apart from planet.h: raylib.h and windows.h clash
+
+double PlanetStats_Now(void) {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+const PlanetFrameStats* PlanetStats_GetFrame(const PlanetStats* stats, int framesAgo) {
+    if (!stats || framesAgo < 0 || framesAgo >= stats->count) return NULL;
+    return &stats->frames[(stats->newest - framesAgo + PLANET_STATS_HISTORY) % PLANET_STATS_HISTORY];
+}
+
+#ifdef PLANET_ENABLE_STATS
+
+// --- Trace ---
+// One ring of spans for the whole process, guarded by a mutex: spans are
+// phases and chunk builds, a few hundred per frame at most. Threads get a
+// trace ID the first time they record.
+
+#define PLANET_TRACE_MAX_THREADS 64
+#define PLANET_TRACE_THREAD_NAME_LENGTH 32
+
+typedef struct PlanetTraceSpan {
+    const char* name;
+    double start;
+    double end;
+    int thread;
+} PlanetTraceSpan;
+
+static PlanetTraceSpan traceSpans[PLANET_TRACE_CAPACITY];
+static unsigned long long traceSpanCount; // Ever recorded; the ring holds the last PLANET_TRACE_CAPACITY
+static char traceThreadNames[PLANET_TRACE_MAX_THREADS][PLANET_TRACE_THREAD_NAME_LENGTH];
+static int traceThreadCount;
+static pthread_mutex_t traceMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t traceThreadKey;
+static pthread_once_t traceThreadKeyOnce = PTHREAD_ONCE_INIT;
+
+static void CreateTraceThreadKey(void) {
+    pthread_key_create(&traceThreadKey, NULL);
+}
+
+// Trace ID of the calling thread, from 1 (caller holds traceMutex)
+static int GetTraceThread(void) {
+    pthread_once(&traceThreadKeyOnce, CreateTraceThreadKey);
+    intptr_t id = (intptr_t)pthread_getspecific(traceThreadKey);
+    if (id == 0) {
+        id = ++traceThreadCount;
+        pthread_setspecific(traceThreadKey, (void*)id);
+    }
+    return (int)id;
+}
+
+void PlanetTrace_AddSpan(const char* name, double start, double end) {
+    pthread_mutex_lock(&traceMutex);
+    PlanetTraceSpan* span = &traceSpans[traceSpanCount % PLANET_TRACE_CAPACITY];
+    span->name = name;
+    span->start = start;
+    span->end = end;
+    span->thread = GetTraceThread();
+    traceSpanCount++;
+    pthread_mutex_unlock(&traceMutex);
+}
+
+void PlanetTrace_SetThreadName(const char* name, int index) {
+    pthread_mutex_lock(&traceMutex);
+    int thread = GetTraceThread();
+    if (thread <= PLANET_TRACE_MAX_THREADS) {
+        char* slot = traceThreadNames[thread - 1];
+        if (index >= 0) {
+            snprintf(slot, PLANET_TRACE_THREAD_NAME_LENGTH, "%s %d", name, index);
+        } else {
+            snprintf(slot, PLANET_TRACE_THREAD_NAME_LENGTH, "%s", name);
+        }
+    }
+    pthread_mutex_unlock(&traceMutex);
+}
+
+// Chrome trace timestamps are microseconds
+static double TraceMicroseconds(double seconds) {
+    return seconds * 1e6;
+}
+
+static void WriteCounters(FILE* file, const PlanetStats* stats, int planet) {
+    for (int i = stats->count - 1; i >= 0; i--) {
+        const PlanetFrameStats* frame = PlanetStats_GetFrame(stats, i);
+        double ts = TraceMicroseconds(frame->time);
+        fprintf(file, ",\n{\"name\":\"Planet %d generation\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,"
+                      "\"args\":{\"queueDepth\":%d,\"chunksReady\":%d,\"uploadsPending\":%d}}",
+                planet, ts, frame->queueDepth, frame->chunksReady, frame->uploadsPending);
+        fprintf(file, ",\n{\"name\":\"Planet %d chunks\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,"
+                      "\"args\":{\"leaves\":%d,\"created\":%d,\"reused\":%d,\"pooled\":%d}}",
+                planet, ts, frame->leafCount, frame->chunksCreated, frame->chunksReused, frame->chunksPooled);
+        fprintf(file, ",\n{\"name\":\"Planet %d memory MB\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,"
+                      "\"args\":{\"cpu\":%.3f,\"gpu\":%.3f}}",
+                planet, ts, frame->cpuBytes / (1024.0 * 1024.0), frame->gpuBytes / (1024.0 * 1024.0));
+        fprintf(file, ",\n{\"name\":\"Planet %d upload KB\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,"
+                      "\"args\":{\"bytes\":%.3f}}",
+                planet, ts, frame->uploadBytes / 1024.0);
+    }
+}
+
+bool PlanetStats_WriteChromeTrace(const char* path, const PlanetStats* const* planets, int planetCount) {
+    FILE* file = fopen(path, "w");
+    if (!file) return false;
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Planet renderer\"}}");
+
+    pthread_mutex_lock(&traceMutex);
+    for (int i = 0; i < traceThreadCount && i < PLANET_TRACE_MAX_THREADS; i++) {
+        const char* name = traceThreadNames[i][0] ? traceThreadNames[i] : "Thread";
+        fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                i + 1, name);
+    }
+    unsigned long long first = traceSpanCount > PLANET_TRACE_CAPACITY ? traceSpanCount - PLANET_TRACE_CAPACITY : 0;
+    for (unsigned long long i = first; i < traceSpanCount; i++) {
+        const PlanetTraceSpan* span = &traceSpans[i % PLANET_TRACE_CAPACITY];
+        fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"planet\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                span->name, span->thread, TraceMicroseconds(span->start),
+                TraceMicroseconds(span->end - span->start));
+    }
+    pthread_mutex_unlock(&traceMutex);
+
+    for (int i = 0; i < planetCount; i++) {
+        if (planets[i]) WriteCounters(file, planets[i], i);
+    }
+
+    fprintf(file, "\n]}\n");
+    bool written = ferror(file) == 0;
+    return fclose(file) == 0 && written;
+}
+
+#else
+
+bool PlanetStats_WriteChromeTrace(const char* path, const PlanetStats* const* planets, int planetCount) {
+    (void)path;
+    (void)planets;
+    (void)planetCount;
+    return false;
+}
+
+#endif
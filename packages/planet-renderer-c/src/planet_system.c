@@ -0,0 +1,166 @@
+#include "planet_system.h"
+#include "planet_internal.h"
+#include <raymath.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+PlanetSystem* PlanetSystem_Create(int threadCount) {
+    PlanetSystem* system = (PlanetSystem*)malloc(sizeof(PlanetSystem));
+    system->threadPool = ThreadPool_Create(threadCount);
+    system->capacity = 4;
+    system->count = 0;
+    system->entries = (PlanetSystemEntry*)malloc(sizeof(PlanetSystemEntry) * system->capacity);
+    system->fovy = PLANET_DEFAULT_LOD_FOVY;
+    system->screenHeight = PLANET_DEFAULT_LOD_SCREEN_HEIGHT;
+    system->lowLodPixels = PLANET_SYSTEM_DEFAULT_LOW_LOD_PIXELS;
+    system->triangleBudget = 0;
+    system->uploadBudgetMs = 2.0f;
+    system->uploadBudgetBytes = 0;
+    system->poolCpuBudgetBytes = PLANET_DEFAULT_POOL_CPU_BYTES;
+    system->poolGpuBudgetBytes = PLANET_DEFAULT_POOL_GPU_BYTES;
+    system->tileCacheBudgetBytes = PLANET_DEFAULT_TILE_CACHE_BYTES;
+    return system;
+}
+
+Planet* PlanetSystem_AddPlanet(PlanetSystem* system, float radius, float minCellSize, int minCellResolution,
+                               Vector3 origin, float terrainFrequency, float terrainAmplitude) {
+    if (system->count == system->capacity) {
+        system->capacity *= 2;
+        system->entries = (PlanetSystemEntry*)realloc(system->entries, sizeof(PlanetSystemEntry) * system->capacity);
+    }
+    Planet* planet = PlanetInternal_Create(radius, minCellSize, minCellResolution, origin,
+                                           terrainFrequency, terrainAmplitude, system->threadPool);
+    system->entries[system->count++] = (PlanetSystemEntry){ planet, 0.0f, 0.0f, false };
+    return planet;
+}
+
+void PlanetSystem_RemovePlanet(PlanetSystem* system, Planet* planet) {
+    for (int i = 0; i < system->count; i++) {
+        if (system->entries[i].planet != planet) continue;
+        system->entries[i] = system->entries[--system->count];
+        Planet_Free(planet);
+        return;
+    }
+}
+
+static int CompareEntriesByScreenRadius(const void* a, const void* b) {
+    float ra = ((const PlanetSystemEntry*)a)->screenRadius;
+    float rb = ((const PlanetSystemEntry*)b)->screenRadius;
+    return (ra < rb) - (ra > rb);
+}
+
+// Part of a budget, never 0 (which would mean no limit)
+static size_t ShareBudget(size_t budget, float share) {
+    if (budget == 0) return 0;
+    size_t part = (size_t)((double)budget * share);
+    return part > 0 ? part : 1;
+}
+
+// Bytes of one chunk of the planet's grid, vertices and skirt included
+static size_t EstimateChunkBytes(const Planet* planet) {
+    size_t side = (size_t)planet->minCellResolution + 1;
+    return sizeof(Chunk) + side * (side + 4) * sizeof(ChunkVertex);
+}
+
+// Pool budget share, but at least PLANET_SYSTEM_MIN_POOLED_CHUNKS chunks
+// (within the whole budget): a tiny share would free every retired chunk
+// and turn each split and merge into allocations
+static size_t SharePoolBudget(size_t budget, float share, const Planet* planet) {
+    size_t part = ShareBudget(budget, share);
+    if (part == 0) return 0;
+    size_t floor = PLANET_SYSTEM_MIN_POOLED_CHUNKS * EstimateChunkBytes(planet);
+    if (floor > budget) floor = budget;
+    return part > floor ? part : floor;
+}
+
+void PlanetSystem_Update(PlanetSystem* system, Vector3 cameraPosition) {
+    PlanetSystem_UpdateWithVelocity(system, cameraPosition, (Vector3){ 0 });
+}
+
+void PlanetSystem_UpdateWithVelocity(PlanetSystem* system, Vector3 cameraPosition, Vector3 cameraVelocity) {
+    // 1. Rank the planets by angular radius on screen. Budgets follow the
+    // screen area, which stops growing once a planet fills the view.
+    float pixelsPerRadian = system->screenHeight / (2.0f * tanf(system->fovy * DEG2RAD * 0.5f));
+    float totalArea = 0.0f;
+    float detailedArea = 0.0f;
+    for (int i = 0; i < system->count; i++) {
+        PlanetSystemEntry* entry = &system->entries[i];
+        Planet* planet = entry->planet;
+        float distance = fmaxf(Vector3Distance(cameraPosition, planet->origin), planet->radius);
+        entry->screenRadius = asinf(planet->radius / distance) * pixelsPerRadian;
+        if (entry->screenRadius < system->lowLodPixels) {
+            entry->lowLod = true;
+        } else if (entry->screenRadius >= system->lowLodPixels * PLANET_SYSTEM_LOW_LOD_HYSTERESIS) {
+            entry->lowLod = false;
+        }
+        float extent = fminf(entry->screenRadius, (float)system->screenHeight);
+        totalArea += extent * extent;
+        if (!entry->lowLod) detailedArea += extent * extent;
+    }
+    qsort(system->entries, system->count, sizeof(PlanetSystemEntry), CompareEntriesByScreenRadius);
+
+    // 2. Hand out the budgets and update the trees. Jobs go to the shared
+    // pool, which is rescored once everything is queued.
+    for (int i = 0; i < system->count; i++) {
+        PlanetSystemEntry* entry = &system->entries[i];
+        Planet* planet = entry->planet;
+        float extent = fminf(entry->screenRadius, (float)system->screenHeight);
+        float area = extent * extent;
+        entry->share = totalArea > 0.0f ? area / totalArea : 1.0f / system->count;
+
+        planet->lodFovy = system->fovy;
+        planet->lodScreenHeight = system->screenHeight;
+        planet->lodDistanceScale = entry->lowLod ? 0.0f : 1.0f;
+        planet->lodTriangleBudget = 0;
+        if (system->triangleBudget > 0 && !entry->lowLod) {
+            // Reduced planets need no triangle share, only their six roots
+            float share = detailedArea > 0.0f ? area / detailedArea : 1.0f;
+            planet->lodTriangleBudget = (int)ShareBudget((size_t)system->triangleBudget, share);
+        }
+        planet->poolCpuBudgetBytes = SharePoolBudget(system->poolCpuBudgetBytes, entry->share, planet);
+        planet->poolGpuBudgetBytes = SharePoolBudget(system->poolGpuBudgetBytes, entry->share, planet);
+        // Takes effect as the cache next stores a tile (a budget of 0 would keep none)
+        pthread_mutex_lock(&planet->tileCache->mutex);
+        planet->tileCache->memoryBudget = system->tileCacheBudgetBytes > 0
+                                        ? ShareBudget(system->tileCacheBudgetBytes, entry->share) : SIZE_MAX;
+        pthread_mutex_unlock(&planet->tileCache->mutex);
+
+        PlanetInternal_BeginUpdate(planet, cameraPosition, cameraVelocity);
+    }
+    PlanetInternal_ReprioritizeJobs(system->threadPool);
+
+    // 3. Uploads, largest planet first, until the shared budget is spent.
+    // The rest still take their nearest ready chunk, so none starves.
+    double start = GetTime();
+    int bytes = 0;
+    for (int i = 0; i < system->count; i++) {
+        double budgetMs = system->uploadBudgetMs;
+        int budgetBytes = system->uploadBudgetBytes;
+        if (budgetMs > 0.0) budgetMs = fmax(budgetMs - (GetTime() - start) * 1000.0, 1e-6);
+        if (budgetBytes > 0) budgetBytes = budgetBytes - bytes > 1 ? budgetBytes - bytes : 1;
+
+        Planet* planet = system->entries[i].planet;
+        PlanetInternal_EndUpdate(planet, budgetMs, budgetBytes);
+        bytes += planet->uploadQueue->lastProcessBytes;
+    }
+}
+
+int PlanetSystem_Draw(PlanetSystem* system) {
+    int triangles = 0;
+    for (int i = 0; i < system->count; i++) {
+        triangles += Planet_Draw(system->entries[i].planet);
+    }
+    return triangles;
+}
+
+void PlanetSystem_Free(PlanetSystem* system) {
+    // Nothing more gets queued, so finish the jobs once instead of per planet
+    ThreadPool_WaitAll(system->threadPool);
+    for (int i = 0; i < system->count; i++) {
+        Planet_Free(system->entries[i].planet);
+    }
+    ThreadPool_Destroy(system->threadPool);
+    free(system->entries);
+    free(system);
+}
@@ -0,0 +1,30 @@
+#ifndef PLANET_TRACE_H
+#define PLANET_TRACE_H
+
+// Instrumentation hooks of the library (private, see planet_stats.h).
+// Without PLANET_ENABLE_STATS they expand to nothing.
+
+#include "planet_stats.h"
+
+#ifdef PLANET_ENABLE_STATS
+
+// Records [start, now] on the calling thread. name must outlive the trace
+// (a string literal).
+void PlanetTrace_AddSpan(const char* name, double start, double end);
+void PlanetTrace_SetThreadName(const char* name, int index); // Shown as "name index"
+
+#define PLANET_STATS_NOW() PlanetStats_Now()
+#define PLANET_TRACE_SPAN(name, start) PlanetTrace_AddSpan((name), (start), PlanetStats_Now())
+#define PLANET_TRACE_THREAD_NAME(name, index) PlanetTrace_SetThreadName((name), (index))
+#define PLANET_STATS_ONLY(statement) statement
+
+#else
+
+#define PLANET_STATS_NOW() 0.0
+#define PLANET_TRACE_SPAN(name, start) ((void)(start))
+#define PLANET_TRACE_THREAD_NAME(name, index) ((void)0)
+#define PLANET_STATS_ONLY(statement)
+
+#endif
+
+#endif // PLANET_TRACE_H
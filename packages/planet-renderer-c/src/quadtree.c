@@ -2,44 +2,83 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <math.h>
+#include <float.h>
 
-// DJB2 hash variant for mixing floats/ints
-static unsigned long long HashChunkKey(int faceId, float x, float y, float size) {
-    unsigned long long hash = 5381;
-    
-    // Mix faceId
-    hash = ((hash << 5) + hash) + faceId;
-    
-    // Mix floats as raw bytes to avoid precision issues if possible, 
-    // but for now casting to int scaled might be safer or just raw bytes.
-    // Let's use raw bytes of the float.
-    unsigned int* xi = (unsigned int*)&x;
-    unsigned int* yi = (unsigned int*)&y;
-    unsigned int* si = (unsigned int*)&size;
-    
-    hash = ((hash << 5) + hash) + *xi;
-    hash = ((hash << 5) + hash) + *yi;
-    hash = ((hash << 5) + hash) + *si;
-    
-    return hash;
+// --- Node Arena ---
+
+static QuadtreeNode* NodeAt(const QuadtreeNodeArena* arena, int index) {
+    return &arena->pages[index >> QUADTREE_ARENA_PAGE_SHIFT][index & (QUADTREE_ARENA_PAGE_NODES - 1)];
+}
+
+static void Arena_Init(QuadtreeNodeArena* arena) {
+    arena->pages = NULL;
+    arena->pageCount = 0;
+    arena->pageCapacity = 0;
+    arena->groupCount = 0;
+    arena->freeGroup = -1;
+    arena->liveGroups = 0;
+}
+
+// Returns the arena index of the first node of a free sibling group
+static int Arena_AllocGroup(QuadtreeNodeArena* arena) {
+    int first;
+    if (arena->freeGroup >= 0) {
+        first = arena->freeGroup;
+        arena->freeGroup = NodeAt(arena, first)->firstChild;
+    } else {
+        first = arena->groupCount * 4;
+        if ((first >> QUADTREE_ARENA_PAGE_SHIFT) >= arena->pageCount) {
+            if (arena->pageCount >= arena->pageCapacity) {
+                arena->pageCapacity = arena->pageCapacity > 0 ? arena->pageCapacity * 2 : 8;
+                arena->pages = (QuadtreeNode**)realloc(arena->pages, sizeof(QuadtreeNode*) * arena->pageCapacity);
+            }
+            arena->pages[arena->pageCount++] = (QuadtreeNode*)malloc(sizeof(QuadtreeNode) * QUADTREE_ARENA_PAGE_NODES);
+        }
+        arena->groupCount++;
+    }
+    arena->liveGroups++;
+    return first;
+}
+
+static void Arena_FreeGroup(QuadtreeNodeArena* arena, int first) {
+    NodeAt(arena, first)->firstChild = arena->freeGroup;
+    arena->freeGroup = first;
+    arena->liveGroups--;
+}
+
+// Forget every group but keep the pages for reuse
+static void Arena_Reset(QuadtreeNodeArena* arena) {
+    arena->groupCount = 0;
+    arena->freeGroup = -1;
+    arena->liveGroups = 0;
+}
+
+static void Arena_Free(QuadtreeNodeArena* arena) {
+    for (int i = 0; i < arena->pageCount; i++) {
+        free(arena->pages[i]);
+    }
+    free(arena->pages);
+    Arena_Init(arena);
 }
 
-// Private helper to create a node
-static QuadtreeNode* CreateNode(BoundingBox3 bounds, Matrix localToWorld, float planetRadius, Vector3 planetOrigin, int faceId) {
-    QuadtreeNode* node = (QuadtreeNode*)malloc(sizeof(QuadtreeNode));
+// Private helper to initialize a node in place
+static void InitNode(QuadtreeNode* node, BoundingBox3 bounds, Matrix localToWorld, float planetRadius, float maxDisplacement, Vector3 planetOrigin, int faceId, ChunkId id,
+                     float geometricError, float parentSplitDistance) {
     node->bounds = bounds;
-    for (int i = 0; i < 4; i++) node->children[i] = NULL;
+    node->geometricError = geometricError;
+    node->errorMeasured = false;
+    node->parentSplitDistance = parentSplitDistance;
+    node->firstChild = -1;
     node->isLeaf = true;
     node->userData = NULL;
-    node->localToWorld = localToWorld;
     node->faceId = faceId;
+    node->coarserEdges = 0;
     
     node->center = BoundingBoxCenter(bounds);
     node->size = BoundingBoxSize(bounds);
     
-    // Generate ID
-    // We use bounds min x/y and size x (assuming square nodes) + faceId
-    node->id = HashChunkKey(faceId, bounds.min.x, bounds.min.y, node->size.x);
+    node->id = id;
     
     // Calculate sphere center
     Vector3 worldPos = Vector3Transform(node->center, localToWorld);
@@ -47,86 +86,255 @@ static QuadtreeNode* CreateNode(BoundingBox3 bounds, Matrix localToWorld, float
     Vector3 scaled = Vector3Scale(normalized, planetRadius);
     node->sphereCenter = Vector3Add(scaled, planetOrigin);
     
+    // Bounding sphere: the corners are the points of the patch farthest from
+    // its center, and lifting them by maxDisplacement covers the terrain
+    Vector3 corners[4] = {
+        bounds.min,
+        (Vector3){ bounds.max.x, bounds.min.y, 0 },
+        (Vector3){ bounds.min.x, bounds.max.y, 0 },
+        bounds.max
+    };
+    float maxRadius = planetRadius + maxDisplacement;
+    node->boundingRadius = maxDisplacement;
+    node->patchRadius = 0.0f;
+    for (int i = 0; i < 4; i++) {
+        Vector3 cornerDir = Vector3Normalize(Vector3Transform(corners[i], localToWorld));
+        Vector3 corner = Vector3Add(Vector3Scale(cornerDir, maxRadius), planetOrigin);
+        node->boundingRadius = fmaxf(node->boundingRadius, Vector3Distance(corner, node->sphereCenter));
+        Vector3 sphereCorner = Vector3Add(Vector3Scale(cornerDir, planetRadius), planetOrigin);
+        node->patchRadius = fmaxf(node->patchRadius, Vector3Distance(sphereCorner, node->sphereCenter));
+    }
+}
+
+QuadtreeNode* Quadtree_GetChildren(const Quadtree* tree, const QuadtreeNode* node) {
+    if (node->isLeaf) return NULL;
+    return NodeAt(&tree->arena, node->firstChild);
+}
+
+QuadtreeNode* Quadtree_FindNode(const Quadtree* tree, ChunkId id) {
+    if (ChunkId_GetFace(id) != tree->faceId) return NULL;
+
+    // The child index at each level is the next pair of Morton bits
+    QuadtreeNode* node = (QuadtreeNode*)&tree->root;
+    int level = ChunkId_GetLevel(id);
+    for (int depth = 1; depth <= level && !node->isLeaf; depth++) {
+        int child = ChunkId_GetChildIndexAt(id, depth);
+        node = NodeAt(&tree->arena, node->firstChild + child);
+    }
     return node;
 }
 
-static void FreeNode(QuadtreeNode* node) {
-    if (!node) return;
-    for (int i = 0; i < 4; i++) {
-        FreeNode(node->children[i]);
+QuadtreeNode* Quadtree_FindLeafAt(const Quadtree* tree, float x, float y) {
+    QuadtreeNode* node = (QuadtreeNode*)&tree->root;
+    while (!node->isLeaf) {
+        float midX = 0.5f * (node->bounds.min.x + node->bounds.max.x);
+        float midY = 0.5f * (node->bounds.min.y + node->bounds.max.y);
+        int child = (y >= midY ? 2 : 0) | (x >= midX ? 1 : 0);
+        node = NodeAt(&tree->arena, node->firstChild + child);
     }
-    free(node);
+    return node;
 }
 
-Quadtree* Quadtree_Create(float size, float minNodeSize, float comparatorValue, Vector3 origin, Matrix localToWorld, int faceId) {
+Quadtree* Quadtree_Create(float size, float minNodeSize, float comparatorValue, float maxDisplacement, Vector3 origin, Matrix localToWorld, int faceId) {
     Quadtree* tree = (Quadtree*)malloc(sizeof(Quadtree));
     tree->size = size;
     tree->minNodeSize = minNodeSize;
+    tree->maxDisplacement = maxDisplacement;
     tree->comparatorValue = comparatorValue;
+    tree->errorDistanceScale = 0.0f;
+    tree->mergeHysteresis = QUADTREE_DEFAULT_MERGE_HYSTERESIS;
     tree->origin = origin;
     tree->localToWorld = localToWorld;
     tree->faceId = faceId;
+    tree->mergeFilter = NULL;
+    tree->mergeFilterContext = NULL;
+    Arena_Init(&tree->arena);
     
     BoundingBox3 bounds = {
         (Vector3){ -size, -size, 0 },
         (Vector3){ size, size, 0 }
     };
     
-    tree->root = CreateNode(bounds, localToWorld, size, origin, faceId);
+    // Until the first tiles report, the root is assumed as rough as the terrain gets
+    InitNode(&tree->root, bounds, localToWorld, size, maxDisplacement, origin, faceId, ChunkId_MakeRoot(faceId),
+             maxDisplacement, FLT_MAX);
     
     return tree;
 }
 
-static void InsertRecursive(QuadtreeNode* node, Vector3 cameraPos, float minNodeSize, float comparatorValue, Matrix localToWorld, float planetRadius, Vector3 planetOrigin, QuadtreeSplitCallback onSplit) {
-    float dist = Vector3Distance(node->sphereCenter, cameraPos);
+static void AppendAdded(QuadtreeLeafChanges* changes, QuadtreeNode* node) {
+    if (!changes) return;
+    if (changes->addedCount >= changes->addedCapacity) {
+        changes->addedCapacity = changes->addedCapacity > 0 ? changes->addedCapacity * 2 : 64;
+        changes->added = (QuadtreeNode**)realloc(changes->added, sizeof(QuadtreeNode*) * changes->addedCapacity);
+    }
+    changes->added[changes->addedCount++] = node;
+}
+
+static void AppendRemoved(QuadtreeLeafChanges* changes, QuadtreeNode* node) {
+    if (!changes) return;
+    if (changes->removedCount >= changes->removedCapacity) {
+        changes->removedCapacity = changes->removedCapacity > 0 ? changes->removedCapacity * 2 : 64;
+        changes->removed = (QuadtreeRemovedLeaf*)realloc(changes->removed, sizeof(QuadtreeRemovedLeaf) * changes->removedCapacity);
+    }
+    changes->removed[changes->removedCount].id = node->id;
+    changes->removed[changes->removedCount].userData = node->userData;
+    changes->removedCount++;
+}
+
+// Quadrant of bounds in ChunkId child order ((y << 1) | x)
+static BoundingBox3 GetChildBounds(BoundingBox3 bounds, Vector3 center, int index) {
+    Vector3 min = bounds.min;
+    Vector3 max = bounds.max;
+    switch (index) {
+        case 0: return (BoundingBox3){ min, center }; // Bottom Left
+        case 1: return (BoundingBox3){ (Vector3){ center.x, min.y, 0 }, (Vector3){ max.x, center.y, 0 } }; // Bottom Right
+        case 2: return (BoundingBox3){ (Vector3){ min.x, center.y, 0 }, (Vector3){ center.x, max.y, 0 } }; // Top Left
+        default: return (BoundingBox3){ center, max }; // Top Right
+    }
+}
+
+static void SplitNode(Quadtree* tree, QuadtreeNode* node) {
+    // Allocating may add a page, but existing nodes never move
+    node->firstChild = Arena_AllocGroup(&tree->arena);
+    node->isLeaf = false;
+    QuadtreeNode* children = NodeAt(&tree->arena, node->firstChild);
+
+    float childError = node->geometricError * QUADTREE_ERROR_REFINEMENT;
+    float splitDistance = Quadtree_GetSplitDistance(tree, node);
+    for (int i = 0; i < 4; i++) {
+        InitNode(&children[i], GetChildBounds(node->bounds, node->center, i), tree->localToWorld, tree->size,
+                 tree->maxDisplacement, tree->origin, node->faceId, ChunkId_GetChild(node->id, i),
+                 childError, splitDistance);
+    }
+}
+
+float Quadtree_GetSplitDistance(const Quadtree* tree, const QuadtreeNode* node) {
+    if (tree->errorDistanceScale > 0.0f) {
+        return fminf(node->geometricError * tree->errorDistanceScale,
+                     node->parentSplitDistance * QUADTREE_MAX_SPLIT_RATIO);
+    }
+    return node->size.x * tree->comparatorValue;
+}
+
+void Quadtree_ReportMeshError(Quadtree* tree, ChunkId id, float parentError) {
+    QuadtreeNode* node = Quadtree_FindNode(tree, id);
+    if (!node || node->id != id || parentError < 0.0f) return;
+
+    if (!node->errorMeasured) node->geometricError = parentError * QUADTREE_ERROR_REFINEMENT;
+    if (ChunkId_GetLevel(id) == 0) return;
+    QuadtreeNode* parent = Quadtree_FindNode(tree, ChunkId_GetParent(id));
+    if (parent->errorMeasured) {
+        parent->geometricError = fmaxf(parent->geometricError, parentError);
+    } else {
+        parent->geometricError = parentError;
+        parent->errorMeasured = true;
+    }
+}
+
+BoundingBox3 Quadtree_GetTileBounds(const Quadtree* tree, ChunkId id) {
+    // Same halving as SplitNode, so the bounds match the node's bit for bit
+    BoundingBox3 bounds = tree->root.bounds;
+    int level = ChunkId_GetLevel(id);
+    for (int depth = 1; depth <= level; depth++) {
+        bounds = GetChildBounds(bounds, BoundingBoxCenter(bounds), ChunkId_GetChildIndexAt(id, depth));
+    }
+    return bounds;
+}
+
+// Report every leaf below node as removed and return its groups to the arena
+static void RemoveSubtree(Quadtree* tree, QuadtreeNode* node, QuadtreeLeafChanges* changes) {
+    if (node->isLeaf) {
+        AppendRemoved(changes, node);
+        return;
+    }
+    QuadtreeNode* children = NodeAt(&tree->arena, node->firstChild);
+    for (int i = 0; i < 4; i++) {
+        RemoveSubtree(tree, &children[i], changes);
+    }
+    Arena_FreeGroup(&tree->arena, node->firstChild);
+    node->firstChild = -1;
+    node->isLeaf = true;
+}
+
+static void MergeNode(Quadtree* tree, QuadtreeNode* node, QuadtreeLeafChanges* changes) {
+    RemoveSubtree(tree, node, changes);
+    node->userData = NULL;
+}
+// isNew: node was created during this update and has not been reported yet.
+// A new node that splits straight away is never reported at all.
+static void UpdateRecursive(Quadtree* tree, QuadtreeNode* node, Vector3 cameraPos, bool isNew, QuadtreeLeafChanges* changes,
+                            float parentSplitDistance) {
+    float dist = fmaxf(Vector3Distance(node->sphereCenter, cameraPos) - node->patchRadius, 0.0f);
+    node->parentSplitDistance = parentSplitDistance;
+    float splitDistance = Quadtree_GetSplitDistance(tree, node);
     
-    // Check split condition
-    if (dist < node->size.x * comparatorValue && node->size.x > minNodeSize) {
-        // Split
-        if (node->isLeaf) {
-            if (onSplit) {
-                onSplit(node);
+    if (node->isLeaf) {
+        // Check split condition
+        if (dist < splitDistance && node->size.x > tree->minNodeSize &&
+            ChunkId_GetLevel(node->id) < CHUNK_ID_MAX_LEVEL) {
+            if (!isNew) {
+                AppendRemoved(changes, node);
             }
+            node->userData = NULL;
+            SplitNode(tree, node);
             
-            node->isLeaf = false;
-            Vector3 center = node->center;
-            Vector3 min = node->bounds.min;
-            Vector3 max = node->bounds.max;
-            
-            // Create 4 children
-            // Bottom Left
-            BoundingBox3 b1 = { min, center };
-            // Bottom Right
-            BoundingBox3 b2 = { 
-                (Vector3){ center.x, min.y, 0 },
-                (Vector3){ max.x, center.y, 0 }
-            };
-            // Top Left
-            BoundingBox3 b3 = {
-                (Vector3){ min.x, center.y, 0 },
-                (Vector3){ center.x, max.y, 0 }
-            };
-            // Top Right
-            BoundingBox3 b4 = { center, max };
-            
-            node->children[0] = CreateNode(b1, localToWorld, planetRadius, planetOrigin, node->faceId);
-            node->children[1] = CreateNode(b2, localToWorld, planetRadius, planetOrigin, node->faceId);
-            node->children[2] = CreateNode(b3, localToWorld, planetRadius, planetOrigin, node->faceId);
-            node->children[3] = CreateNode(b4, localToWorld, planetRadius, planetOrigin, node->faceId);
-        }
-        
-        // Recurse
-        for (int i = 0; i < 4; i++) {
-            InsertRecursive(node->children[i], cameraPos, minNodeSize, comparatorValue, localToWorld, planetRadius, planetOrigin, onSplit);
+            QuadtreeNode* children = NodeAt(&tree->arena, node->firstChild);
+            for (int i = 0; i < 4; i++) {
+                UpdateRecursive(tree, &children[i], cameraPos, true, changes, splitDistance);
+            }
+        } else if (isNew) {
+            AppendAdded(changes, node);
         }
+        return;
+    }
+    
+    // Merge only once the camera is clearly past the split distance
+    if (dist >= splitDistance * tree->mergeHysteresis &&
+        (!tree->mergeFilter || tree->mergeFilter(tree, node, tree->mergeFilterContext))) {
+        MergeNode(tree, node, changes);
+        AppendAdded(changes, node);
+        return;
+    }
+    
+    // Recurse
+    QuadtreeNode* children = NodeAt(&tree->arena, node->firstChild);
+    for (int i = 0; i < 4; i++) {
+        UpdateRecursive(tree, &children[i], cameraPos, false, changes, splitDistance);
     }
 }
 
-void Quadtree_Insert(Quadtree* tree, Vector3 cameraPosition, QuadtreeSplitCallback onSplit) {
-    InsertRecursive(tree->root, cameraPosition, tree->minNodeSize, tree->comparatorValue, tree->localToWorld, tree->size, tree->origin, onSplit);
+void Quadtree_Update(Quadtree* tree, Vector3 cameraPosition, QuadtreeLeafChanges* changes) {
+    UpdateRecursive(tree, &tree->root, cameraPosition, false, changes, FLT_MAX);
 }
 
-static void GetLeafNodesRecursive(QuadtreeNode* node, QuadtreeNode*** outNodes, int* outCount, int* capacity) {
+void Quadtree_SplitLeaf(Quadtree* tree, QuadtreeNode* node, QuadtreeLeafChanges* changes) {
+    if (!node->isLeaf) return;
+
+    // Added earlier in this diff: retract it instead of reporting a removal
+    bool wasAdded = false;
+    if (changes) {
+        for (int i = changes->addedCount - 1; i >= 0; i--) {
+            if (changes->added[i] == node) {
+                changes->added[i] = NULL;
+                wasAdded = true;
+                break;
+            }
+        }
+    }
+    if (!wasAdded) {
+        AppendRemoved(changes, node);
+    }
+
+    node->userData = NULL;
+    SplitNode(tree, node);
+    QuadtreeNode* children = NodeAt(&tree->arena, node->firstChild);
+    for (int i = 0; i < 4; i++) {
+        AppendAdded(changes, &children[i]);
+    }
+}
+
+static void GetLeafNodesRecursive(Quadtree* tree, QuadtreeNode* node, QuadtreeNode*** outNodes, int* outCount, int* capacity) {
     if (node->isLeaf) {
         if (*outCount >= *capacity) {
             *capacity *= 2;
@@ -135,8 +343,9 @@ static void GetLeafNodesRecursive(QuadtreeNode* node, QuadtreeNode*** outNodes,
         (*outNodes)[*outCount] = node;
         (*outCount)++;
     } else {
+        QuadtreeNode* children = NodeAt(&tree->arena, node->firstChild);
         for (int i = 0; i < 4; i++) {
-            GetLeafNodesRecursive(node->children[i], outNodes, outCount, capacity);
+            GetLeafNodesRecursive(tree, &children[i], outNodes, outCount, capacity);
         }
     }
 }
@@ -145,10 +354,38 @@ void Quadtree_GetLeafNodes(Quadtree* tree, QuadtreeNode*** outNodes, int* outCou
     int capacity = 128;
     *outNodes = (QuadtreeNode**)malloc(sizeof(QuadtreeNode*) * capacity);
     *outCount = 0;
-    GetLeafNodesRecursive(tree->root, outNodes, outCount, &capacity);
+    GetLeafNodesRecursive(tree, &tree->root, outNodes, outCount, &capacity);
+}
+
+void Quadtree_Reset(Quadtree* tree) {
+    Arena_Reset(&tree->arena);
+    tree->root.firstChild = -1;
+    tree->root.isLeaf = true;
+    tree->root.userData = NULL;
 }
 
 void Quadtree_Free(Quadtree* tree) {
-    FreeNode(tree->root);
+    // Nodes are owned by the arena pages, no tree walk needed
+    Arena_Free(&tree->arena);
     free(tree);
 }
+
+void QuadtreeLeafChanges_Init(QuadtreeLeafChanges* changes) {
+    changes->added = NULL;
+    changes->addedCount = 0;
+    changes->addedCapacity = 0;
+    changes->removed = NULL;
+    changes->removedCount = 0;
+    changes->removedCapacity = 0;
+}
+
+void QuadtreeLeafChanges_Clear(QuadtreeLeafChanges* changes) {
+    changes->addedCount = 0;
+    changes->removedCount = 0;
+}
+
+void QuadtreeLeafChanges_Free(QuadtreeLeafChanges* changes) {
+    free(changes->added);
+    free(changes->removed);
+    QuadtreeLeafChanges_Init(changes);
+}
@@ -11,11 +11,24 @@ CascadedShadowMap* CSM_Create(Vector3 lightDir, int resolution) {
     csm->cascadeSplitLambda = 0.75f; // Favor logarithmic
     csm->nearPlane = 1.0f;
     csm->farPlane = 100000.0f; // 100km
+    csm->moveThreshold = CSM_DEFAULT_MOVE_THRESHOLD;
+    csm->frameIndex = 0;
+    csm->renderedLightDirection = csm->lightDirection;
+
+    // Near cascades every frame, far ones (wide and coarse texels, little
+    // change per frame) on alternating frames
+    const int updateIntervals[CASCADE_COUNT] = { 1, 2, 2, 4 };
 
     // Create shadow map textures
     for (int i = 0; i < CASCADE_COUNT; i++) {
         csm->cascades[i].shadowMap = LoadRenderTexture(resolution, resolution);
+        csm->cascades[i].lightSpaceMatrix = MatrixIdentity();
         csm->cascades[i].splitDistance = 0.0f;
+        csm->cascades[i].bounds = (BoundingBox){ 0 };
+        csm->cascades[i].center = (Vector3){ 0 };
+        csm->cascades[i].orthoSize = 0.0f;
+        csm->cascades[i].updateInterval = updateIntervals[i];
+        csm->cascades[i].dirty = true;
     }
 
     return csm;
@@ -28,6 +41,43 @@ void CSM_Destroy(CascadedShadowMap* csm) {
     free(csm);
 }
 
+// Light view basis, fixed for a light direction (as MatrixLookAt builds it)
+static void GetLightBasis(Vector3 lightDirection, Vector3* right, Vector3* up, Vector3* back) {
+    Vector3 worldUp = fabsf(lightDirection.y) > 0.99f ? (Vector3){1, 0, 0} : (Vector3){0, 1, 0};
+    *back = Vector3Negate(lightDirection);
+    *right = Vector3Normalize(Vector3CrossProduct(worldUp, *back));
+    *up = Vector3CrossProduct(*back, *right);
+}
+
+// Coordinate of a point along a basis axis, in double: world positions are
+// a planet radius away, texels under a meter
+static double GetLightCoordinate(Vector3 axis, Vector3 point) {
+    return (double)axis.x * point.x + (double)axis.y * point.y + (double)axis.z * point.z;
+}
+
+// Rounds a half extent up to a power of CSM_SIZE_STEP
+static float QuantizeCascadeSize(float size) {
+    return powf(CSM_SIZE_STEP, ceilf(logf(size) / logf(CSM_SIZE_STEP)));
+}
+
+bool CSM_IsCascadeDirty(const CascadedShadowMap* csm, int cascade) {
+    return csm->cascades[cascade].dirty;
+}
+
+unsigned int CSM_GetDirtyMask(const CascadedShadowMap* csm) {
+    unsigned int mask = 0;
+    for (int i = 0; i < CASCADE_COUNT; i++) {
+        if (csm->cascades[i].dirty) mask |= 1u << i;
+    }
+    return mask;
+}
+
+void CSM_Invalidate(CascadedShadowMap* csm) {
+    for (int i = 0; i < CASCADE_COUNT; i++) {
+        csm->cascades[i].orthoSize = 0.0f;
+    }
+}
+
 
 void CSM_UpdateCascades(CascadedShadowMap* csm, Camera camera, float planetRadius, float terrainAmplitude, float viewAltitude) {
     // Calculate camera altitude
@@ -61,7 +111,19 @@ void CSM_UpdateCascades(CascadedShadowMap* csm, Camera camera, float planetRadiu
         baseSize * altitudeFactor * 10.0f   // Cascade 3: ~50km
     };
 
+    Vector3 lightDirection = Vector3Normalize(csm->lightDirection);
+    if (Vector3DotProduct(lightDirection, csm->renderedLightDirection) < 0.999999f) {
+        CSM_Invalidate(csm);
+        csm->renderedLightDirection = lightDirection;
+    }
+    Vector3 right, up, back;
+    GetLightBasis(csm->renderedLightDirection, &right, &up, &back);
+    double cameraX = GetLightCoordinate(right, camera.position);
+    double cameraY = GetLightCoordinate(up, camera.position);
+    double cameraZ = GetLightCoordinate(back, camera.position);
+
     for (int i = 0; i < CASCADE_COUNT; i++) {
+        ShadowCascade* cascade = &csm->cascades[i];
         float orthoSize = cascadeSizes[i];
         
         // Add small padding for terrain displacement (10% of max terrain height)
@@ -72,46 +134,71 @@ void CSM_UpdateCascades(CascadedShadowMap* csm, Camera camera, float planetRadiu
         // Allow down to 200m for sharp local shadows
         orthoSize = fmaxf(orthoSize, 200.0f); 
         orthoSize = fminf(orthoSize, planetRadius * 0.8f);
-        
+        orthoSize = QuantizeCascadeSize(orthoSize);
+
+        // Camera drift from the rendered center, in light space
+        double centerX = GetLightCoordinate(right, cascade->center);
+        double centerY = GetLightCoordinate(up, cascade->center);
+        double centerZ = GetLightCoordinate(back, cascade->center);
+        float driftAcross = (float)fmax(fabs(cameraX - centerX), fabs(cameraY - centerY));
+        float driftAlong = (float)fabs(cameraZ - centerZ);
+
+        int interval = cascade->updateInterval > 1 ? cascade->updateInterval : 1;
+        cascade->dirty = cascade->orthoSize != orthoSize ||
+                         fmaxf(driftAcross, driftAlong) > csm->moveThreshold * orthoSize ||
+                         (csm->frameIndex + i) % interval == 0; // Offset by index, so cascades take turns
+
+        if (cascade->dirty) {
+            // Center the shadow map on the camera, snapped to whole texels
+            // across the light (along it only the depth range moves)
+            double texelSize = 2.0 * orthoSize / csm->shadowMapResolution;
+            centerX = floor(cameraX / texelSize + 0.5) * texelSize;
+            centerY = floor(cameraY / texelSize + 0.5) * texelSize;
+            centerZ = cameraZ;
+            cascade->center = Vector3Add(Vector3Add(Vector3Scale(right, (float)centerX), Vector3Scale(up, (float)centerY)),
+                                         Vector3Scale(back, (float)centerZ));
+            cascade->orthoSize = orthoSize;
+
+            // Light view looking at the center along the light direction from
+            // lightDistance away (the MatrixLookAt matrix with the translation
+            // taken from the snapped coordinates, not re-derived in float).
+            // Extra distance accounts for terrain displacement in depth.
+            float lightDistance = orthoSize * 2.0f + maxTerrainHeight * 2.0f;
+            Matrix lightView = {
+                right.x, right.y, right.z, (float)-centerX,
+                up.x, up.y, up.z, (float)-centerY,
+                back.x, back.y, back.z, (float)-(centerZ + lightDistance),
+                0.0f, 0.0f, 0.0f, 1.0f
+            };
+
+            // Orthographic projection centered on camera-focused region
+            // Far plane needs to be extended to cover terrain displacement
+            float farPlane = orthoSize * 4.0f + maxTerrainHeight * 4.0f;
+            Matrix lightProjection = MatrixOrtho(-orthoSize, orthoSize,
+                                                -orthoSize, orthoSize,
+                                                0.1f, farPlane);
+
+            // raymath's MatrixMultiply(a, b) applies a first, so view goes first
+            cascade->lightSpaceMatrix = MatrixMultiply(lightView, lightProjection);
+
+            // Store bounds (simple box around the center)
+            cascade->bounds.min = (Vector3){
+                cascade->center.x - orthoSize,
+                cascade->center.y - orthoSize,
+                cascade->center.z - orthoSize
+            };
+            cascade->bounds.max = (Vector3){
+                cascade->center.x + orthoSize,
+                cascade->center.y + orthoSize,
+                cascade->center.z + orthoSize
+            };
+            driftAcross = (float)fmax(fabs(cameraX - centerX), fabs(cameraY - centerY));
+        }
+
         // Store the split distance (max distance this cascade covers from camera)
-        // This is used by the shader to select the cascade
-        csm->cascades[i].splitDistance = orthoSize;
-        
-        // Center the shadow map on camera position (not frustum slice)
-        Vector3 shadowCenter = camera.position;
-        
-        // Position light relative to shadow center
-        // Add extra distance to account for terrain displacement in depth direction
-        float lightDistance = orthoSize * 2.0f + maxTerrainHeight * 2.0f;
-        Vector3 lightPos = Vector3Add(shadowCenter, 
-                                     Vector3Scale(Vector3Negate(csm->lightDirection), 
-                                                 lightDistance));
-        
-        // Light view matrix - looking at the shadow center
-        Vector3 up = fabsf(csm->lightDirection.y) > 0.99f ? 
-                     (Vector3){1, 0, 0} : (Vector3){0, 1, 0};
-        Matrix lightView = MatrixLookAt(lightPos, shadowCenter, up);
-        
-        // Orthographic projection centered on camera-focused region
-        // Far plane needs to be extended to cover terrain displacement
-        float farPlane = orthoSize * 4.0f + maxTerrainHeight * 4.0f;
-        Matrix lightProjection = MatrixOrtho(-orthoSize, orthoSize, 
-                                            -orthoSize, orthoSize,
-                                            0.1f, farPlane);
-        
-        csm->cascades[i].lightSpaceMatrix = MatrixMultiply(lightProjection, lightView);
-        
-        // Store bounds (simple box around camera)
-        csm->cascades[i].bounds.min = (Vector3){
-            shadowCenter.x - orthoSize,
-            shadowCenter.y - orthoSize,
-            shadowCenter.z - orthoSize
-        };
-        csm->cascades[i].bounds.max = (Vector3){
-            shadowCenter.x + orthoSize,
-            shadowCenter.y + orthoSize,
-            shadowCenter.z + orthoSize
-        };
+        // This is used by the shader to select the cascade: the sphere around
+        // the camera that still fits in the map's square
+        cascade->splitDistance = fmaxf(cascade->orthoSize - driftAcross, 0.0f);
     }
+    csm->frameIndex++;
 }
-
@@ -1,55 +1,137 @@
 #include "thread_pool.h"
+#include "planet_trace.h"
 #include <stdlib.h>
 #include <stdio.h>
 
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#define THREAD_POOL_INITIAL_CAPACITY 1024
+
+// --- Priority heap (caller holds queueMutex) ---
+
+static bool ItemBefore(const WorkItem* a, const WorkItem* b) {
+    if (a->priority != b->priority) return a->priority < b->priority;
+    return a->sequence < b->sequence;
+}
+
+static void HeapSiftUp(WorkItem* heap, int index) {
+    WorkItem item = heap[index];
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (!ItemBefore(&item, &heap[parent])) break;
+        heap[index] = heap[parent];
+        index = parent;
+    }
+    heap[index] = item;
+}
+
+static void HeapSiftDown(WorkItem* heap, int count, int index) {
+    WorkItem item = heap[index];
+    while (true) {
+        int child = index * 2 + 1;
+        if (child >= count) break;
+        if (child + 1 < count && ItemBefore(&heap[child + 1], &heap[child])) child++;
+        if (!ItemBefore(&heap[child], &item)) break;
+        heap[index] = heap[child];
+        index = child;
+    }
+    heap[index] = item;
+}
+
+static void HeapBuild(WorkItem* heap, int count) {
+    for (int i = count / 2 - 1; i >= 0; i--) {
+        HeapSiftDown(heap, count, i);
+    }
+}
+
+static WorkItem HeapPop(ThreadPool* pool) {
+    WorkItem top = pool->workHeap[0];
+    pool->queueSize--;
+    if (pool->queueSize > 0) {
+        pool->workHeap[0] = pool->workHeap[pool->queueSize];
+        HeapSiftDown(pool->workHeap, pool->queueSize, 0);
+    }
+    return top;
+}
+
+// Wake WaitAll callers once the pool has fully drained
+static void NotifyIfDrained(ThreadPool* pool) {
+    if (pool->waitingCount > 0 && pool->queueSize == 0 && pool->activeThreads == 0) {
+        pthread_cond_broadcast(&pool->workComplete);
+    }
+}
+
 // Worker thread function
 static void* ThreadPool_WorkerThread(void* arg) {
     ThreadPool* pool = (ThreadPool*)arg;
+    bool ranJob = false;
+
+    // The lock is taken once per job: finishing the previous job and
+    // dequeuing the next one happen in the same critical section.
+    pthread_mutex_lock(&pool->queueMutex);
+    PLANET_STATS_ONLY(int workerIndex = pool->nextWorkerIndex++);
+    PLANET_TRACE_THREAD_NAME("Worker", workerIndex);
 
     while (true) {
-        pthread_mutex_lock(&pool->queueMutex);
+        if (ranJob) {
+            pool->activeThreads--;
+            NotifyIfDrained(pool);
+            ranJob = false;
+        }
 
         // Wait for work or shutdown signal
-        while (pool->workQueueHead == NULL && !pool->shutdown) {
+        while (pool->queueSize == 0 && !pool->shutdown) {
+            pool->idleThreads++;
             pthread_cond_wait(&pool->workAvailable, &pool->queueMutex);
+            pool->idleThreads--;
         }
 
         // Check if we should shutdown
-        if (pool->shutdown && pool->workQueueHead == NULL) {
-            pthread_mutex_unlock(&pool->queueMutex);
+        if (pool->shutdown && pool->queueSize == 0) {
             break;
         }
 
-        // Get work item from queue
-        WorkItem* item = pool->workQueueHead;
-        if (item != NULL) {
-            pool->workQueueHead = item->next;
-            if (pool->workQueueHead == NULL) {
-                pool->workQueueTail = NULL;
-            }
-            pool->queueSize--;
-            pool->activeThreads++;
-        }
-
-        pthread_mutex_unlock(&pool->queueMutex);
+        // Take the most urgent work item
+        WorkItem item = HeapPop(pool);
+        pool->activeThreads++;
+        ranJob = true;
 
         // Execute work outside of lock
-        if (item != NULL) {
-            item->function(item->data);
-            free(item);
-
-            // Mark thread as no longer active
-            pthread_mutex_lock(&pool->queueMutex);
-            pool->activeThreads--;
-            pthread_cond_signal(&pool->workComplete);
-            pthread_mutex_unlock(&pool->queueMutex);
-        }
+        pthread_mutex_unlock(&pool->queueMutex);
+        PLANET_STATS_ONLY(double jobStart = PlanetStats_Now());
+        item.function(item.data);
+        PLANET_STATS_ONLY(double jobSeconds = PlanetStats_Now() - jobStart);
+        pthread_mutex_lock(&pool->queueMutex);
+        PLANET_STATS_ONLY(pool->workerBusySeconds[workerIndex] += jobSeconds);
     }
 
+    pthread_mutex_unlock(&pool->queueMutex);
     return NULL;
 }
 
+int ThreadPool_GetHardwareConcurrency(void) {
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    int count = (int)info.dwNumberOfProcessors;
+#else
+    int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return count > 0 ? count : 1;
+}
+
 ThreadPool* ThreadPool_Create(int threadCount) {
+    if (threadCount <= 0) {
+        // Leave one hardware thread for the caller (render loop)
+        threadCount = ThreadPool_GetHardwareConcurrency() - 1;
+        if (threadCount < 1) threadCount = 1;
+    }
+
     ThreadPool* pool = (ThreadPool*)malloc(sizeof(ThreadPool));
     if (!pool) {
         return NULL;
@@ -57,11 +139,18 @@ ThreadPool* ThreadPool_Create(int threadCount) {
 
     pool->threadCount = threadCount;
     pool->threads = (pthread_t*)malloc(sizeof(pthread_t) * threadCount);
-    pool->workQueueHead = NULL;
-    pool->workQueueTail = NULL;
+    pool->heapCapacity = THREAD_POOL_INITIAL_CAPACITY;
+    pool->workHeap = (WorkItem*)malloc(sizeof(WorkItem) * pool->heapCapacity);
     pool->queueSize = 0;
+    pool->nextSequence = 0;
     pool->shutdown = false;
     pool->activeThreads = 0;
+    pool->idleThreads = 0;
+    pool->waitingCount = 0;
+#ifdef PLANET_ENABLE_STATS
+    pool->workerBusySeconds = (double*)calloc(threadCount, sizeof(double));
+    pool->nextWorkerIndex = 0;
+#endif
 
     pthread_mutex_init(&pool->queueMutex, NULL);
     pthread_cond_init(&pool->workAvailable, NULL);
@@ -72,6 +161,7 @@ ThreadPool* ThreadPool_Create(int threadCount) {
         if (pthread_create(&pool->threads[i], NULL, ThreadPool_WorkerThread, pool) != 0) {
             fprintf(stderr, "Failed to create thread %d\n", i);
             // Cleanup and return NULL
+            pool->threadCount = i;
             ThreadPool_Destroy(pool);
             return NULL;
         }
@@ -80,25 +170,68 @@ ThreadPool* ThreadPool_Create(int threadCount) {
     return pool;
 }
 
-void ThreadPool_Enqueue(ThreadPool* pool, WorkFunction function, void* data) {
-    WorkItem* item = (WorkItem*)malloc(sizeof(WorkItem));
+void ThreadPool_EnqueueWithPriority(ThreadPool* pool, WorkFunction function, void* data, float priority) {
+    pthread_mutex_lock(&pool->queueMutex);
+
+    // Grow the preallocated slots only when a burst exceeds them
+    if (pool->queueSize >= pool->heapCapacity) {
+        pool->heapCapacity *= 2;
+        pool->workHeap = (WorkItem*)realloc(pool->workHeap, sizeof(WorkItem) * pool->heapCapacity);
+    }
+
+    WorkItem* item = &pool->workHeap[pool->queueSize];
     item->function = function;
     item->data = data;
-    item->next = NULL;
+    item->priority = priority;
+    item->sequence = pool->nextSequence++;
+    HeapSiftUp(pool->workHeap, pool->queueSize);
+    pool->queueSize++;
+
+    // Only wake a worker if one is actually sleeping
+    if (pool->idleThreads > 0) {
+        pthread_cond_signal(&pool->workAvailable);
+    }
+
+    pthread_mutex_unlock(&pool->queueMutex);
+}
+
+void ThreadPool_Enqueue(ThreadPool* pool, WorkFunction function, void* data) {
+    ThreadPool_EnqueueWithPriority(pool, function, data, 0.0f);
+}
+
+bool ThreadPool_Cancel(ThreadPool* pool, void* data) {
+    bool removed = false;
 
     pthread_mutex_lock(&pool->queueMutex);
 
-    // Add to queue
-    if (pool->workQueueTail != NULL) {
-        pool->workQueueTail->next = item;
-    } else {
-        pool->workQueueHead = item;
+    // Compact the heap without the cancelled items, then restore order
+    int kept = 0;
+    for (int i = 0; i < pool->queueSize; i++) {
+        if (pool->workHeap[i].data == data) {
+            removed = true;
+        } else {
+            pool->workHeap[kept++] = pool->workHeap[i];
+        }
+    }
+    if (removed) {
+        pool->queueSize = kept;
+        HeapBuild(pool->workHeap, pool->queueSize);
+        // WaitAll may be blocked on a queue that just became empty
+        NotifyIfDrained(pool);
     }
-    pool->workQueueTail = item;
-    pool->queueSize++;
 
-    // Signal that work is available
-    pthread_cond_signal(&pool->workAvailable);
+    pthread_mutex_unlock(&pool->queueMutex);
+    return removed;
+}
+
+void ThreadPool_Reprioritize(ThreadPool* pool, WorkPriorityFunction priorityFn, void* context) {
+    pthread_mutex_lock(&pool->queueMutex);
+
+    for (int i = 0; i < pool->queueSize; i++) {
+        WorkItem* item = &pool->workHeap[i];
+        item->priority = priorityFn(item->data, context);
+    }
+    HeapBuild(pool->workHeap, pool->queueSize);
 
     pthread_mutex_unlock(&pool->queueMutex);
 }
@@ -107,9 +240,11 @@ void ThreadPool_WaitAll(ThreadPool* pool) {
     pthread_mutex_lock(&pool->queueMutex);
 
     // Wait until queue is empty and no threads are active
+    pool->waitingCount++;
     while (pool->queueSize > 0 || pool->activeThreads > 0) {
         pthread_cond_wait(&pool->workComplete, &pool->queueMutex);
     }
+    pool->waitingCount--;
 
     pthread_mutex_unlock(&pool->queueMutex);
 }
@@ -128,6 +263,21 @@ int ThreadPool_GetActiveThreads(ThreadPool* pool) {
     return active;
 }
 
+int ThreadPool_GetBusySeconds(ThreadPool* pool, double* seconds, int maxWorkers) {
+#ifdef PLANET_ENABLE_STATS
+    int count = pool->threadCount < maxWorkers ? pool->threadCount : maxWorkers;
+    pthread_mutex_lock(&pool->queueMutex);
+    for (int i = 0; i < count; i++) seconds[i] = pool->workerBusySeconds[i];
+    pthread_mutex_unlock(&pool->queueMutex);
+    return count;
+#else
+    (void)pool;
+    (void)seconds;
+    (void)maxWorkers;
+    return 0;
+#endif
+}
+
 void ThreadPool_Destroy(ThreadPool* pool) {
     if (!pool) {
         return;
@@ -144,18 +294,14 @@ void ThreadPool_Destroy(ThreadPool* pool) {
         pthread_join(pool->threads[i], NULL);
     }
 
-    // Clean up remaining work items
-    WorkItem* item = pool->workQueueHead;
-    while (item != NULL) {
-        WorkItem* next = item->next;
-        free(item);
-        item = next;
-    }
-
     pthread_mutex_destroy(&pool->queueMutex);
     pthread_cond_destroy(&pool->workAvailable);
     pthread_cond_destroy(&pool->workComplete);
 
+    free(pool->workHeap);
     free(pool->threads);
+#ifdef PLANET_ENABLE_STATS
+    free(pool->workerBusySeconds);
+#endif
     free(pool);
 }
@@ -0,0 +1,530 @@
+#include "tile_cache.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// --- Parameter hash ---
+
+// FNV-1a over the raw bytes of each parameter
+static unsigned long long HashBytes(unsigned long long hash, const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+unsigned long long TileCache_HashParams(float radius, float terrainFrequency, float terrainAmplitude) {
+    unsigned int version = TILE_CACHE_FORMAT_VERSION;
+    unsigned long long hash = 0xCBF29CE484222325ULL;
+    hash = HashBytes(hash, &version, sizeof(version));
+    hash = HashBytes(hash, &radius, sizeof(radius));
+    hash = HashBytes(hash, &terrainFrequency, sizeof(terrainFrequency));
+    hash = HashBytes(hash, &terrainAmplitude, sizeof(terrainAmplitude));
+    return hash;
+}
+
+// splitmix64 finalizer, as for the chunk map
+static unsigned int MixKey(ChunkId id, int resolution) {
+    unsigned long long key = id ^ ((unsigned long long)resolution * 0x9E3779B97F4A7C15ULL);
+    key ^= key >> 30;
+    key *= 0xBF58476D1CE4E5B9ULL;
+    key ^= key >> 27;
+    key *= 0x94D049BB133111EBULL;
+    key ^= key >> 31;
+    return (unsigned int)key;
+}
+
+// --- File store ---
+// One mapped file, laid out as
+//   TileStoreHeader
+//   index   indexCapacity TileStoreIndexEntry, linear probing on the tile key
+//   records recordCapacity records of recordSize bytes, filled in order
+// Each record is a TileStoreRecord followed by sampleCount unorm16 samples
+// over [minimum, minimum + 65535 * scale]. Lookups probe only the compact
+// index and then touch a single record, so paging in a tile reads little
+// more than the tile itself. Records are appended until the file is full,
+// after which new tiles are no longer stored (rewriting a stored tile
+// still works). New files are zero-filled: used = 0 marks an empty entry,
+// and the record pages of a partly filled file stay sparse.
+
+#define TILE_STORE_MAGIC "PLTILES"
+#define TILE_STORE_MAX_TILES (1u << 30) // Keeps the index capacity in 32 bits
+
+typedef struct TileStoreHeader {
+    char magic[8];
+    unsigned int version;
+    int resolution;
+    unsigned long long paramsHash;
+    unsigned int sampleCount;
+    unsigned int recordCapacity;
+    unsigned int indexCapacity; // Power of two, at least twice recordCapacity
+    unsigned int recordCount;   // Records in use, grows as tiles are written
+} TileStoreHeader;
+
+typedef struct TileStoreIndexEntry {
+    ChunkId id;
+    unsigned int record;
+    unsigned int used;
+} TileStoreIndexEntry;
+
+typedef struct TileStoreRecord {
+    float minimum;
+    float scale;
+} TileStoreRecord;
+
+struct TileCacheStore {
+    unsigned char* data; // Mapped file
+    size_t size;
+    TileStoreHeader* header;
+    TileStoreIndexEntry* index;
+    unsigned char* records;
+    int resolution;
+    int sampleCount;
+    unsigned int recordCapacity;
+    size_t recordSize;
+    bool writable; // False for a read-only file: lookups only
+#if defined(_WIN32)
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+};
+
+static unsigned int GetStoreIndexCapacity(unsigned int recordCapacity) {
+    unsigned int capacity = 16;
+    while (capacity < 2ULL * recordCapacity) capacity *= 2;
+    return capacity;
+}
+
+static size_t GetStoreSize(const TileCacheStore* store, unsigned int recordCapacity) {
+    return sizeof(TileStoreHeader) +
+           (size_t)GetStoreIndexCapacity(recordCapacity) * sizeof(TileStoreIndexEntry) +
+           (size_t)recordCapacity * store->recordSize;
+}
+
+// An existing file matches when its layout agrees with expected (except for
+// the capacity, which it keeps) and its size fits that capacity
+static bool StoreHeaderMatches(const TileCacheStore* store, const TileStoreHeader* header,
+                               const TileStoreHeader* expected, unsigned long long fileSize) {
+    return memcmp(header->magic, expected->magic, sizeof(header->magic)) == 0 &&
+           header->version == expected->version && header->resolution == expected->resolution &&
+           header->paramsHash == expected->paramsHash && header->sampleCount == expected->sampleCount &&
+           header->recordCapacity > 0 && header->recordCapacity <= TILE_STORE_MAX_TILES &&
+           header->recordCount <= header->recordCapacity &&
+           header->indexCapacity == GetStoreIndexCapacity(header->recordCapacity) &&
+           fileSize == GetStoreSize(store, header->recordCapacity);
+}
+
+// Maps the file at path, read-write if possible, otherwise read-only. A
+// matching file keeps its capacity. Anything else is cleared and resized
+// for store->recordCapacity tiles (*fresh), which needs write access and a
+// capacity; without one only an existing file is opened.
+static bool MapStoreFile(TileCacheStore* store, const char* path, const TileStoreHeader* expected, bool* fresh) {
+    TileStoreHeader header = { 0 };
+    unsigned long long fileSize = 0;
+#if defined(_WIN32)
+    store->writable = true;
+    bool create = store->recordCapacity > 0;
+    store->file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL,
+                              create ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (store->file == INVALID_HANDLE_VALUE) {
+        store->writable = false;
+        store->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (store->file == INVALID_HANDLE_VALUE) return false;
+    }
+
+    DWORD bytesRead = 0;
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(store->file, &size)) fileSize = (unsigned long long)size.QuadPart;
+    bool readable = ReadFile(store->file, &header, sizeof(header), &bytesRead, NULL) && bytesRead == sizeof(header);
+    *fresh = !readable || !StoreHeaderMatches(store, &header, expected, fileSize);
+    if (*fresh) {
+        if (!store->writable || !create) {
+            CloseHandle(store->file);
+            return false;
+        }
+        // Truncate, then let the mapping extend the file with zeros
+        LARGE_INTEGER zero = { 0 };
+        SetFilePointerEx(store->file, zero, NULL, FILE_BEGIN);
+        SetEndOfFile(store->file);
+    } else {
+        store->recordCapacity = header.recordCapacity;
+    }
+    store->size = GetStoreSize(store, store->recordCapacity);
+
+    unsigned long long mapSize = store->size;
+    store->mapping = CreateFileMappingA(store->file, NULL, store->writable ? PAGE_READWRITE : PAGE_READONLY,
+                                        (DWORD)(mapSize >> 32), (DWORD)(mapSize & 0xFFFFFFFFULL), NULL);
+    if (!store->mapping) {
+        CloseHandle(store->file);
+        return false;
+    }
+    store->data = (unsigned char*)MapViewOfFile(store->mapping, store->writable ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ,
+                                                0, 0, store->size);
+    if (!store->data) {
+        CloseHandle(store->mapping);
+        CloseHandle(store->file);
+        return false;
+    }
+#else
+    store->writable = true;
+    bool create = store->recordCapacity > 0;
+    store->fd = open(path, create ? O_RDWR | O_CREAT : O_RDWR, 0644);
+    if (store->fd < 0) {
+        store->writable = false;
+        store->fd = open(path, O_RDONLY);
+        if (store->fd < 0) return false;
+    }
+
+    struct stat info;
+    if (fstat(store->fd, &info) == 0) fileSize = (unsigned long long)info.st_size;
+    bool readable = pread(store->fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header);
+    *fresh = !readable || !StoreHeaderMatches(store, &header, expected, fileSize);
+    if (!*fresh) store->recordCapacity = header.recordCapacity;
+    store->size = GetStoreSize(store, store->recordCapacity);
+
+    // Truncating first makes the extension read back as zeros (sparse file)
+    if (*fresh && (!store->writable || !create || ftruncate(store->fd, 0) != 0 || ftruncate(store->fd, (off_t)store->size) != 0)) {
+        close(store->fd);
+        return false;
+    }
+
+    void* data = mmap(NULL, store->size, store->writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                      MAP_SHARED, store->fd, 0);
+    if (data == MAP_FAILED) {
+        close(store->fd);
+        return false;
+    }
+    store->data = (unsigned char*)data;
+#endif
+    store->header = (TileStoreHeader*)store->data;
+    store->index = (TileStoreIndexEntry*)(store->data + sizeof(TileStoreHeader));
+    store->records = (unsigned char*)(store->index + GetStoreIndexCapacity(store->recordCapacity));
+    return true;
+}
+
+static void UnmapStoreFile(TileCacheStore* store) {
+#if defined(_WIN32)
+    UnmapViewOfFile(store->data);
+    CloseHandle(store->mapping);
+    CloseHandle(store->file);
+#else
+    munmap(store->data, store->size);
+    close(store->fd);
+#endif
+}
+
+// Index entry holding id, or the empty entry where its probe ends. The
+// index we write is at most half full; a damaged one with no empty entry
+// ends the probe after one lap (NULL).
+static TileStoreIndexEntry* FindStoreEntry(TileCacheStore* store, ChunkId id) {
+    unsigned int mask = store->header->indexCapacity - 1;
+    unsigned int slot = MixKey(id, store->resolution) & mask;
+    for (unsigned int probe = 0; store->index[slot].used && store->index[slot].id != id; probe++) {
+        if (probe == mask) return NULL;
+        slot = (slot + 1) & mask;
+    }
+    return &store->index[slot];
+}
+
+// A damaged or foreign file can hold entries past the records in use: those
+// are misses, and are never written through
+static bool IsStoreEntryValid(const TileCacheStore* store, const TileStoreIndexEntry* entry) {
+    return entry->record < store->header->recordCount;
+}
+
+static TileStoreRecord* GetStoreRecord(TileCacheStore* store, unsigned int record) {
+    return (TileStoreRecord*)(store->records + record * store->recordSize);
+}
+
+static void StoreWrite(TileCacheStore* store, ChunkId id, const float* heights) {
+    TileStoreIndexEntry* entry = FindStoreEntry(store, id);
+    TileStoreHeader* header = store->header;
+    if (!entry) return;
+    if (!entry->used && header->recordCount >= header->recordCapacity) return; // Full
+    if (entry->used && !IsStoreEntryValid(store, entry)) return;
+
+    unsigned int index = entry->used ? entry->record : header->recordCount;
+    TileStoreRecord* record = GetStoreRecord(store, index);
+    unsigned short* samples = (unsigned short*)(record + 1);
+
+    float minimum = heights[0], maximum = heights[0];
+    for (int i = 1; i < store->sampleCount; i++) {
+        minimum = heights[i] < minimum ? heights[i] : minimum;
+        maximum = heights[i] > maximum ? heights[i] : maximum;
+    }
+    float scale = maximum > minimum ? (maximum - minimum) / 65535.0f : 0.0f;
+    float inv = scale > 0.0f ? 1.0f / scale : 0.0f;
+
+    record->minimum = minimum;
+    record->scale = scale;
+    for (int i = 0; i < store->sampleCount; i++) {
+        float q = (heights[i] - minimum) * inv + 0.5f;
+        samples[i] = (unsigned short)(q < 65535.0f ? q : 65535.0f);
+    }
+
+    // Publish the index entry only once its record is written
+    if (!entry->used) {
+        header->recordCount++;
+        entry->id = id;
+        entry->record = index;
+        entry->used = 1;
+    }
+}
+
+static bool StoreRead(TileCacheStore* store, ChunkId id, float* heights) {
+    const TileStoreIndexEntry* entry = FindStoreEntry(store, id);
+    if (!entry || !entry->used || !IsStoreEntryValid(store, entry)) return false;
+
+    const TileStoreRecord* record = GetStoreRecord(store, entry->record);
+    const unsigned short* samples = (const unsigned short*)(record + 1);
+    for (int i = 0; i < store->sampleCount; i++) {
+        heights[i] = record->minimum + samples[i] * record->scale;
+    }
+    return true;
+}
+
+bool TileCache_OpenStore(TileCache* cache, const char* path, int resolution, int sampleCount, int maxTiles) {
+    if (sampleCount <= 0 || maxTiles < 0 || (unsigned int)maxTiles > TILE_STORE_MAX_TILES) return false;
+
+    TileCacheStore* store = (TileCacheStore*)calloc(1, sizeof(TileCacheStore));
+    store->resolution = resolution;
+    store->sampleCount = sampleCount;
+    store->recordCapacity = (unsigned int)maxTiles;
+    // Keep records 8-byte aligned
+    store->recordSize = (sizeof(TileStoreRecord) + sampleCount * sizeof(unsigned short) + 7) & ~(size_t)7;
+
+    TileStoreHeader expected = { 0 };
+    memcpy(expected.magic, TILE_STORE_MAGIC, sizeof(TILE_STORE_MAGIC));
+    expected.version = TILE_CACHE_FORMAT_VERSION;
+    expected.resolution = resolution;
+    expected.paramsHash = cache->paramsHash;
+    expected.sampleCount = (unsigned int)sampleCount;
+
+    bool fresh = false;
+    if (!MapStoreFile(store, path, &expected, &fresh)) {
+        fprintf(stderr, "TileCache: could not map %s, using memory only\n", path);
+        free(store);
+        return false;
+    }
+    if (fresh) {
+        expected.recordCapacity = store->recordCapacity;
+        expected.indexCapacity = GetStoreIndexCapacity(store->recordCapacity);
+        memcpy(store->data, &expected, sizeof(expected));
+    }
+
+    pthread_mutex_lock(&cache->mutex);
+    if (cache->store) {
+        UnmapStoreFile(cache->store);
+        free(cache->store);
+    }
+    cache->store = store;
+    pthread_mutex_unlock(&cache->mutex);
+    return true;
+}
+
+int TileCache_GetStoredCount(TileCache* cache) {
+    pthread_mutex_lock(&cache->mutex);
+    int count = cache->store ? (int)cache->store->header->recordCount : 0;
+    pthread_mutex_unlock(&cache->mutex);
+    return count;
+}
+
+// --- Memory LRU (caller holds mutex) ---
+
+static void AllocateMemorySlots(TileCache* cache, int capacity) {
+    cache->slotCapacity = capacity;
+    cache->slots = (int*)malloc(sizeof(int) * capacity);
+    for (int i = 0; i < capacity; i++) {
+        cache->slots[i] = -1;
+    }
+}
+
+// Slot holding the key, or the empty slot where the probe ended
+static int FindMemorySlot(const TileCache* cache, ChunkId id, int resolution) {
+    int mask = cache->slotCapacity - 1;
+    int index = (int)(MixKey(id, resolution) & mask);
+    while (cache->slots[index] >= 0) {
+        const TileCacheEntry* entry = &cache->entries[cache->slots[index]];
+        if (entry->id == id && entry->resolution == resolution) return index;
+        index = (index + 1) & mask;
+    }
+    return index;
+}
+
+static void UnlinkEntry(TileCache* cache, int index) {
+    TileCacheEntry* entry = &cache->entries[index];
+    if (entry->prev >= 0) cache->entries[entry->prev].next = entry->next;
+    else cache->newest = entry->next;
+    if (entry->next >= 0) cache->entries[entry->next].prev = entry->prev;
+    else cache->oldest = entry->prev;
+}
+
+static void LinkNewest(TileCache* cache, int index) {
+    TileCacheEntry* entry = &cache->entries[index];
+    entry->prev = -1;
+    entry->next = cache->newest;
+    if (cache->newest >= 0) cache->entries[cache->newest].prev = index;
+    cache->newest = index;
+    if (cache->oldest < 0) cache->oldest = index;
+}
+
+static void RemoveEntry(TileCache* cache, int index) {
+    TileCacheEntry* entry = &cache->entries[index];
+
+    // Backward-shift deletion keeps every probe chain unbroken
+    int mask = cache->slotCapacity - 1;
+    int hole = FindMemorySlot(cache, entry->id, entry->resolution);
+    for (int next = (hole + 1) & mask; cache->slots[next] >= 0; next = (next + 1) & mask) {
+        const TileCacheEntry* moved = &cache->entries[cache->slots[next]];
+        int home = (int)(MixKey(moved->id, moved->resolution) & mask);
+        // Move it into the hole unless its home lies cyclically in (hole, next]
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            cache->slots[hole] = cache->slots[next];
+            hole = next;
+        }
+    }
+    cache->slots[hole] = -1;
+
+    UnlinkEntry(cache, index);
+    cache->memoryBytes -= entry->count * sizeof(float);
+    free(entry->heights);
+    entry->heights = NULL;
+    entry->next = cache->freeEntry;
+    cache->freeEntry = index;
+    cache->count--;
+}
+
+static int AllocateEntry(TileCache* cache) {
+    if (cache->freeEntry < 0) {
+        int oldCapacity = cache->entryCapacity;
+        cache->entryCapacity *= 2;
+        cache->entries = (TileCacheEntry*)realloc(cache->entries, sizeof(TileCacheEntry) * cache->entryCapacity);
+        for (int i = cache->entryCapacity - 1; i >= oldCapacity; i--) {
+            cache->entries[i].heights = NULL;
+            cache->entries[i].next = cache->freeEntry;
+            cache->freeEntry = i;
+        }
+
+        // Rehash into a table twice the entry capacity
+        free(cache->slots);
+        AllocateMemorySlots(cache, cache->entryCapacity * 2);
+        for (int i = cache->newest; i >= 0; i = cache->entries[i].next) {
+            cache->slots[FindMemorySlot(cache, cache->entries[i].id, cache->entries[i].resolution)] = i;
+        }
+    }
+
+    int index = cache->freeEntry;
+    cache->freeEntry = cache->entries[index].next;
+    return index;
+}
+
+static void MemoryPut(TileCache* cache, ChunkId id, int resolution, const float* heights, int count) {
+    size_t bytes = count * sizeof(float);
+    if (bytes > cache->memoryBudget) return;
+
+    int slot = FindMemorySlot(cache, id, resolution);
+    if (cache->slots[slot] >= 0) RemoveEntry(cache, cache->slots[slot]);
+    while (cache->count > 0 && cache->memoryBytes + bytes > cache->memoryBudget) {
+        RemoveEntry(cache, cache->oldest);
+    }
+
+    int index = AllocateEntry(cache); // May rehash, so find the slot afterwards
+    TileCacheEntry* entry = &cache->entries[index];
+    entry->id = id;
+    entry->resolution = resolution;
+    entry->count = count;
+    entry->heights = (float*)malloc(bytes);
+    memcpy(entry->heights, heights, bytes);
+    cache->slots[FindMemorySlot(cache, id, resolution)] = index;
+    LinkNewest(cache, index);
+    cache->memoryBytes += bytes;
+    cache->count++;
+}
+
+// --- Public API ---
+
+TileCache* TileCache_Create(unsigned long long paramsHash, size_t memoryBudgetBytes) {
+    TileCache* cache = (TileCache*)calloc(1, sizeof(TileCache));
+    cache->paramsHash = paramsHash;
+    cache->memoryBudget = memoryBudgetBytes;
+    pthread_mutex_init(&cache->mutex, NULL);
+
+    cache->entryCapacity = 64;
+    cache->entries = (TileCacheEntry*)calloc(cache->entryCapacity, sizeof(TileCacheEntry));
+    cache->freeEntry = -1;
+    for (int i = cache->entryCapacity - 1; i >= 0; i--) {
+        cache->entries[i].next = cache->freeEntry;
+        cache->freeEntry = i;
+    }
+    AllocateMemorySlots(cache, cache->entryCapacity * 2);
+    cache->newest = -1;
+    cache->oldest = -1;
+    return cache;
+}
+
+bool TileCache_Get(TileCache* cache, ChunkId id, int resolution, float* heights, int count) {
+    pthread_mutex_lock(&cache->mutex);
+
+    int slot = FindMemorySlot(cache, id, resolution);
+    int index = cache->slots[slot];
+    if (index >= 0 && cache->entries[index].count == count) {
+        memcpy(heights, cache->entries[index].heights, count * sizeof(float));
+        UnlinkEntry(cache, index);
+        LinkNewest(cache, index);
+        cache->memoryHits++;
+        pthread_mutex_unlock(&cache->mutex);
+        return true;
+    }
+
+    TileCacheStore* store = cache->store;
+    if (store && store->resolution == resolution && store->sampleCount == count && StoreRead(store, id, heights)) {
+        MemoryPut(cache, id, resolution, heights, count);
+        cache->storeHits++;
+        pthread_mutex_unlock(&cache->mutex);
+        return true;
+    }
+
+    cache->misses++;
+    pthread_mutex_unlock(&cache->mutex);
+    return false;
+}
+
+void TileCache_Put(TileCache* cache, ChunkId id, int resolution, const float* heights, int count) {
+    pthread_mutex_lock(&cache->mutex);
+    MemoryPut(cache, id, resolution, heights, count);
+    TileCacheStore* store = cache->store;
+    if (store && store->writable && store->resolution == resolution && store->sampleCount == count) {
+        StoreWrite(store, id, heights);
+    }
+    pthread_mutex_unlock(&cache->mutex);
+}
+
+void TileCache_Destroy(TileCache* cache) {
+    if (!cache) return;
+    for (int i = 0; i < cache->entryCapacity; i++) {
+        free(cache->entries[i].heights);
+    }
+    free(cache->entries);
+    free(cache->slots);
+    if (cache->store) {
+        UnmapStoreFile(cache->store);
+        free(cache->store);
+    }
+    pthread_mutex_destroy(&cache->mutex);
+    free(cache);
+}
@@ -0,0 +1,55 @@
+// Regression tests for the chunk pool and upload queue lifetimes. Headless:
+// no window or GL context, nothing here uploads. Run through ctest; build
+// with ENABLE_ASAN to catch the use-after-free directly.
+
+#include "chunk.h"
+#include "chunk_utils.h"
+#include <raymath.h>
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(condition) do { \
+    if (!(condition)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        failures++; \
+    } \
+} while (0)
+
+static Chunk* CreateTestChunk(void) {
+    return Chunk_Create((Vector3){ 0.0f, 0.0f, 0.0f }, 1000.0f, 1000.0f, 1737400.0f, 8,
+                        (Vector3){ 0.0f, 0.0f, 0.0f }, MatrixIdentity(), 18.0f, 0.005f);
+}
+
+// A chunk whose mesh was posted, then retired before the upload, must leave
+// the queue when the CPU budget frees it: the next Process would otherwise
+// lock the freed chunk's mutex to check its epoch
+static void Test_EvictedChunkLeavesUploadQueue(void) {
+    ChunkPool* pool = ChunkPool_Create(1, 0);
+    ChunkUploadQueue* queue = ChunkUploadQueue_Create(4);
+    pool->uploadQueue = queue;
+
+    Chunk* chunk = CreateTestChunk();
+    chunk->state = CHUNK_STATE_READY_TO_UPLOAD;
+    ChunkUploadQueue_Push(queue, chunk, chunk->epoch);
+
+    ChunkPool_Release(pool, chunk);
+    CHECK(pool->cpuEvictions == 1);
+    CHECK(ChunkUploadQueue_GetPendingCount(queue) == 0);
+
+    // Nothing left to check against the freed chunk, or to upload
+    CHECK(ChunkUploadQueue_Process(queue, (Vector3){ 0.0f, 0.0f, 0.0f }, 0.0, 0) == 0);
+
+    ChunkUploadQueue_Destroy(queue);
+    ChunkPool_Destroy(pool);
+}
+
+int main(void) {
+    Test_EvictedChunkLeavesUploadQueue();
+    if (failures > 0) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("chunk_pool_test: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,235 @@
+// Offline baker for fixed planets: generates the terrain samples of every
+// tile down to a quadtree level, on all cores, and writes them to a tile
+// store. At runtime Planet_OpenTileStore maps the file and tiles are paged
+// in on demand instead of running MoonTerrain. Tiles go through the same
+// chunk pipeline the renderer uses, so the stored samples are exactly the
+// ones the renderer would generate. Needs no window or GL context.
+//
+//   planet_bake --output <file> [--levels <n>] [--radius <r>] [--resolution <n>]
+//               [--frequency <f>] [--amplitude <a>] [--threads <n>]
+//
+// radius, resolution, frequency and amplitude must match the Planet_Create
+// call of the runtime, otherwise the runtime does not accept the file.
+
+#include "chunk.h"
+#include "cubic_quadtree.h"
+#include "noise.h"
+#include "thread_pool.h"
+#include "tile_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Same planet as examples/simple_planet.c
+#define BAKE_DEFAULT_RADIUS 1737400.0f
+#define BAKE_DEFAULT_RESOLUTION 32
+#define BAKE_DEFAULT_TERRAIN_FREQUENCY 18.0f
+#define BAKE_DEFAULT_TERRAIN_AMPLITUDE 0.005f
+#define BAKE_DEFAULT_LEVELS 6
+#define BAKE_MAX_LEVELS 12        // 134M tiles, far past any sensible file
+#define BAKE_TILES_PER_JOB 64
+
+static double BakeTime(void) {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+typedef struct BakeSettings {
+    const char* outputPath;
+    int levels; // Deepest level baked, 0 = face roots only
+    float radius;
+    int resolution;
+    float terrainFrequency;
+    float terrainAmplitude;
+    int threads;
+} BakeSettings;
+
+typedef struct BakeContext {
+    const BakeSettings* settings;
+    CubicQuadTree* faces; // Face transforms and tile bounds only, never subdivided
+    TileCache* cache;     // Store only, no memory budget
+} BakeContext;
+
+// A run of tiles on one face and level, row-major from tile index first
+typedef struct BakeJob {
+    BakeContext* context;
+    int face;
+    int level;
+    unsigned int first;
+    unsigned int count;
+} BakeJob;
+
+static ChunkId GetBakeTileId(int face, int level, unsigned int index) {
+    unsigned int side = 1u << level;
+    return ChunkId_Make(face, level, index % side, index / side);
+}
+
+// Fills a tile's chunk fields exactly as Planet's AttachChunk does
+static void PlaceBakeChunk(const BakeContext* context, Chunk* chunk, ChunkId id) {
+    Quadtree* face = context->faces->faces[ChunkId_GetFace(id)];
+    BoundingBox3 bounds = Quadtree_GetTileBounds(face, id);
+    Vector3 size = BoundingBoxSize(bounds);
+    chunk->offset = bounds.min;
+    chunk->width = size.x;
+    chunk->height = size.y;
+    chunk->localToWorld = face->localToWorld;
+    chunk->id = id;
+}
+
+static void BakeWorker(void* data) {
+    BakeJob* job = (BakeJob*)data;
+    const BakeSettings* settings = job->context->settings;
+
+    Chunk* chunk = Chunk_Create((Vector3){ 0 }, 1.0f, 1.0f, settings->radius, settings->resolution,
+                                (Vector3){ 0 }, MatrixIdentity(),
+                                settings->terrainFrequency, settings->terrainAmplitude);
+    chunk->tileCache = job->context->cache;
+    for (unsigned int i = 0; i < job->count; i++) {
+        PlaceBakeChunk(job->context, chunk, GetBakeTileId(job->face, job->level, job->first + i));
+        Chunk_GenerateAsync(chunk); // Samples land in the store through the cache
+    }
+    Chunk_Free(chunk);
+}
+
+static long long GetBakeTileCount(int levels) {
+    long long count = 0;
+    for (int level = 0; level <= levels; level++) count += 6LL << (2 * level);
+    return count;
+}
+
+// Bakes every level into a store sized for exactly those tiles. Returns the
+// number of tiles that do not read back, or -1 if the file cannot be written.
+static long long BakeStore(const BakeSettings* settings, ThreadPool* pool, long long tileCount) {
+    remove(settings->outputPath); // Never reuse an older file's capacity
+
+    BakeContext context;
+    context.settings = settings;
+    context.faces = CubicQuadTree_Create(settings->radius, 1.0f, 1.0f,
+                                         settings->radius * settings->terrainAmplitude * MOON_TERRAIN_MAX_ABS,
+                                         (Vector3){ 0 });
+    context.cache = TileCache_Create(TileCache_HashParams(settings->radius, settings->terrainFrequency,
+                                                          settings->terrainAmplitude), 0);
+    int sampleCount = Chunk_GetHeightSampleCount(settings->resolution);
+    if (!TileCache_OpenStore(context.cache, settings->outputPath, settings->resolution, sampleCount, (int)tileCount)) {
+        TileCache_Destroy(context.cache);
+        CubicQuadTree_Free(context.faces);
+        return -1;
+    }
+
+    for (int level = 0; level <= settings->levels; level++) {
+        unsigned int tilesPerFace = 1u << (2 * level);
+        int jobCount = 0;
+        BakeJob* jobs = (BakeJob*)malloc(sizeof(BakeJob) * 6 * ((tilesPerFace + BAKE_TILES_PER_JOB - 1) / BAKE_TILES_PER_JOB));
+
+        double start = BakeTime();
+        for (int face = 0; face < 6; face++) {
+            for (unsigned int first = 0; first < tilesPerFace; first += BAKE_TILES_PER_JOB) {
+                BakeJob* job = &jobs[jobCount++];
+                job->context = &context;
+                job->face = face;
+                job->level = level;
+                job->first = first;
+                job->count = tilesPerFace - first < BAKE_TILES_PER_JOB ? tilesPerFace - first : BAKE_TILES_PER_JOB;
+                ThreadPool_Enqueue(pool, BakeWorker, job);
+            }
+        }
+        ThreadPool_WaitAll(pool);
+        double seconds = BakeTime() - start;
+        fprintf(stderr, "planet_bake: level %2d  %9u tiles  %8.2f s  %10.0f tiles/s\n",
+                level, 6 * tilesPerFace, seconds, seconds > 0.0 ? 6 * tilesPerFace / seconds : 0.0);
+        free(jobs);
+    }
+
+    // Sanity check: every tile reads back from the file
+    float* heights = (float*)malloc(sizeof(float) * sampleCount);
+    long long missing = 0;
+    for (int level = 0; level <= settings->levels; level++) {
+        for (int face = 0; face < 6; face++) {
+            for (unsigned int i = 0; i < (1u << (2 * level)); i++) {
+                if (!TileCache_Get(context.cache, GetBakeTileId(face, level, i), settings->resolution, heights, sampleCount)) {
+                    missing++;
+                }
+            }
+        }
+    }
+    free(heights);
+
+    TileCache_Destroy(context.cache);
+    CubicQuadTree_Free(context.faces);
+    return missing;
+}
+
+static void PrintUsage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s --output <file> [--levels <n>] [--radius <r>] [--resolution <n>]\n"
+            "          [--frequency <f>] [--amplitude <a>] [--threads <n>]\n", program);
+}
+
+int main(int argc, char** argv) {
+    BakeSettings settings = {
+        NULL, BAKE_DEFAULT_LEVELS, BAKE_DEFAULT_RADIUS, BAKE_DEFAULT_RESOLUTION,
+        BAKE_DEFAULT_TERRAIN_FREQUENCY, BAKE_DEFAULT_TERRAIN_AMPLITUDE, 0
+    };
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--output") == 0 && hasValue) {
+            settings.outputPath = argv[++i];
+        } else if (strcmp(argv[i], "--levels") == 0 && hasValue) {
+            settings.levels = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--radius") == 0 && hasValue) {
+            settings.radius = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--resolution") == 0 && hasValue) {
+            settings.resolution = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--frequency") == 0 && hasValue) {
+            settings.terrainFrequency = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--amplitude") == 0 && hasValue) {
+            settings.terrainAmplitude = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && hasValue) {
+            settings.threads = atoi(argv[++i]);
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!settings.outputPath || settings.levels < 0 || settings.levels > BAKE_MAX_LEVELS ||
+        settings.resolution < 1 || settings.resolution > CHUNK_MAX_RESOLUTION || settings.radius <= 0.0f) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    long long tileCount = GetBakeTileCount(settings.levels);
+    // All cores: the main thread only waits
+    ThreadPool* pool = ThreadPool_Create(settings.threads > 0 ? settings.threads : ThreadPool_GetHardwareConcurrency());
+    double start = BakeTime();
+    fprintf(stderr, "planet_bake: %lld tiles at resolution %d, levels 0-%d, %d threads, noise kernel %s\n",
+            tileCount, settings.resolution, settings.levels, pool->threadCount,
+            MoonTerrainBatch_KernelName(MoonTerrainBatch_GetKernel()));
+
+    int result = 1;
+    long long missing = BakeStore(&settings, pool, tileCount);
+    if (missing < 0) {
+        fprintf(stderr, "planet_bake: cannot write %s\n", settings.outputPath);
+    } else if (missing > 0) {
+        fprintf(stderr, "planet_bake: %lld tiles missing from %s\n", missing, settings.outputPath);
+    } else {
+        fprintf(stderr, "planet_bake: wrote %s in %.2f s\n", settings.outputPath, BakeTime() - start);
+        result = 0;
+    }
+
+    ThreadPool_Destroy(pool);
+    return result;
+}
@@ -0,0 +1,547 @@
+// Headless benchmarks for the CPU side of the renderer: terrain noise, chunk
+// generation, quadtree updates, the chunk map and thread pool scaling.
+// Needs no window or GL context. Results go to stdout (or --output) as one
+// JSON object so CI can track them over time.
+//
+//   planet_bench [--quick] [--filter <substring>] [--output <file>]
+
+#include "chunk.h"
+#include "chunk_utils.h"
+#include "cubic_quadtree.h"
+#include "noise.h"
+#include "thread_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Same planet as examples/simple_planet.c
+#define BENCH_RADIUS 1737400.0f
+#define BENCH_MIN_CELL_SIZE 500.0f
+#define BENCH_COMPARATOR 1.5f
+#define BENCH_TERRAIN_FREQUENCY 18.0f
+#define BENCH_TERRAIN_AMPLITUDE 0.005f
+
+// --- Timing and statistics ---
+
+static double BenchTime(void) {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+typedef struct BenchSamples {
+    double* values;
+    int count;
+    int capacity;
+} BenchSamples;
+
+static void BenchSamples_Init(BenchSamples* samples) {
+    samples->count = 0;
+    samples->capacity = 64;
+    samples->values = (double*)malloc(sizeof(double) * samples->capacity);
+}
+
+static void BenchSamples_Add(BenchSamples* samples, double value) {
+    if (samples->count >= samples->capacity) {
+        samples->capacity *= 2;
+        samples->values = (double*)realloc(samples->values, sizeof(double) * samples->capacity);
+    }
+    samples->values[samples->count++] = value;
+}
+
+static void BenchSamples_Free(BenchSamples* samples) {
+    free(samples->values);
+    samples->values = NULL;
+    samples->count = samples->capacity = 0;
+}
+
+static int CompareDoubles(const void* a, const void* b) {
+    double da = *(const double*)a;
+    double db = *(const double*)b;
+    return (da > db) - (da < db);
+}
+
+// Nearest-rank percentile of sorted values
+static double Percentile(const double* sorted, int count, double p) {
+    int rank = (int)(p / 100.0 * count + 0.999999);
+    if (rank < 1) rank = 1;
+    if (rank > count) rank = count;
+    return sorted[rank - 1];
+}
+
+// Extra per-benchmark numbers reported next to the statistics
+typedef struct BenchMetric {
+    const char* name;
+    double value;
+} BenchMetric;
+
+typedef struct BenchContext {
+    FILE* out;
+    const char* filter;
+    bool quick;
+    int reported;
+} BenchContext;
+
+static bool Bench_ShouldRun(const BenchContext* ctx, const char* name) {
+    return !ctx->filter || strstr(name, ctx->filter) != NULL;
+}
+
+// One entry of the "benchmarks" array. throughputScale converts the median
+// into the throughput figure (e.g. 1e9 for ns per item -> items per second),
+// 0 omits it.
+static void Bench_Report(BenchContext* ctx, const char* name, const char* unit, BenchSamples* samples,
+                         double throughputScale, const char* throughputUnit,
+                         const BenchMetric* metrics, int metricCount) {
+    if (samples->count == 0) return;
+    qsort(samples->values, samples->count, sizeof(double), CompareDoubles);
+
+    double sum = 0.0;
+    for (int i = 0; i < samples->count; i++) sum += samples->values[i];
+    double median = Percentile(samples->values, samples->count, 50.0);
+
+    FILE* out = ctx->out;
+    fprintf(out, "%s\n    {\"name\": \"%s\", \"unit\": \"%s\", \"samples\": %d", ctx->reported ? "," : "", name, unit, samples->count);
+    fprintf(out, ", \"median\": %.6g, \"p90\": %.6g, \"p99\": %.6g, \"min\": %.6g, \"max\": %.6g, \"mean\": %.6g",
+            median,
+            Percentile(samples->values, samples->count, 90.0),
+            Percentile(samples->values, samples->count, 99.0),
+            samples->values[0], samples->values[samples->count - 1],
+            sum / samples->count);
+    if (throughputScale > 0.0 && median > 0.0) {
+        fprintf(out, ", \"throughput\": %.6g, \"throughput_unit\": \"%s\"", throughputScale / median, throughputUnit);
+    }
+    for (int i = 0; i < metricCount; i++) {
+        fprintf(out, ", \"%s\": %.6g", metrics[i].name, metrics[i].value);
+    }
+    fprintf(out, "}");
+    fflush(out);
+    ctx->reported++;
+
+    fprintf(stderr, "%-40s median %10.4g %s\n", name, median, unit);
+}
+
+// --- Noise ---
+
+static void Bench_Noise(BenchContext* ctx) {
+    const int count = 4096;
+    const int trials = ctx->quick ? 16 : 64;
+    float* x = (float*)malloc(sizeof(float) * count);
+    float* y = (float*)malloc(sizeof(float) * count);
+    float* out = (float*)malloc(sizeof(float) * count);
+
+    // Same domain the chunks sample: unit-sphere directions times terrain frequency
+    srand(1234);
+    for (int i = 0; i < count; i++) {
+        x[i] = ((float)rand() / RAND_MAX * 2.0f - 1.0f) * BENCH_TERRAIN_FREQUENCY;
+        y[i] = ((float)rand() / RAND_MAX * 2.0f - 1.0f) * BENCH_TERRAIN_FREQUENCY;
+    }
+
+    BenchSamples samples;
+    volatile float sink = 0.0f;
+
+    if (Bench_ShouldRun(ctx, "noise/moon_terrain")) {
+        BenchSamples_Init(&samples);
+        for (int t = 0; t < trials; t++) {
+            double start = BenchTime();
+            for (int i = 0; i < count; i++) sink += MoonTerrain(x[i], y[i]);
+            BenchSamples_Add(&samples, (BenchTime() - start) * 1e9 / count);
+        }
+        Bench_Report(ctx, "noise/moon_terrain", "ns_per_sample", &samples, 1e9, "samples_per_s", NULL, 0);
+        BenchSamples_Free(&samples);
+    }
+
+    MoonTerrainKernel defaultKernel = MoonTerrainBatch_GetKernel();
+    for (int kernel = 0; kernel < MOON_TERRAIN_KERNEL_COUNT; kernel++) {
+        char name[96];
+        snprintf(name, sizeof(name), "noise/moon_terrain_batch/%s", MoonTerrainBatch_KernelName((MoonTerrainKernel)kernel));
+        if (!Bench_ShouldRun(ctx, name) || !MoonTerrainBatch_SetKernel((MoonTerrainKernel)kernel)) continue;
+
+        BenchSamples_Init(&samples);
+        for (int t = 0; t < trials; t++) {
+            double start = BenchTime();
+            MoonTerrainBatch(x, y, out, count);
+            BenchSamples_Add(&samples, (BenchTime() - start) * 1e9 / count);
+            sink += out[t];
+        }
+        BenchMetric metrics[] = { { "max_abs_error", MoonTerrainBatch_Validate((MoonTerrainKernel)kernel, x, y, count) } };
+        Bench_Report(ctx, name, "ns_per_sample", &samples, 1e9, "samples_per_s", metrics, 1);
+        BenchSamples_Free(&samples);
+    }
+    MoonTerrainBatch_SetKernel(defaultKernel);
+
+    // Chunk-shaped batches: the padded grid of a 32-cell tile at a few
+    // quadtree levels, with the default kernel. Octaves coarser than the
+    // grid spacing hash once per lattice cell, so deeper tiles run faster.
+    static const int levels[] = { 4, 8, 12 };
+    const int tileResolution = 32;
+    int tileStride = tileResolution + 3;
+    int tileSamples = tileStride * tileStride;
+    for (int l = 0; l < (int)(sizeof(levels) / sizeof(levels[0])); l++) {
+        char name[64];
+        snprintf(name, sizeof(name), "noise/moon_terrain_tile/level_%d", levels[l]);
+        if (!Bench_ShouldRun(ctx, name)) continue;
+
+        float tileSize = BENCH_TERRAIN_FREQUENCY / (float)(1 << levels[l]);
+        float spacing = tileSize / tileResolution;
+        BenchSamples_Init(&samples);
+        for (int t = 0; t < trials * 4; t++) {
+            float x0 = (float)rand() / RAND_MAX * (BENCH_TERRAIN_FREQUENCY - tileSize);
+            float y0 = (float)rand() / RAND_MAX * (BENCH_TERRAIN_FREQUENCY - tileSize);
+            for (int i = 0; i < tileSamples; i++) {
+                x[i] = x0 + (i % tileStride - 1) * spacing;
+                y[i] = y0 + (i / tileStride - 1) * spacing;
+            }
+            double start = BenchTime();
+            MoonTerrainBatch(x, y, out, tileSamples);
+            BenchSamples_Add(&samples, (BenchTime() - start) * 1e9 / tileSamples);
+            sink += out[0];
+        }
+        BenchMetric metrics[] = { { "level", (double)levels[l] } };
+        Bench_Report(ctx, name, "ns_per_sample", &samples, 1e9, "samples_per_s", metrics, 1);
+        BenchSamples_Free(&samples);
+    }
+
+    (void)sink;
+    free(x);
+    free(y);
+    free(out);
+}
+
+// --- Chunk generation ---
+
+// Chunk i of a grid on the +Z face, spread so each trial samples new terrain
+static void PlaceBenchChunk(Chunk* chunk, int i, int resolution) {
+    const int gridSize = 16;
+    float width = 2.0f * BENCH_RADIUS / gridSize;
+    int cell = i % (gridSize * gridSize);
+    chunk->offset = (Vector3){ -BENCH_RADIUS + (cell % gridSize) * width, -BENCH_RADIUS + (cell / gridSize) * width, 0.0f };
+    chunk->width = width;
+    chunk->height = width;
+    chunk->resolution = resolution;
+}
+
+static Chunk* CreateBenchChunk(int i, int resolution) {
+    Chunk* chunk = Chunk_Create((Vector3){ 0 }, 1.0f, 1.0f, BENCH_RADIUS, resolution, (Vector3){ 0 },
+                                MatrixTranslate(0.0f, 0.0f, BENCH_RADIUS),
+                                BENCH_TERRAIN_FREQUENCY, BENCH_TERRAIN_AMPLITUDE);
+    PlaceBenchChunk(chunk, i, resolution);
+    return chunk;
+}
+
+static void Bench_ChunkGenerate(BenchContext* ctx) {
+    static const int resolutions[] = { 16, 32, 64, 128 };
+
+    for (int r = 0; r < (int)(sizeof(resolutions) / sizeof(resolutions[0])); r++) {
+        int resolution = resolutions[r];
+        char name[64];
+        snprintf(name, sizeof(name), "chunk_generate/res_%d", resolution);
+        if (!Bench_ShouldRun(ctx, name)) continue;
+
+        // Keep each resolution around a second of work
+        int trials = resolution <= 32 ? 200 : (resolution == 64 ? 60 : 16);
+        if (ctx->quick) trials = trials / 4 + 1;
+
+        Chunk* chunk = CreateBenchChunk(0, resolution);
+        Chunk_GenerateAsync(chunk); // Warm up the per-thread workspace
+
+        BenchSamples samples;
+        BenchSamples_Init(&samples);
+        for (int t = 0; t < trials; t++) {
+            PlaceBenchChunk(chunk, t + 1, resolution);
+            double start = BenchTime();
+            Chunk_GenerateAsync(chunk);
+            BenchSamples_Add(&samples, (BenchTime() - start) * 1e3);
+        }
+
+        BenchMetric metrics[] = { { "vertices", (double)chunk->vertexCount } };
+        Bench_Report(ctx, name, "ms_per_chunk", &samples, 1e3, "chunks_per_s", metrics, 1);
+        BenchSamples_Free(&samples);
+        Chunk_Free(chunk);
+    }
+}
+
+// --- Quadtree update ---
+
+typedef enum {
+    CAMERA_PATH_DESCENT,  // From 3 radii out down to 200 m, straight toward the surface
+    CAMERA_PATH_ORBIT,    // Low orbit at 5 km altitude, a quarter of the way around
+    CAMERA_PATH_FLYOVER,  // Skimming at 300 m along a great circle
+    CAMERA_PATH_COUNT
+} CameraPath;
+
+static const char* const cameraPathNames[CAMERA_PATH_COUNT] = { "descent", "orbit", "flyover" };
+
+static Vector3 CameraPathPosition(CameraPath path, float t) {
+    Vector3 axis = Vector3Normalize((Vector3){ 1.0f, 1.0f, 1.0f });
+    switch (path) {
+        case CAMERA_PATH_DESCENT: {
+            // Exponential approach so every LOD level gets frames
+            float altitude = 2.0f * BENCH_RADIUS * powf(200.0f / (2.0f * BENCH_RADIUS), t);
+            return Vector3Scale(axis, BENCH_RADIUS + altitude);
+        }
+        case CAMERA_PATH_ORBIT: {
+            float angle = t * PI * 0.5f;
+            return (Vector3){ cosf(angle) * (BENCH_RADIUS + 5000.0f), 0.2f * BENCH_RADIUS, sinf(angle) * (BENCH_RADIUS + 5000.0f) };
+        }
+        case CAMERA_PATH_FLYOVER:
+        default: {
+            float angle = 0.3f + t * 0.05f; // About 87 km of ground track
+            Vector3 direction = { cosf(angle), sinf(angle) * 0.6f, sinf(angle) * 0.8f };
+            return Vector3Scale(Vector3Normalize(direction), BENCH_RADIUS + 300.0f);
+        }
+    }
+}
+
+static void Bench_Quadtree(BenchContext* ctx) {
+    const int frames = ctx->quick ? 150 : 600;
+
+    for (int path = 0; path < CAMERA_PATH_COUNT; path++) {
+        char updateName[64], leavesName[64];
+        snprintf(updateName, sizeof(updateName), "quadtree/update/%s", cameraPathNames[path]);
+        snprintf(leavesName, sizeof(leavesName), "quadtree/get_leaf_nodes/%s", cameraPathNames[path]);
+        bool runUpdate = Bench_ShouldRun(ctx, updateName);
+        bool runLeaves = Bench_ShouldRun(ctx, leavesName);
+        if (!runUpdate && !runLeaves) continue;
+
+        CubicQuadTree* tree = CubicQuadTree_Create(BENCH_RADIUS, BENCH_MIN_CELL_SIZE, BENCH_COMPARATOR,
+                                                   BENCH_RADIUS * BENCH_TERRAIN_AMPLITUDE * MOON_TERRAIN_MAX_ABS,
+                                                   (Vector3){ 0 });
+        QuadtreeLeafChanges changes;
+        QuadtreeLeafChanges_Init(&changes);
+
+        BenchSamples updateSamples, leafSamples;
+        BenchSamples_Init(&updateSamples);
+        BenchSamples_Init(&leafSamples);
+        double totalAdded = 0.0, totalRemoved = 0.0;
+        int maxLeaves = 0;
+
+        for (int frame = 0; frame < frames; frame++) {
+            Vector3 camera = CameraPathPosition((CameraPath)path, (float)frame / (frames - 1));
+
+            QuadtreeLeafChanges_Clear(&changes);
+            double start = BenchTime();
+            CubicQuadTree_Update(tree, camera, &changes);
+            double updated = BenchTime();
+
+            QuadtreeNode** leaves;
+            int leafCount;
+            CubicQuadTree_GetLeafNodes(tree, &leaves, &leafCount);
+            double listed = BenchTime();
+            free(leaves);
+
+            BenchSamples_Add(&updateSamples, (updated - start) * 1e3);
+            BenchSamples_Add(&leafSamples, (listed - updated) * 1e3);
+            totalAdded += changes.addedCount;
+            totalRemoved += changes.removedCount;
+            if (leafCount > maxLeaves) maxLeaves = leafCount;
+        }
+
+        BenchMetric metrics[] = {
+            { "max_leaves", (double)maxLeaves },
+            { "leaves_added", totalAdded },
+            { "leaves_removed", totalRemoved }
+        };
+        if (runUpdate) Bench_Report(ctx, updateName, "ms_per_frame", &updateSamples, 0.0, NULL, metrics, 3);
+        if (runLeaves) Bench_Report(ctx, leavesName, "ms_per_frame", &leafSamples, 0.0, NULL, metrics, 1);
+
+        BenchSamples_Free(&updateSamples);
+        BenchSamples_Free(&leafSamples);
+        QuadtreeLeafChanges_Free(&changes);
+        CubicQuadTree_Free(tree);
+    }
+}
+
+// --- Chunk map ---
+
+// splitmix64: spreads keys like real node IDs would be spread across levels
+static unsigned long long NextBenchKey(unsigned long long* state) {
+    unsigned long long z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static void Bench_ChunkMap(BenchContext* ctx) {
+    if (!Bench_ShouldRun(ctx, "chunk_map/")) return;
+
+    const int count = 16384; // Roughly the live leaf count of a close-up view
+    const int trials = ctx->quick ? 5 : 20;
+    unsigned long long* keys = (unsigned long long*)malloc(sizeof(unsigned long long) * count);
+
+    BenchSamples insertSamples, getSamples, removeSamples;
+    BenchSamples_Init(&insertSamples);
+    BenchSamples_Init(&getSamples);
+    BenchSamples_Init(&removeSamples);
+    volatile size_t sink = 0;
+
+    for (int t = 0; t < trials; t++) {
+        unsigned long long state = (unsigned long long)t;
+        for (int i = 0; i < count; i++) keys[i] = NextBenchKey(&state);
+
+        // Same initial capacity Planet_Create uses
+        ChunkMap* map = ChunkMap_Create(1024);
+
+        double start = BenchTime();
+        for (int i = 0; i < count; i++) ChunkMap_Insert(map, keys[i], (Chunk*)(size_t)(i + 1));
+        BenchSamples_Add(&insertSamples, (BenchTime() - start) * 1e9 / count);
+
+        start = BenchTime();
+        for (int i = 0; i < count; i++) sink += (size_t)ChunkMap_Get(map, keys[(i * 7919) % count]);
+        BenchSamples_Add(&getSamples, (BenchTime() - start) * 1e9 / count);
+
+        start = BenchTime();
+        for (int i = 0; i < count; i++) ChunkMap_Remove(map, keys[i]);
+        BenchSamples_Add(&removeSamples, (BenchTime() - start) * 1e9 / count);
+
+        ChunkMap_Destroy(map);
+    }
+
+    BenchMetric metrics[] = { { "entries", (double)count } };
+    if (Bench_ShouldRun(ctx, "chunk_map/insert")) Bench_Report(ctx, "chunk_map/insert", "ns_per_op", &insertSamples, 1e9, "ops_per_s", metrics, 1);
+    if (Bench_ShouldRun(ctx, "chunk_map/get")) Bench_Report(ctx, "chunk_map/get", "ns_per_op", &getSamples, 1e9, "ops_per_s", metrics, 1);
+    if (Bench_ShouldRun(ctx, "chunk_map/remove")) Bench_Report(ctx, "chunk_map/remove", "ns_per_op", &removeSamples, 1e9, "ops_per_s", metrics, 1);
+
+    (void)sink;
+    BenchSamples_Free(&insertSamples);
+    BenchSamples_Free(&getSamples);
+    BenchSamples_Free(&removeSamples);
+    free(keys);
+}
+
+// --- Thread pool ---
+
+static void GenerateBenchChunk(void* data) {
+    Chunk_GenerateAsync((Chunk*)data);
+}
+
+static void EmptyJob(void* data) {
+    (void)data;
+}
+
+static void Bench_ThreadPool(BenchContext* ctx) {
+    const int jobCount = ctx->quick ? 64 : 256;
+    const int trials = ctx->quick ? 3 : 7;
+    const int resolution = 32;
+    int hardwareThreads = ThreadPool_GetHardwareConcurrency();
+
+    // 1, 2, 4, ... up to twice the hardware threads (oversubscription shows too)
+    int threadCounts[16];
+    int configCount = 0;
+    int limit = hardwareThreads * 2 < 64 ? hardwareThreads * 2 : 64;
+    for (int threads = 1; threads <= limit && configCount < 15; threads *= 2) {
+        threadCounts[configCount++] = threads;
+    }
+    bool listed = false;
+    for (int c = 0; c < configCount; c++) listed = listed || threadCounts[c] == hardwareThreads;
+    if (!listed) threadCounts[configCount++] = hardwareThreads;
+
+    Chunk** chunks = (Chunk**)malloc(sizeof(Chunk*) * jobCount);
+    for (int i = 0; i < jobCount; i++) chunks[i] = CreateBenchChunk(i, resolution);
+
+    double singleThreadMedian = 0.0;
+    for (int c = 0; c < configCount; c++) {
+        int threads = threadCounts[c];
+        char name[64];
+        snprintf(name, sizeof(name), "thread_pool/chunk_jobs/threads_%d", threads);
+        if (!Bench_ShouldRun(ctx, name)) continue;
+
+        ThreadPool* pool = ThreadPool_Create(threads);
+        BenchSamples samples;
+        BenchSamples_Init(&samples);
+        for (int t = 0; t < trials; t++) {
+            double start = BenchTime();
+            for (int i = 0; i < jobCount; i++) {
+                ThreadPool_EnqueueWithPriority(pool, GenerateBenchChunk, chunks[i], (float)i);
+            }
+            ThreadPool_WaitAll(pool);
+            BenchSamples_Add(&samples, (BenchTime() - start) * 1e3);
+        }
+        ThreadPool_Destroy(pool);
+
+        qsort(samples.values, samples.count, sizeof(double), CompareDoubles);
+        double median = Percentile(samples.values, samples.count, 50.0);
+        if (threads == 1) singleThreadMedian = median;
+
+        BenchMetric metrics[] = {
+            { "threads", (double)threads },
+            { "jobs", (double)jobCount },
+            { "speedup", singleThreadMedian > 0.0 ? singleThreadMedian / median : 0.0 }
+        };
+        Bench_Report(ctx, name, "ms_per_batch", &samples, 1e3 * jobCount, "jobs_per_s", metrics, singleThreadMedian > 0.0 ? 3 : 2);
+        BenchSamples_Free(&samples);
+    }
+
+    // Queueing overhead alone: empty jobs through a pool of every hardware thread
+    if (Bench_ShouldRun(ctx, "thread_pool/empty_jobs")) {
+        const int emptyJobs = ctx->quick ? 20000 : 100000;
+        ThreadPool* pool = ThreadPool_Create(hardwareThreads);
+        BenchSamples samples;
+        BenchSamples_Init(&samples);
+        for (int t = 0; t < trials; t++) {
+            double start = BenchTime();
+            for (int i = 0; i < emptyJobs; i++) ThreadPool_Enqueue(pool, EmptyJob, NULL);
+            ThreadPool_WaitAll(pool);
+            BenchSamples_Add(&samples, (BenchTime() - start) * 1e9 / emptyJobs);
+        }
+        ThreadPool_Destroy(pool);
+
+        BenchMetric metrics[] = { { "threads", (double)hardwareThreads } };
+        Bench_Report(ctx, "thread_pool/empty_jobs", "ns_per_job", &samples, 1e9, "jobs_per_s", metrics, 1);
+        BenchSamples_Free(&samples);
+    }
+
+    for (int i = 0; i < jobCount; i++) Chunk_Free(chunks[i]);
+    free(chunks);
+}
+
+int main(int argc, char** argv) {
+    BenchContext ctx = { stdout, NULL, false, 0 };
+    const char* outputPath = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            ctx.quick = true;
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            ctx.filter = argv[++i];
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--filter <substring>] [--output <file>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (outputPath) {
+        ctx.out = fopen(outputPath, "w");
+        if (!ctx.out) {
+            fprintf(stderr, "planet_bench: cannot open %s\n", outputPath);
+            return 1;
+        }
+    }
+
+    fprintf(ctx.out, "{\n  \"schema\": 1,\n  \"quick\": %s,\n  \"hardware_threads\": %d,\n  \"noise_kernel\": \"%s\",\n  \"benchmarks\": [",
+            ctx.quick ? "true" : "false", ThreadPool_GetHardwareConcurrency(),
+            MoonTerrainBatch_KernelName(MoonTerrainBatch_GetKernel()));
+
+    Bench_Noise(&ctx);
+    Bench_ChunkGenerate(&ctx);
+    Bench_Quadtree(&ctx);
+    Bench_ChunkMap(&ctx);
+    Bench_ThreadPool(&ctx);
+
+    fprintf(ctx.out, "\n  ]\n}\n");
+    if (ctx.out != stdout) fclose(ctx.out);
+    return 0;
+}
@@ -0,0 +1,674 @@
+// Replays a recorded camera path through the full frame loop: planet
+// update, shadow cascades and the lit pass, as fast as the machine goes
+// (no frame cap, no vsync). Reports per-frame timings and how long new
+// leaves took to reach the GPU, as one JSON object on stdout (or --output),
+// so branches and thread counts can be compared run against run.
+//
+//   planet_replay --path <file> [--output <file>] [--frames-csv <file>]
+//                 [--checkpoint <n>] [--threads <n>] [--upload-ms <ms>]
+//                 [--offscreen] [--width <w>] [--height <h>] [--no-shadows]
+//                 [--cpu-draws] [--gpu-terrain] [--shaders <dir>] [--trace <file>]
+//
+// Every --checkpoint frames (default 60, 0 = only after the last frame) the
+// replay holds the camera still until generation is complete: no job left,
+// every leaf on the GPU, no fallback drawn and an unchanged tree. The time
+// that takes is reported per checkpoint and left out of the frame timings,
+// so every run reaches the same points of the path in the same state. With
+// --checkpoint 1 every frame settles, the LOD tree evolves the same way
+// each run, and the checkpoint tree hashes can be compared across runs.
+//
+// Camera paths are text, one frame per line (simple_planet records one
+// with R); lines starting with # are comments:
+//   time px py pz tx ty tz ux uy uz fovy
+// time is in seconds from the start, the camera velocity for prefetching
+// comes from consecutive frames. Needs a GL 3.3 context: --offscreen opens
+// a hidden window and renders into a texture of the same size.
+
+#include "noise.h"
+#include "planet_system.h"
+#include "shadow.h"
+#include <raylib.h>
+#include <raymath.h>
+#include "rlgl.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Same planet as examples/simple_planet.c
+#define REPLAY_RADIUS 1737400.0f
+#define REPLAY_MIN_CELL_SIZE 500.0f
+#define REPLAY_RESOLUTION 32
+#define REPLAY_TERRAIN_FREQUENCY 18.0f
+#define REPLAY_TERRAIN_AMPLITUDE 0.005f
+
+#define REPLAY_DEFAULT_CHECKPOINT 60
+#define REPLAY_MAX_SETTLE_ROUNDS 10000
+#define REPLAY_HISTOGRAM_BUCKETS 14 // Powers of two from 1 ms to 4096 ms, then the rest
+
+typedef struct ReplaySettings {
+    const char* pathFile;
+    const char* outputPath;
+    const char* framesCsvPath;
+    const char* tracePath;
+    const char* shaderDir;
+    int checkpoint;
+    int threads;
+    float uploadBudgetMs;
+    bool offscreen;
+    int width;
+    int height;
+    bool shadows;
+    bool instanced;
+    bool gpuTerrain;
+} ReplaySettings;
+
+// --- Camera path ---
+
+typedef struct ReplayFrame {
+    double time;
+    Vector3 position;
+    Vector3 target;
+    Vector3 up;
+    float fovy;
+} ReplayFrame;
+
+typedef struct ReplayPath {
+    ReplayFrame* frames;
+    int count;
+} ReplayPath;
+
+static bool ReplayPath_Load(ReplayPath* path, const char* file) {
+    FILE* in = fopen(file, "r");
+    if (!in) return false;
+
+    int capacity = 1024;
+    path->frames = (ReplayFrame*)malloc(sizeof(ReplayFrame) * capacity);
+    path->count = 0;
+    char line[512];
+    while (fgets(line, sizeof(line), in)) {
+        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') continue;
+        ReplayFrame frame;
+        int fields = sscanf(line, "%lf %f %f %f %f %f %f %f %f %f %f", &frame.time,
+                            &frame.position.x, &frame.position.y, &frame.position.z,
+                            &frame.target.x, &frame.target.y, &frame.target.z,
+                            &frame.up.x, &frame.up.y, &frame.up.z, &frame.fovy);
+        if (fields != 11) {
+            fprintf(stderr, "planet_replay: %s: skipping malformed line: %s", file, line);
+            continue;
+        }
+        if (path->count == capacity) {
+            capacity *= 2;
+            path->frames = (ReplayFrame*)realloc(path->frames, sizeof(ReplayFrame) * capacity);
+        }
+        path->frames[path->count++] = frame;
+    }
+    fclose(in);
+    return path->count > 0;
+}
+
+// --- Statistics ---
+
+typedef struct ReplaySamples {
+    double* values;
+    int count;
+    int capacity;
+} ReplaySamples;
+
+static void ReplaySamples_Init(ReplaySamples* samples) {
+    samples->count = 0;
+    samples->capacity = 256;
+    samples->values = (double*)malloc(sizeof(double) * samples->capacity);
+}
+
+static void ReplaySamples_Add(ReplaySamples* samples, double value) {
+    if (samples->count >= samples->capacity) {
+        samples->capacity *= 2;
+        samples->values = (double*)realloc(samples->values, sizeof(double) * samples->capacity);
+    }
+    samples->values[samples->count++] = value;
+}
+
+static void ReplaySamples_Free(ReplaySamples* samples) {
+    free(samples->values);
+    samples->values = NULL;
+    samples->count = samples->capacity = 0;
+}
+
+static int CompareDoubles(const void* a, const void* b) {
+    double da = *(const double*)a;
+    double db = *(const double*)b;
+    return (da > db) - (da < db);
+}
+
+// Nearest-rank percentile of sorted values
+static double Percentile(const double* sorted, int count, double p) {
+    int rank = (int)(p / 100.0 * count + 0.999999);
+    if (rank < 1) rank = 1;
+    if (rank > count) rank = count;
+    return sorted[rank - 1];
+}
+
+// Sorts the samples and writes their statistics as JSON members
+static void WriteSampleStats(FILE* out, ReplaySamples* samples) {
+    fprintf(out, "\"samples\": %d", samples->count);
+    if (samples->count == 0) return;
+    qsort(samples->values, samples->count, sizeof(double), CompareDoubles);
+    double sum = 0.0;
+    for (int i = 0; i < samples->count; i++) sum += samples->values[i];
+    fprintf(out, ", \"median\": %.6g, \"p90\": %.6g, \"p99\": %.6g, \"min\": %.6g, \"max\": %.6g, \"mean\": %.6g",
+            Percentile(samples->values, samples->count, 50.0),
+            Percentile(samples->values, samples->count, 90.0),
+            Percentile(samples->values, samples->count, 99.0),
+            samples->values[0], samples->values[samples->count - 1],
+            sum / samples->count);
+}
+
+// --- Chunk latency ---
+// A leaf whose chunk is not on the GPU when it enters the tree is tracked
+// until it is (or until it leaves the tree again, counted as dropped).
+// Measured at frame granularity, from the start of the frame that added it.
+// Leaves that enter already drawable (a merge taking back its parent mesh,
+// a finished prefetch) are not counted.
+
+typedef struct ReplayPendingLeaf {
+    ChunkId id;
+    Chunk* chunk;
+    double since;
+    int frame;
+} ReplayPendingLeaf;
+
+typedef struct ReplayLatency {
+    ReplayPendingLeaf* pending;
+    int pendingCount;
+    int pendingCapacity;
+    ChunkMap* tracked;       // Leaf ID -> chunk of the pending entries
+    ReplaySamples ms;
+    ReplaySamples frames;
+    int histogram[REPLAY_HISTOGRAM_BUCKETS];
+    int dropped;
+} ReplayLatency;
+
+static void ReplayLatency_Init(ReplayLatency* latency) {
+    latency->pendingCapacity = 1024;
+    latency->pendingCount = 0;
+    latency->pending = (ReplayPendingLeaf*)malloc(sizeof(ReplayPendingLeaf) * latency->pendingCapacity);
+    latency->tracked = ChunkMap_Create(1024);
+    ReplaySamples_Init(&latency->ms);
+    ReplaySamples_Init(&latency->frames);
+    memset(latency->histogram, 0, sizeof(latency->histogram));
+    latency->dropped = 0;
+}
+
+static void ReplayLatency_Free(ReplayLatency* latency) {
+    free(latency->pending);
+    ChunkMap_Destroy(latency->tracked);
+    ReplaySamples_Free(&latency->ms);
+    ReplaySamples_Free(&latency->frames);
+}
+
+static void ReplayLatency_Record(ReplayLatency* latency, double ms, int frames) {
+    ReplaySamples_Add(&latency->ms, ms);
+    ReplaySamples_Add(&latency->frames, frames);
+    int bucket = 0;
+    while (bucket < REPLAY_HISTOGRAM_BUCKETS - 1 && ms > (double)(1 << bucket)) bucket++;
+    latency->histogram[bucket]++;
+}
+
+// Called after each update with the time its frame started
+static void ReplayLatency_Update(ReplayLatency* latency, Planet* planet, double now, int frame) {
+    // Resolve first, so a leaf that left and came back this update is tracked anew
+    for (int i = 0; i < latency->pendingCount;) {
+        ReplayPendingLeaf* leaf = &latency->pending[i];
+        Chunk* current = ChunkMap_Get(planet->chunkMap, leaf->id);
+        if (current == leaf->chunk && Chunk_GetState(current) != CHUNK_STATE_UPLOADED) {
+            i++;
+            continue;
+        }
+        if (current == leaf->chunk) {
+            ReplayLatency_Record(latency, (now - leaf->since) * 1000.0, frame - leaf->frame);
+        } else {
+            latency->dropped++;
+        }
+        ChunkMap_Remove(latency->tracked, leaf->id);
+        *leaf = latency->pending[--latency->pendingCount];
+    }
+
+    for (int i = 0; i < planet->chunkMap->count; i++) {
+        ChunkMapEntry* entry = &planet->chunkMap->entries[i];
+        if (Chunk_GetState(entry->value) == CHUNK_STATE_UPLOADED) continue;
+        if (ChunkMap_Get(latency->tracked, entry->key) == entry->value) continue;
+        if (latency->pendingCount == latency->pendingCapacity) {
+            latency->pendingCapacity *= 2;
+            latency->pending = (ReplayPendingLeaf*)realloc(latency->pending,
+                                                           sizeof(ReplayPendingLeaf) * latency->pendingCapacity);
+        }
+        latency->pending[latency->pendingCount++] = (ReplayPendingLeaf){ entry->key, entry->value, now, frame };
+        ChunkMap_Insert(latency->tracked, entry->key, entry->value);
+    }
+}
+
+// --- Checkpoints ---
+
+typedef struct ReplayCheckpoint {
+    int frame;
+    int rounds;            // Updates it took to settle, -1 = gave up
+    double settleMs;
+    int leaves;
+    unsigned long long treeHash;
+} ReplayCheckpoint;
+
+static bool IsPlanetSettled(Planet* planet) {
+    if (planet->leafChanges.addedCount > 0 || planet->leafChanges.removedCount > 0) return false;
+    if (planet->fallbackMap->count > 0) return false;
+    if (ThreadPool_GetQueueSize(planet->threadPool) > 0 || ThreadPool_GetActiveThreads(planet->threadPool) > 0) return false;
+    if (ChunkUploadQueue_GetPendingCount(planet->uploadQueue) > 0) return false;
+    for (int i = 0; i < planet->chunkMap->count; i++) {
+        if (Chunk_GetState(planet->chunkMap->entries[i].value) != CHUNK_STATE_UPLOADED) return false;
+    }
+    return true;
+}
+
+// Order-independent hash of the leaf set
+static unsigned long long HashLeaves(const Planet* planet) {
+    unsigned long long hash = (unsigned long long)planet->chunkMap->count;
+    for (int i = 0; i < planet->chunkMap->count; i++) {
+        unsigned long long x = planet->chunkMap->entries[i].key + 0x9e3779b97f4a7c15ull;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        hash += x ^ (x >> 31);
+    }
+    return hash;
+}
+
+// Updates with the camera held still until generation is complete. Uploads
+// are unbudgeted meanwhile, so the state reached does not depend on how
+// fast the frames before ran.
+static ReplayCheckpoint Replay_Settle(PlanetSystem* system, Planet* planet, Vector3 position, int frame) {
+    ReplayCheckpoint checkpoint = { frame, -1, 0.0, 0, 0 };
+    float uploadBudgetMs = system->uploadBudgetMs;
+    system->uploadBudgetMs = 0.0f;
+
+    double start = GetTime();
+    for (int round = 1; round <= REPLAY_MAX_SETTLE_ROUNDS; round++) {
+        ThreadPool_WaitAll(system->threadPool);
+        // Upload everything finished before the tree updates: uploads feed
+        // the measured errors the split distances come from, so the tree
+        // must not depend on which uploads the timed frame got to
+        ChunkUploadQueue_Process(planet->uploadQueue, position, 0.0, 0);
+        PlanetSystem_Update(system, position);
+        if (IsPlanetSettled(planet)) {
+            checkpoint.rounds = round;
+            break;
+        }
+    }
+    checkpoint.settleMs = (GetTime() - start) * 1000.0;
+    checkpoint.leaves = planet->chunkMap->count;
+    checkpoint.treeHash = HashLeaves(planet);
+
+    system->uploadBudgetMs = uploadBudgetMs;
+    return checkpoint;
+}
+
+// --- Rendering ---
+// The passes of examples/simple_planet.c, without the HUD
+
+typedef struct ReplayRenderer {
+    Shader lightingShader;
+    Shader shadowShader;
+    Shader terrainShader;
+    int viewPosLoc;
+    int cascadeShadowMapsLoc;
+    int cascadeDistancesLoc;
+    int cascadeLightMatricesLocs[CASCADE_COUNT];
+    int shadowLightSpaceMatrixLoc;
+    CascadedShadowMap* csm;
+    unsigned int shadowedVersion; // Planet.drawnVersion the maps were rendered for
+    RenderTexture2D target; // Offscreen only
+    bool offscreen;
+} ReplayRenderer;
+
+static void ReplayRenderer_Init(ReplayRenderer* renderer, const ReplaySettings* settings, Planet* planet) {
+    renderer->lightingShader = LoadShader(TextFormat("%s/lighting.vs", settings->shaderDir),
+                                          TextFormat("%s/lighting.fs", settings->shaderDir));
+    renderer->shadowShader = LoadShader(TextFormat("%s/shadow.vs", settings->shaderDir),
+                                        TextFormat("%s/shadow.fs", settings->shaderDir));
+    if (renderer->lightingShader.id == 0 || renderer->shadowShader.id == 0) {
+        fprintf(stderr, "planet_replay: cannot load the shaders from %s\n", settings->shaderDir);
+    }
+    renderer->viewPosLoc = GetShaderLocation(renderer->lightingShader, "viewPos");
+    renderer->cascadeShadowMapsLoc = GetShaderLocation(renderer->lightingShader, "cascadeShadowMaps");
+    renderer->cascadeDistancesLoc = GetShaderLocation(renderer->lightingShader, "cascadeDistances");
+    for (int i = 0; i < CASCADE_COUNT; i++) {
+        renderer->cascadeLightMatricesLocs[i] = GetShaderLocation(renderer->lightingShader,
+                                                                  TextFormat("cascadeLightMatrices[%d]", i));
+    }
+    renderer->shadowLightSpaceMatrixLoc = GetShaderLocation(renderer->shadowShader, "lightSpaceMatrix");
+
+    Vector3 lightDir = Vector3Normalize((Vector3){ 0.5f, 0.8f, 0.3f });
+    SetShaderValue(renderer->lightingShader, GetShaderLocation(renderer->lightingShader, "lightDir"),
+                   &lightDir, SHADER_UNIFORM_VEC3);
+    renderer->csm = CSM_Create(lightDir, 4096);
+    renderer->shadowedVersion = planet->drawnVersion;
+
+    planet->lightingShader = renderer->lightingShader;
+    planet->surfaceColor = (Color){ 120, 120, 120, 255 };
+    planet->wireframeColor = (Color){ 80, 80, 80, 255 };
+    planet->instancedRendering = settings->instanced;
+
+    renderer->terrainShader = (Shader){ 0 };
+    if (settings->gpuTerrain) {
+        renderer->terrainShader = LoadShader(TextFormat("%s/terrain.vs", settings->shaderDir),
+                                             TextFormat("%s/terrain.fs", settings->shaderDir));
+        if (!Planet_SetTerrainShader(planet, renderer->terrainShader)) {
+            fprintf(stderr, "planet_replay: GPU terrain unavailable, generating chunks on the CPU\n");
+        }
+    }
+
+    renderer->offscreen = settings->offscreen;
+    if (renderer->offscreen) renderer->target = LoadRenderTexture(settings->width, settings->height);
+}
+
+static void ReplayRenderer_Free(ReplayRenderer* renderer) {
+    if (renderer->offscreen) UnloadRenderTexture(renderer->target);
+    CSM_Destroy(renderer->csm);
+    UnloadShader(renderer->lightingShader);
+    UnloadShader(renderer->shadowShader);
+    if (renderer->terrainShader.id != 0) UnloadShader(renderer->terrainShader);
+}
+
+// Shadow cascades and the lit pass of one frame, returns the triangles drawn
+static int ReplayRenderer_Draw(ReplayRenderer* renderer, Planet* planet, Camera3D camera, bool shadows) {
+    CascadedShadowMap* csm = renderer->csm;
+    if (shadows) {
+        float altitude = Vector3Distance(camera.position, planet->origin) - Planet_SampleHeight(planet, camera.position, NULL);
+        if (planet->drawnVersion != renderer->shadowedVersion) {
+            CSM_Invalidate(csm);
+            renderer->shadowedVersion = planet->drawnVersion;
+        }
+        CSM_UpdateCascades(csm, camera, planet->radius, REPLAY_TERRAIN_AMPLITUDE, altitude);
+        for (int i = 0; i < CASCADE_COUNT; i++) {
+            if (!CSM_IsCascadeDirty(csm, i)) continue;
+            SetShaderValueMatrix(renderer->shadowShader, renderer->shadowLightSpaceMatrixLoc, csm->cascades[i].lightSpaceMatrix);
+            BeginTextureMode(csm->cascades[i].shadowMap);
+                rlClearScreenBuffers();
+                rlViewport(0, 0, csm->shadowMapResolution, csm->shadowMapResolution);
+                Planet_DrawWithShaderCulled(planet, renderer->shadowShader, csm->cascades[i].lightSpaceMatrix);
+            EndTextureMode();
+        }
+    }
+
+    float cascadeDistances[CASCADE_COUNT];
+    int samplers[CASCADE_COUNT];
+    for (int i = 0; i < CASCADE_COUNT; i++) {
+        SetShaderValueMatrix(renderer->lightingShader, renderer->cascadeLightMatricesLocs[i], csm->cascades[i].lightSpaceMatrix);
+        cascadeDistances[i] = csm->cascades[i].splitDistance;
+        samplers[i] = 1 + i;
+    }
+    SetShaderValueV(renderer->lightingShader, renderer->cascadeDistancesLoc, cascadeDistances, SHADER_UNIFORM_FLOAT, CASCADE_COUNT);
+    SetShaderValueV(renderer->lightingShader, renderer->cascadeShadowMapsLoc, samplers, SHADER_UNIFORM_INT, CASCADE_COUNT);
+    for (int i = 0; i < CASCADE_COUNT; i++) {
+        rlActiveTextureSlot(1 + i);
+        rlEnableTexture(csm->cascades[i].shadowMap.depth.id);
+    }
+    SetShaderValue(renderer->lightingShader, renderer->viewPosLoc, &camera.position, SHADER_UNIFORM_VEC3);
+
+    int triangles;
+    BeginDrawing();
+        if (renderer->offscreen) BeginTextureMode(renderer->target);
+        ClearBackground(BLACK);
+        BeginMode3D(camera);
+            triangles = Planet_Draw(planet);
+        EndMode3D();
+        rlActiveTextureSlot(0);
+        if (renderer->offscreen) EndTextureMode();
+    EndDrawing();
+    return triangles;
+}
+
+// --- Report ---
+
+// Writes value as a quoted JSON string
+static void WriteJsonString(FILE* out, const char* value) {
+    fputc('"', out);
+    for (const unsigned char* c = (const unsigned char*)value; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            fprintf(out, "\\%c", *c);
+        } else if (*c < 0x20) {
+            fprintf(out, "\\u%04x", *c);
+        } else {
+            fputc(*c, out);
+        }
+    }
+    fputc('"', out);
+}
+
+static void WriteReport(FILE* out, const ReplaySettings* settings, int frameCount, double wallSeconds,
+                        ReplaySamples* updateMs, ReplaySamples* drawMs, ReplaySamples* frameMs,
+                        ReplayLatency* latency, const ReplayCheckpoint* checkpoints, int checkpointCount) {
+    fprintf(out, "{\n  \"schema\": 1,\n  \"path\": ");
+    WriteJsonString(out, settings->pathFile);
+    fprintf(out, ",\n  \"frames\": %d,\n", frameCount);
+    fprintf(out, "  \"threads\": %d,\n  \"hardware_threads\": %d,\n  \"noise_kernel\": ",
+            settings->threads, ThreadPool_GetHardwareConcurrency());
+    WriteJsonString(out, MoonTerrainBatch_KernelName(MoonTerrainBatch_GetKernel()));
+    fprintf(out, ",\n");
+    fprintf(out, "  \"checkpoint_interval\": %d,\n  \"upload_budget_ms\": %.6g,\n", settings->checkpoint, settings->uploadBudgetMs);
+    fprintf(out, "  \"offscreen\": %s,\n  \"width\": %d,\n  \"height\": %d,\n  \"shadows\": %s,\n  \"instanced\": %s,\n  \"gpu_terrain\": %s,\n",
+            settings->offscreen ? "true" : "false", settings->width, settings->height,
+            settings->shadows ? "true" : "false", settings->instanced ? "true" : "false",
+            settings->gpuTerrain ? "true" : "false");
+    fprintf(out, "  \"wall_seconds\": %.6g,\n  \"fps\": %.6g,\n", wallSeconds, wallSeconds > 0.0 ? frameCount / wallSeconds : 0.0);
+
+    const char* names[] = { "update", "draw", "frame" };
+    ReplaySamples* timings[] = { updateMs, drawMs, frameMs };
+    fprintf(out, "  \"timings\": [");
+    for (int i = 0; i < 3; i++) {
+        fprintf(out, "%s\n    {\"name\": ", i > 0 ? "," : "");
+        WriteJsonString(out, names[i]);
+        fprintf(out, ", \"unit\": \"ms\", ");
+        WriteSampleStats(out, timings[i]);
+        fprintf(out, "}");
+    }
+    fprintf(out, "\n  ],\n");
+
+    fprintf(out, "  \"chunk_latency\": {\"unit\": \"ms\", ");
+    WriteSampleStats(out, &latency->ms);
+    fprintf(out, ", \"dropped\": %d, \"histogram\": [", latency->dropped);
+    for (int i = 0; i < REPLAY_HISTOGRAM_BUCKETS; i++) {
+        if (i < REPLAY_HISTOGRAM_BUCKETS - 1) {
+            fprintf(out, "%s{\"le\": %d, \"count\": %d}", i > 0 ? ", " : "", 1 << i, latency->histogram[i]);
+        } else {
+            fprintf(out, ", {\"le\": null, \"count\": %d}", latency->histogram[i]);
+        }
+    }
+    fprintf(out, "]},\n  \"chunk_latency_frames\": {\"unit\": \"frames\", ");
+    WriteSampleStats(out, &latency->frames);
+    fprintf(out, "},\n");
+
+    fprintf(out, "  \"checkpoints\": [");
+    for (int i = 0; i < checkpointCount; i++) {
+        const ReplayCheckpoint* checkpoint = &checkpoints[i];
+        fprintf(out, "%s\n    {\"frame\": %d, \"settled\": %s, \"rounds\": %d, \"settle_ms\": %.6g, \"leaves\": %d, \"tree_hash\": \"%016llx\"}",
+                i > 0 ? "," : "", checkpoint->frame, checkpoint->rounds >= 0 ? "true" : "false",
+                checkpoint->rounds, checkpoint->settleMs, checkpoint->leaves, checkpoint->treeHash);
+    }
+    fprintf(out, "\n  ]\n}\n");
+}
+
+static void PrintUsage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s --path <file> [--output <file>] [--frames-csv <file>] [--checkpoint <n>]\n"
+            "       [--threads <n>] [--upload-ms <ms>] [--offscreen] [--width <w>] [--height <h>]\n"
+            "       [--no-shadows] [--cpu-draws] [--gpu-terrain] [--shaders <dir>] [--trace <file>]\n",
+            program);
+}
+
+int main(int argc, char** argv) {
+    ReplaySettings settings = { 0 };
+    settings.shaderDir = "shaders";
+    settings.checkpoint = REPLAY_DEFAULT_CHECKPOINT;
+    settings.uploadBudgetMs = 2.0f;
+    settings.width = 1280;
+    settings.height = 720;
+    settings.shadows = true;
+    settings.instanced = true;
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--path") == 0 && hasValue) {
+            settings.pathFile = argv[++i];
+        } else if (strcmp(argv[i], "--output") == 0 && hasValue) {
+            settings.outputPath = argv[++i];
+        } else if (strcmp(argv[i], "--frames-csv") == 0 && hasValue) {
+            settings.framesCsvPath = argv[++i];
+        } else if (strcmp(argv[i], "--trace") == 0 && hasValue) {
+            settings.tracePath = argv[++i];
+        } else if (strcmp(argv[i], "--shaders") == 0 && hasValue) {
+            settings.shaderDir = argv[++i];
+        } else if (strcmp(argv[i], "--checkpoint") == 0 && hasValue) {
+            settings.checkpoint = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && hasValue) {
+            settings.threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--upload-ms") == 0 && hasValue) {
+            settings.uploadBudgetMs = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--width") == 0 && hasValue) {
+            settings.width = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--height") == 0 && hasValue) {
+            settings.height = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--offscreen") == 0) {
+            settings.offscreen = true;
+        } else if (strcmp(argv[i], "--no-shadows") == 0) {
+            settings.shadows = false;
+        } else if (strcmp(argv[i], "--cpu-draws") == 0) {
+            settings.instanced = false;
+        } else if (strcmp(argv[i], "--gpu-terrain") == 0) {
+            settings.gpuTerrain = true;
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (!settings.pathFile || settings.width <= 0 || settings.height <= 0 || settings.checkpoint < 0) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    ReplayPath path;
+    if (!ReplayPath_Load(&path, settings.pathFile)) {
+        fprintf(stderr, "planet_replay: cannot read a camera path from %s\n", settings.pathFile);
+        return 1;
+    }
+    FILE* out = stdout;
+    if (settings.outputPath && !(out = fopen(settings.outputPath, "w"))) {
+        fprintf(stderr, "planet_replay: cannot open %s\n", settings.outputPath);
+        return 1;
+    }
+    FILE* framesCsv = NULL;
+    if (settings.framesCsvPath) {
+        framesCsv = fopen(settings.framesCsvPath, "w");
+        if (!framesCsv) {
+            fprintf(stderr, "planet_replay: cannot open %s\n", settings.framesCsvPath);
+            return 1;
+        }
+        fprintf(framesCsv, "frame,update_ms,draw_ms,frame_ms,leaves,triangles,queue_depth,uploads_pending\n");
+    }
+
+    // raylib logs to stdout, where the report goes. No frame cap and no
+    // vsync: SetTargetFPS is never called and FLAG_VSYNC_HINT is not set.
+    SetTraceLogLevel(LOG_ERROR);
+    SetConfigFlags(settings.offscreen ? FLAG_WINDOW_HIDDEN : 0);
+    InitWindow(settings.width, settings.height, "planet_replay");
+    rlSetClipPlanes(.1, 100000000.0);
+
+    // Through a PlanetSystem for the worker count: same pool and budgets
+    // code as a scene with several planets
+    PlanetSystem* system = PlanetSystem_Create(settings.threads);
+    system->uploadBudgetMs = settings.uploadBudgetMs;
+    system->screenHeight = settings.height;
+    Planet* planet = PlanetSystem_AddPlanet(system, REPLAY_RADIUS, REPLAY_MIN_CELL_SIZE, REPLAY_RESOLUTION,
+                                            (Vector3){ 0 }, REPLAY_TERRAIN_FREQUENCY, REPLAY_TERRAIN_AMPLITUDE);
+    settings.threads = system->threadPool->threadCount;
+
+    ReplayRenderer renderer;
+    ReplayRenderer_Init(&renderer, &settings, planet);
+
+    ReplaySamples updateMs, drawMs, frameMs;
+    ReplaySamples_Init(&updateMs);
+    ReplaySamples_Init(&drawMs);
+    ReplaySamples_Init(&frameMs);
+    ReplayLatency latency;
+    ReplayLatency_Init(&latency);
+    int checkpointCapacity = (settings.checkpoint > 0 ? path.count / settings.checkpoint : 0) + 1;
+    ReplayCheckpoint* checkpoints = (ReplayCheckpoint*)malloc(sizeof(ReplayCheckpoint) * checkpointCapacity);
+    int checkpointCount = 0;
+
+    // Settled start, so the first frames do not time the face roots
+    Replay_Settle(system, planet, path.frames[0].position, 0);
+
+    double wallSeconds = 0.0;
+    for (int i = 0; i < path.count; i++) {
+        const ReplayFrame* frame = &path.frames[i];
+        Camera3D camera = { frame->position, frame->target, frame->up, frame->fovy, CAMERA_PERSPECTIVE };
+        Vector3 velocity = { 0 };
+        if (i > 0 && frame->time > path.frames[i - 1].time) {
+            velocity = Vector3Scale(Vector3Subtract(frame->position, path.frames[i - 1].position),
+                                    (float)(1.0 / (frame->time - path.frames[i - 1].time)));
+        }
+
+        double start = GetTime();
+        system->fovy = frame->fovy;
+        PlanetSystem_UpdateWithVelocity(system, camera.position, velocity);
+        double updated = GetTime();
+        int triangles = ReplayRenderer_Draw(&renderer, planet, camera, settings.shadows);
+        double end = GetTime();
+
+        ReplayLatency_Update(&latency, planet, start, i);
+        ReplaySamples_Add(&updateMs, (updated - start) * 1000.0);
+        ReplaySamples_Add(&drawMs, (end - updated) * 1000.0);
+        ReplaySamples_Add(&frameMs, (end - start) * 1000.0);
+        wallSeconds += end - start;
+        if (framesCsv) {
+            fprintf(framesCsv, "%d,%.4f,%.4f,%.4f,%d,%d,%d,%d\n", i, (updated - start) * 1000.0, (end - updated) * 1000.0,
+                    (end - start) * 1000.0, planet->chunkMap->count, triangles,
+                    ThreadPool_GetQueueSize(system->threadPool), ChunkUploadQueue_GetPendingCount(planet->uploadQueue));
+        }
+
+        bool last = i == path.count - 1;
+        if (last || (settings.checkpoint > 0 && (i + 1) % settings.checkpoint == 0)) {
+            ReplayCheckpoint checkpoint = Replay_Settle(system, planet, camera.position, i);
+            // Leaves the wait finished are timed up to its start, not through it
+            ReplayLatency_Update(&latency, planet, GetTime() - checkpoint.settleMs / 1000.0, i);
+            checkpoints[checkpointCount++] = checkpoint;
+            if (checkpoint.rounds < 0) {
+                fprintf(stderr, "planet_replay: frame %d did not settle within %d updates\n", i, REPLAY_MAX_SETTLE_ROUNDS);
+            }
+        }
+    }
+
+    WriteReport(out, &settings, path.count, wallSeconds, &updateMs, &drawMs, &frameMs, &latency, checkpoints, checkpointCount);
+    fprintf(stderr, "%d frames in %.2f s (%.1f fps), frame median %.3f ms p99 %.3f ms, chunk latency median %.1f ms (%d leaves)\n",
+            path.count, wallSeconds, wallSeconds > 0.0 ? path.count / wallSeconds : 0.0,
+            Percentile(frameMs.values, frameMs.count, 50.0), Percentile(frameMs.values, frameMs.count, 99.0),
+            latency.ms.count > 0 ? Percentile(latency.ms.values, latency.ms.count, 50.0) : 0.0, latency.ms.count);
+
+    if (settings.tracePath) {
+        const PlanetStats* stats = Planet_GetStats(planet);
+        if (!PlanetStats_WriteChromeTrace(settings.tracePath, &stats, 1)) {
+            fprintf(stderr, "planet_replay: no trace written (needs PLANET_ENABLE_STATS)\n");
+        }
+    }
+
+    free(checkpoints);
+    ReplayLatency_Free(&latency);
+    ReplaySamples_Free(&updateMs);
+    ReplaySamples_Free(&drawMs);
+    ReplaySamples_Free(&frameMs);
+    free(path.frames);
+    if (framesCsv) fclose(framesCsv);
+    if (out != stdout) fclose(out);
+
+    ReplayRenderer_Free(&renderer);
+    PlanetSystem_Free(system);
+    CloseWindow();
+    return 0;
+}